@@ -5,6 +5,8 @@
 -- luacheck: globals git
 git = {}
 
+local internal = import_internal -- luacheck: no global
+
 
 
 --------------------------------------------------------------------------------
@@ -86,22 +88,6 @@ local function scan_upwards(dir, scan_func)
     until not dir
 end
 
--- Reads the first line from a file.
-local function read_from_file(fileName, as_num)
-    local file = io.open(fileName, 'r')
-    if not file then return nil end
-
-    local line = file:read()
-    file:close()
-    if not line or line == "" then return nil end
-
-    if as_num then
-        line = tonumber(line)
-        if not line or line == 0 then return nil end
-    end
-    return line
-end
-
 -- Loads the specified git config file and returns a table with the parsed
 -- content.  The returned table has a <code>:get(section, param)</code>
 -- function to make it convenient to look up config parameters.
@@ -146,6 +132,16 @@ local function load_ini(fileName)
     return data
 end
 
+-- Returns the state of the repo as read directly from the files in the git
+-- dir (HEAD, refs, config, etc), or nil if it can't be read that way.
+-- The state is cached until any of the files change, so this is cheap to call
+-- repeatedly.
+local function get_repo_state(git_dir)
+    git_dir = git_dir or git.getgitdir()
+    if not git_dir then return end
+    return internal._get_git_state(git_dir)
+end
+
 local function get_branch_slow(git_dir)
     local flags = ""
     if type(git_dir) == "string" then
@@ -418,33 +414,19 @@ function git.getbranch(git_dir, fast)
     git_dir = git_dir or git.getgitdir()
     if not git_dir then return end
 
-    -- If git directory not found then we're probably outside of repo or
-    -- something went wrong.  The same is when head_file is nil.
-    local head_file = io.open(path.join(git_dir, "HEAD"))
-    if not head_file then return end
-
-    local HEAD = head_file:read()
-    head_file:close()
-
-    -- If HEAD isn't present, something is wrong.
-    if not HEAD then return end
-
-    -- If HEAD matches branch expression, then we're on named branch
-    -- otherwise it is a detached commit.
-    local branch_name = HEAD:match("ref: refs/heads/(.+)")
+    -- If the state can't be read then we're probably outside of a repo or
+    -- something went wrong.
+    local state = get_repo_state(git_dir)
+    if not state then return end
 
-    if os.getenv("CLINK_DEBUG_GIT_REFTABLE") then
-        branch_name = ".invalid"
-    end
-
-    local detached
-    if branch_name ~= ".invalid" or fast then
-        if not branch_name then
-            branch_name = HEAD:sub(1, 7)
-            detached = true
-        end
-    else
+    -- In a repo with a reftable the branch can only be found by running git.
+    local branch_name, detached
+    if state.reftable or os.getenv("CLINK_DEBUG_GIT_REFTABLE") then
+        if fast then return ".invalid" end
         branch_name, detached = get_branch_slow(git_dir)
+    else
+        branch_name = state.branch
+        detached = state.detached
     end
 
     if detached then
@@ -500,6 +482,12 @@ end
 function git.getconflictstatus()
     if git._fake then return git._fake.status and git._fake.status.untracked end
 
+    local git_dir = git.getgitdir()
+    local conflicts = git_dir and internal._get_git_conflicts(git_dir)
+    if conflicts then
+        return conflicts > 0
+    end
+
     local file = io.popen(git.makecommand("diff --name-only --diff-filter=U"))
     if not file then return false end
 
@@ -532,6 +520,14 @@ function git.getaheadbehind()
         ahead = git._fake.status and git._fake.status.ahead
         behind = git._fake.status and git._fake.status.behind
     else
+        -- When HEAD matches its upstream, there's no need to run git.  The
+        -- upstream is only known when the remote uses the default fetch
+        -- refspec; otherwise this falls back to running git.
+        local state = get_repo_state()
+        if state and state.HEAD and state.HEAD == state.upstream_head then
+            return "0", "0"
+        end
+
         local file = io.popen(git.makecommand("rev-list --count --left-right @{upstream}...HEAD"))
         if not file then return end
 
@@ -639,96 +635,22 @@ function git.getstatus(no_untracked, include_submodules)
     local file = io.popen(git.makecommand("status "..flags.." --branch --porcelain=v2"))
     if not file then return end
 
-    local w_add, w_mod, w_del, w_con, w_unt = 0, 0, 0, 0, 0
-    local s_add, s_mod, s_del, s_ren = 0, 0, 0, 0
-    local t_add, t_mod, t_del = 0, 0, 0
-    local onlystaged = 0
-
-    local hasheader
-    local header = {}
-
+    -- The output is parsed natively in large chunks.  In a coroutine, yield
+    -- periodically so the prompt stays responsive while reading huge output.
     local _, ismain = coroutine.running()
-
-    local tick = os.clock()
-    local processed = 0
-    for line in file:lines() do
-        if line:find("^# ") then
-            local k, v = line:match("^#%sbranch%.([^%s]+)%s(.*)$")
-            if k then
-                hasheader = true
-                header[k] = v
-            end
-        else
-            local mode = string.match(line, "^([uU12?]) ")
-            if mode == "?" then
-                w_unt = w_unt + 1
-            elseif mode == "u" or mode == "U" then
-                w_con = w_con + 1
-            elseif mode == "1" or mode == "2" then
-                local kindStaged, kind = string.match(line, "^(.)(.) ", 3)
-                local added, modified, deleted
-
-                local w = true
-                if kind == "A" or kind == "C" then
-                    w_add = w_add + 1
-                    added = true
-                elseif kind == "M" or kind == "T" or kind == "R" then
-                    w_mod = w_mod + 1
-                    modified = true
-                elseif kind == "D" then
-                    w_del = w_del + 1
-                    deleted = true
-                else
-                    w = false
-                end
-
-                if kindStaged == "A" or kindStaged == "C" then
-                    s_add = s_add + 1
-                    if not w then
-                        added = true
-                    end
-                elseif kindStaged == "M" or kindStaged == "T" then
-                    s_mod = s_mod + 1
-                    if not w then
-                        modified = true
-                    end
-                elseif kindStaged == "D" then
-                    s_del = s_del + 1
-                    if not w then
-                        deleted = true
-                    end
-                elseif kindStaged == "R" then
-                    s_ren = s_ren + 1
-                    if not w then
-                        modified = true
-                    end
-                end
-
-                if added then
-                    t_add = t_add + 1
-                elseif deleted then
-                    t_del = t_del + 1
-                elseif modified then
-                    t_mod = t_mod + 1
-                end
-
-                if kindStaged ~= "." and kind == "." then
-                    onlystaged = onlystaged + 1
-                end
-            end
-        end
-        if not ismain then
-            processed = processed + 1
-            if processed > 10 and os.clock() - tick > 0.015 then
-                coroutine.yield()
-                processed = 0
-                tick = os.clock()
-            end
-        end
+    local parser = internal._make_git_status_parser()
+    while not parser:read(file, (not ismain) and 0.015 or nil) do
+        coroutine.yield()
     end
     file:close()
 
-    if not hasheader then return end
+    local c = parser:getcounts()
+    local w_add, w_mod, w_del, w_con, w_unt = c.w_add, c.w_modify, c.w_delete, c.w_conflict, c.w_untracked
+    local s_add, s_mod, s_del, s_ren = c.s_add, c.s_modify, c.s_delete, c.s_rename
+    local t_add, t_mod, t_del = c.t_add, c.t_modify, c.t_delete
+    local onlystaged = c.onlystaged
+
+    if not c.hasheader then return end
 
     local working
     local staged
@@ -759,16 +681,16 @@ function git.getstatus(no_untracked, include_submodules)
     end
 
     local status = {}
-    local oid = header.oid and header.oid:find("^[0-9a-fA-F]") and header.oid:sub(1, 7) or header.oid
+    local oid = c.oid and c.oid:find("^[0-9a-fA-F]") and c.oid:sub(1, 7) or c.oid
     status.dirty = (working or staged) and true or nil
-    status.unpublished = not header.upstream
-    status.ahead = nilwhenzero(header.ab and header.ab:match("%+(%d+)"))
-    status.behind = nilwhenzero(header.ab and header.ab:match("%-(%d+)"))
-    status.detached = (header.head == "(detached)") and true or nil
-    status.branch = status.detached and oid or header.head or nil
+    status.unpublished = not c.upstream
+    status.ahead = nilwhenzero(tostring(c.ahead))
+    status.behind = nilwhenzero(tostring(c.behind))
+    status.detached = (c.head == "(detached)") and true or nil
+    status.branch = status.detached and oid or c.head or nil
     status.submodule = submodule
-    status.HEAD = header.oid
-    status.upstream = header.upstream
+    status.HEAD = c.oid
+    status.upstream = c.upstream
     status.working = working
     status.staged = staged
     status.total = total
@@ -823,51 +745,13 @@ function git.getaction()
         end
     end
 
-    local git_dir = git.getgitdir()
-    if not git_dir then return end
-
-    if os.isdir(path.join(git_dir, "rebase-merge")) then
-        local action
-        -- FUTURE?: local b = read_from_file(path.join(git_dir, "rebase-merge/head-name"))
-        local step = read_from_file(path.join(git_dir, "rebase-merge/msgnum"), true--[[as_num]])
-        local num_steps = read_from_file(path.join(git_dir, "rebase-merge/end"), true--[[as_num]])
-        if os.isfile(path.join(git_dir, "rebase-merge/interactive") ) then
-            action = "rebase-i"
-        else
-            action = "rebase-m"
-        end
-        if step and num_steps then
-            return action, step, num_steps
-        else
-            return action
-        end
-    end
-
-    if os.isdir(path.join(git_dir, "rebase-apply")) then
-        local action
-        local step = read_from_file(path.join(git_dir, "rebase-apply/next"), true--[[as_num]])
-        local num_steps = read_from_file(path.join(git_dir, "rebase-apply/last"), true--[[as_num]])
-        if os.isfile(path.join(git_dir, "rebase-apply/rebasing")) then
-            -- FUTURE?: local b = read_from_file(path.join(git_dir, "rebase-apply/head-name"))
-            action = "rebase"
-        elseif os.isfile(path.join(git_dir, "rebase-apply/applying")) then
-            action = "am"
-        else
-            action = "am/rebase"
-        end
-        if step and num_steps then
-            return action, step, num_steps
-        else
-            return action
-        end
-    elseif os.isfile(path.join(git_dir, "MERGE_HEAD")) then
-        return "merging"
-    elseif os.isfile(path.join(git_dir, "CHERRY_PICK_HEAD")) then
-        return "cherry-picking"
-    elseif os.isfile(path.join(git_dir, "REVERT_HEAD")) then
-        return "reverting"
-    elseif os.isfile(path.join(git_dir, "BISECT_LOG")) then
-        return "bisecting"
+    local state = get_repo_state()
+    if not state or not state.action then
+        return
+    elseif state.step and state.total then
+        return state.action, state.step, state.total
+    else
+        return state.action
     end
 end
 
@@ -880,6 +764,11 @@ end
 function git.hasstash()
     if git._fake then return (git._fake.stashes or 0) > 0 end
 
+    local state = get_repo_state()
+    if state and not state.reftable then
+        return state.stashes > 0
+    end
+
     local file = io.popen(git.makecommand("rev-parse --verify refs/stash"))
     if not file then return end
 
@@ -896,6 +785,11 @@ end
 function git.getstashcount()
     if git._fake then return git._fake.stashes or 0 end
 
+    local state = get_repo_state()
+    if state and not state.reftable then
+        return state.stashes
+    end
+
     local file = io.popen(git.makecommand("rev-list --walk-reflogs --count refs/stash"))
     if not file then return end
 
@@ -25,6 +25,7 @@ local active_clinkprompt = ""           -- Currently active .clinkprompt module,
 local clinkprompt_exports = nil         -- Export table from active .clinkprompt module (may be nil).
 local clinkprompt_module = ""           -- Lowercase copy of active_clinkprompt, for module comparisons.
 local clinkprompt_dependson = {}        -- Index of clinkprompt module(s) the current module depends on (e.g. "flexprompt").
+local prompt_filter_uncacheable = nil   -- Set when the current prompt filter's result is still pending.
 -- luacheck: pop
 
 --------------------------------------------------------------------------------
@@ -84,6 +85,167 @@ local function log_cost(tick, filter, func_name)
     end
 end
 
+--------------------------------------------------------------------------------
+local function log_hit(filter, func_name)
+    local tname = "cost"..func_name
+    local cost = filter[tname]
+    if not cost then
+        cost = { last=0, total=0, num=0, peak=0 }
+        filter[tname] = cost
+    end
+
+    cost.hits = (cost.hits or 0) + 1
+end
+
+
+
+--------------------------------------------------------------------------------
+-- Prompt filter result caching.
+--
+-- A prompt filter can set a cachekeys field to a table listing what its output
+-- depends on.  When none of them have changed and the input prompt string is
+-- the same as last time, the filter's previous result is reused instead of
+-- calling the filter function again.
+
+--------------------------------------------------------------------------------
+local function get_git_stamp(name)
+    local git_dir = git.getgitdir()
+    if not git_dir then
+        return ""
+    end
+    return git_dir.."|"..(internal._get_file_stamp(path.join(git_dir, name)) or "")
+end
+
+--------------------------------------------------------------------------------
+-- Committing doesn't touch HEAD; it updates the branch ref that HEAD points
+-- to, which is either a loose ref file or an entry in packed-refs.  So include
+-- those stamps as well.
+local function get_githead_stamp()
+    local stamp = get_git_stamp("HEAD")
+    if stamp == "" then
+        return stamp
+    end
+
+    local git_dir = git.getgitdir()
+    local file = io.open(path.join(git_dir, "HEAD"))
+    local line = file and file:read("*l")
+    if file then
+        file:close()
+    end
+
+    local ref = line and line:match("^ref:%s*(.-)%s*$")
+    if ref then
+        local common_dir = git.getcommondir() or git_dir
+        stamp = stamp.."|"..(internal._get_file_stamp(path.join(common_dir, ref)) or "")
+        stamp = stamp.."|"..(internal._get_file_stamp(path.join(common_dir, "packed-refs")) or "")
+    end
+    return stamp
+end
+
+--------------------------------------------------------------------------------
+local cache_key_resolvers = {
+    cwd = function() return os.getcwd() end,
+    errorlevel = function() return tostring(os.geterrorlevel()) end,
+    githead = get_githead_stamp,
+    gitindex = function() return get_git_stamp("index") end,
+}
+
+--------------------------------------------------------------------------------
+local function get_segment_cache_key(filter, prompt, values)
+    local keys = filter.cachekeys
+    if type(keys) ~= "table" or not values then
+        return
+    end
+
+    local parts = { prompt or "" }
+    for _, k in ipairs(keys) do
+        local v
+        if type(k) == "function" then
+            v = k(filter)
+        elseif type(k) == "string" then
+            -- Resolve each key at most once per prompt filtering pass, since
+            -- multiple filters may depend on the same keys.
+            v = values[k]
+            if v == nil then
+                local resolver = cache_key_resolvers[k]
+                local env = not resolver and k:match("^env:(.+)$")
+                if resolver then
+                    v = resolver()
+                elseif env then
+                    v = os.getenv(env) or ""
+                end
+                values[k] = v
+            end
+        end
+        if v == nil then
+            -- Unknown keys make the result uncacheable, rather than risk
+            -- showing a stale result.
+            return
+        end
+        table.insert(parts, tostring(v))
+    end
+    return table.concat(parts, "\0")
+end
+
+--------------------------------------------------------------------------------
+local function call_filter_func(filter, func, func_name, prompt, values, timings)
+    local key = get_segment_cache_key(filter, prompt, values)
+    local cache = filter._segment_cache
+    if key and cache then
+        local segment = cache[func_name]
+        if segment and segment.key == key then
+            log_hit(filter, func_name)
+            if timings then
+                table.insert(timings, { filter=filter, func=func, func_name=func_name, hit=true })
+            end
+            return segment.filtered, segment.onwards
+        end
+    end
+
+    prompt_filter_uncacheable = nil
+
+    local tick = os.clock()
+    local filtered, onwards = func(filter, prompt)
+    log_cost(tick, filter, func_name)
+
+    if timings then
+        table.insert(timings, { filter=filter, func=func, func_name=func_name, elapsed=filter["cost"..func_name].last })
+    end
+
+    if key and not prompt_filter_uncacheable then
+        cache = cache or {}
+        filter._segment_cache = cache
+        cache[func_name] = { key=key, filtered=filtered, onwards=onwards }
+    end
+
+    return filtered, onwards
+end
+
+--------------------------------------------------------------------------------
+local function log_timings(timings)
+    local total = 0
+    local hits = 0
+    for _, t in ipairs(timings) do
+        if t.hit then
+            hits = hits + 1
+        else
+            total = total + t.elapsed
+        end
+    end
+
+    log.info(string.format("PROMPT FILTERS %.2f ms, %d of %d cached", total, hits, #timings))
+    for _, t in ipairs(timings) do
+        local func = t.filter._deprecated_filter or t.func
+        local info = debug.getinfo(func, 'S')
+        local src = info.short_src..":"..info.linedefined
+        if t.hit then
+            log.info(string.format("    cached      %s %s", t.func_name, src))
+        else
+            log.info(string.format("    %7.2f ms  %s %s", t.elapsed, t.func_name, src))
+        end
+    end
+end
+
 --------------------------------------------------------------------------------
 local function ipairs_active(list)
     local i = 0
@@ -127,6 +289,11 @@ local function _do_filter_prompt(type, prompt, rprompt, line, cursor, final)
     local filter_func_name = type.."filter"
     local right_filter_func_name = type.."rightfilter"
 
+    -- Only the normal prompt is cached; transient prompt filters can depend
+    -- on the final input line, and only run once per input line anyway.
+    local values = (not transient and settings.get("prompt.cache") ~= false) and {} or nil
+    local timings = settings.get("debug.log_prompt") and {} or nil
+
     local pre = os.getenv("CLINK_PROMPT_PREFIX") or ""
     local suf = os.getenv("CLINK_PROMPT_SUFFIX") or ""
     local rpre = os.getenv("CLINK_RPROMPT_PREFIX") or ""
@@ -145,9 +312,7 @@ local function _do_filter_prompt(type, prompt, rprompt, line, cursor, final)
             local func
             func = filter[filter_func_name]
             if func or #type == 0 then
-                local tick = os.clock()
-                filtered, onwards = func(filter, prompt)
-                log_cost(tick, filter, filter_func_name)
+                filtered, onwards = call_filter_func(filter, func, filter_func_name, prompt, values, timings)
                 if filtered ~= nil then
                     prompt = filtered
                 elseif transient and onwards == false then
@@ -160,9 +325,7 @@ local function _do_filter_prompt(type, prompt, rprompt, line, cursor, final)
             if onwards ~= false then
                 func = filter[right_filter_func_name]
                 if func then
-                    local tick = os.clock()
-                    filtered, onwards = func(filter, rprompt)
-                    log_cost(tick, filter, right_filter_func_name)
+                    filtered, onwards = call_filter_func(filter, func, right_filter_func_name, rprompt, values, timings)
                     if filtered ~= nil then
                         rprompt = filtered
                     elseif transient and onwards == false then
@@ -214,6 +377,10 @@ local function _do_filter_prompt(type, prompt, rprompt, line, cursor, final)
         rret = nil
     end
 
+    if timings then
+        log_timings(timings)
+    end
+
     if settings.get("debug.log_prompt") then
         local plog = prompt or ""
         local rplog = rprompt or ""
@@ -300,6 +467,12 @@ end
 --- further prompt filtering by also returning false.  See
 --- <a href="#customisingtheprompt">Customizing the Prompt</a> for more
 --- information.
+---
+--- Starting in v1.9.33, a prompt filter can set a <code>cachekeys</code> field
+--- to a table listing what its output depends on, so that its previous result
+--- can be reused when nothing has changed.  See
+--- <a href="#promptfiltercaching">Caching Prompt Filter Results</a> for more
+--- information.
 --- -show:  local foo_prompt = clink.promptfilter(80)
 --- -show:  function foo_prompt:filter(prompt)
 --- -show:  &nbsp;   -- Insert the date at the beginning of the prompt.
@@ -411,9 +584,10 @@ local function print_filter_src(t, type)
         end
         for _,entry in ipairs (tsub) do
             if entry.cost then
-                clink.print(string.format("        %s  %4u ms %4u ms %4u ms",
+                local hits = entry.cost.hits and string.format("  %u cached", entry.cost.hits) or ""
+                clink.print(string.format("        %s  %4u ms %4u ms %4u ms%s",
                         pad_string(entry.src, longest),
-                        entry.cost.last, entry.cost.total / entry.cost.num, entry.cost.peak))
+                        entry.cost.last, entry.cost.total / math.max(entry.cost.num, 1), entry.cost.peak, hits))
             else
                 clink.print(string.format("        %s", entry.src))
             end
@@ -655,6 +829,11 @@ function clink.promptcoroutine(func, cookie)
         end
     end
 
+    -- A filter whose result is still pending must not be cached.
+    if not entry.done then
+        prompt_filter_uncacheable = true
+    end
+
     -- Return the result, if any.
     return entry.result
 end
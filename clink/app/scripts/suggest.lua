@@ -30,6 +30,9 @@ local function test_dupe(seen, entry, line, add)
     end
 end
 
+--------------------------------------------------------------------------------
+local _strategy_setting = settings.gethandle("autosuggest.strategy")
+
 --------------------------------------------------------------------------------
 local function get_limit_history()
     local num = settings.get("suggestionlist.num_history")
@@ -185,7 +188,7 @@ local function _do_suggest(line, lines, matches) -- luacheck: no unused
     -- Protected call to suggesters.
     local impl = function(line, matches) -- luacheck: ignore 432
         local ran = {}
-        local strategy = settings.get("autosuggest.strategy"):explode()
+        local strategy = settings.get(_strategy_setting):explode()
 
         if limit then
             -- Move "history" to the front so it always shows up first in the
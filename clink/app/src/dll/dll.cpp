@@ -74,8 +74,12 @@ static void shutdown_clink()
     shutdown_task_manager(true/*final*/);
     shutdown_recognizer();
 
+    // This runs while the DLL is unloading.
     if (logger* logger = logger::get())
+    {
+        file_logger::set_unloading();
         delete logger;
+    }
 
     delete app_context::get();
 }
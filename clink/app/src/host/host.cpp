@@ -16,8 +16,10 @@
 #include <core/log.h>
 #include <core/debugheap.h>
 #include <core/callstack.h>
+#include <core/trace.h>
 #include <core/assert_improved.h>
 #include <lib/doskey.h>
+#include <lib/alias_cache.h>
 #include <lib/match_generator.h>
 #include <lib/line_editor.h>
 #include <lib/line_editor_integration.h>
@@ -80,6 +82,16 @@ setting_str g_customprompt(
     "supersedes this setting.",
     "");
 
+static setting_bool g_prompt_cache(
+    "prompt.cache",
+    "Reuse unchanged prompt filter results",
+    "Prompt filters can declare what their output depends on (for example the\n"
+    "current directory, the git HEAD, environment variables, or the exit code of\n"
+    "the previous command).  When enabled, a prompt filter whose dependencies and\n"
+    "input haven't changed reuses its previous result instead of running again.\n"
+    "Prompt filters that don't declare dependencies always run.",
+    true);
+
 enum prompt_spacing { normal, compact, sparse, MAX };
 static setting_enum s_prompt_spacing(
     "prompt.spacing",
@@ -173,6 +185,16 @@ static setting_bool g_debug_log_prompt(
     "the log file.",
     false);
 
+static setting_str g_debug_trace_file(
+    "debug.trace_file",
+    "Write a trace of where time is spent",
+    "When set to a file name, Clink records how long key input, match generation,\n"
+    "classification, hints, suggestions, prompt filters, and display take, and\n"
+    "writes them to the file in Chrome trace-event format at the end of each\n"
+    "edit line.  The CLINK_TRACE_FILE environment variable overrides this.\n"
+    "WARNING:  Only set this for diagnostic purposes, and only temporarily!",
+    "");
+
 
 #ifdef DEBUG
 static setting_bool g_debug_heap_stats(
@@ -339,6 +361,21 @@ static void write_line_feed()
     WriteConsoleW(handle, L"\n", 1, &written, nullptr);
 }
 
+//------------------------------------------------------------------------------
+// Aliases are snapshotted across lines, and a change is normally noticed
+// because the total size of the aliases changes.  A doskey command could
+// redefine an alias without changing the size, so after a line that might run
+// doskey the snapshot is reloaded.
+static bool may_change_aliases(const char* line)
+{
+    for (const char* walk = line; *walk; ++walk)
+    {
+        if (_strnicmp(walk, "doskey", 6) == 0)
+            return true;
+    }
+    return false;
+}
+
 //------------------------------------------------------------------------------
 bool is_sparse_prompt_spacing()
 {
@@ -733,6 +770,12 @@ bool host::edit_line(const char* prompt, const char* rprompt, str_base& out, boo
 
     path::refresh_pathext();
 
+    if (m_aliases_may_change)
+    {
+        m_aliases_may_change = false;
+        alias_snapshot::invalidate();
+    }
+
     os::cwd_restorer cwd;
 
     // Load Clink's settings.  The load function handles deferred load for
@@ -746,6 +789,12 @@ bool host::edit_line(const char* prompt, const char* rprompt, str_base& out, boo
     settings::load(settings_file.c_str(), default_settings_file.c_str());
     reset_keyseq_to_name_map();
 
+    // Tracing is enabled by the setting or by the environment variable.
+    str<> trace_file;
+    if (!os::get_env("CLINK_TRACE_FILE", trace_file))
+        trace_file = g_debug_trace_file.get();
+    trace::enable(!trace_file.empty());
+
     // Set up the string comparison mode.
     static_assert(str_compare_scope::exact == 0, "g_ignore_case values must match str_compare_scope values");
     static_assert(str_compare_scope::caseless == 1, "g_ignore_case values must match str_compare_scope values");
@@ -1382,6 +1431,14 @@ force_reload_lua:
         }
     }
 
+    if (ret && may_change_aliases(out.c_str()))
+        m_aliases_may_change = true;
+    for (const auto& queued : queue)
+    {
+        if (may_change_aliases(queued.m_line.c_str()))
+            m_aliases_may_change = true;
+    }
+
     // If the line is a directory, rewrite the line to invoke the CD command to
     // change to the directory.
     if (ret && autostart.empty() && intercepted == intercept_result::none)
@@ -1399,6 +1456,9 @@ force_reload_lua:
     m_prompt = nullptr;
     m_rprompt = nullptr;
 
+    if (trace::is_enabled() && !trace::write_json(trace_file.c_str()))
+        ERR("Unable to write trace file '%s'", trace_file.c_str());
+
 #ifdef DEBUG
     if (!was_signaled && clink_is_signaled())
         g_suppress_signal_assert = true;
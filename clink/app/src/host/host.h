@@ -83,5 +83,6 @@ private:
     bool            m_skip_provide_line = false;
     bool            m_suppress_title = false;
     bool            m_bypass_dequeue = false;
+    bool            m_aliases_may_change = false;
     dequeue_flags   m_bypass_flags = dequeue_flags::none;
 };
@@ -15,6 +15,7 @@
 #include <core/settings.h>
 #include <core/log.h>
 #include <lib/rl_integration.h>
+#include <lua/lua_startup_profile.h>
 #include <terminal/terminal_helpers.h>
 
 #include <vector>
@@ -138,6 +139,7 @@ void host_lua::load_scripts()
     load_scripts(script_path.c_str());
     m_prev_script_path = script_path.c_str();
     clear_force_reload_scripts();
+    log_lua_startup_profile();
 
     // Set the script paths so argmatchers can be loaded from completion dirs.
     {
@@ -253,6 +255,7 @@ void host_lua::load_script(const char* path, unsigned& num_loaded, unsigned& num
             continue;
 #endif
 
+        lua_startup_timer timer(buffer.c_str());
         if (m_state.do_file(buffer.c_str()))
             num_loaded++;
         else
@@ -117,8 +117,9 @@ do_help:
     // prompt filtering is available in this context (cuz it's not!).
     const char* const script =
     "local old_get = settings.get\n"
+    "local async_handle = settings.gethandle('prompt.async')\n"
     "settings.get = function(name, descriptive)\n"
-    "   if name == 'prompt.async' then return false\n"
+    "   if name == 'prompt.async' or name == async_handle then return false\n"
     "   else return old_get(name, descriptive)\n"
     "   end\n"
     "end";
@@ -9,6 +9,7 @@
 #include <core/settings.h>
 #include <core/os.h>
 #include <core/path.h>
+#include <core/session_stats.h>
 #include <getopt.h>
 
 //------------------------------------------------------------------------------
@@ -261,6 +262,46 @@ int32 clink_info(int32 argc, char** argv)
     s.format("%-*s : %s\n", spacing, "keyboard layout", layout_name.c_str());
     print_info_line(h, s.c_str());
 
+    // Stats published by the session.
+    session_stats stats;
+    if (read_session_stats(context->get_id(), stats))
+    {
+        const uint32 lookups = stats.cmdcache_hits + stats.cmdcache_misses;
+        if (lookups)
+        {
+            printf("%-*s : %u%% hit rate (%u hits, %u misses, %u expired, %u invalidated)\n",
+                   spacing, "command cache", uint32(uint64(stats.cmdcache_hits) * 100 / lookups),
+                   stats.cmdcache_hits, stats.cmdcache_misses, stats.cmdcache_expired, stats.cmdcache_invalidated);
+            printf("%-*s     %u entries, %u bytes, %u evicted\n",
+                   spacing, "", stats.cmdcache_entries, stats.cmdcache_bytes, stats.cmdcache_evicted);
+        }
+
+        // Keystroke latency, as p50 / p95 / p99 / max.
+        bool labeled = false;
+        for (uint32 i = 0; i < uint32(latency_stage::max); ++i)
+        {
+            const latency_histogram& h = stats.latency[i];
+            if (!h.count)
+                continue;
+
+            const char* label = labeled ? "" : "latency (ms)";
+            printf("%-*s %c %-16s %8.2f %8.2f %8.2f %8.2f   (p50 p95 p99 max, %u samples)\n",
+                   spacing, label, labeled ? ' ' : ':', get_latency_stage_name(latency_stage(i)),
+                   get_latency_percentile(h, 50) / 1000.0, get_latency_percentile(h, 95) / 1000.0,
+                   get_latency_percentile(h, 99) / 1000.0, get_latency_max(h) / 1000.0, h.total);
+            labeled = true;
+        }
+
+        // Word collection, per key.
+        const uint32 keys = stats.latency[uint32(latency_stage::input)].total;
+        if (keys && stats.wordcollect_tokenised)
+        {
+            printf("%-*s : %.2f tokenised, %.2f reused per key\n",
+                   spacing, "word collection", double(stats.wordcollect_tokenised) / keys,
+                   double(stats.wordcollect_reused) / keys);
+        }
+    }
+
     str<> state_dir;
     context->get_state_dir(state_dir);
     if (os::get_path_type(state_dir.c_str()) == os::path_type_file)
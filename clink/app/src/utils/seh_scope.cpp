@@ -6,12 +6,24 @@
 #include "utils/app_context.h"
 #include "version.h"
 
+#include <core/log.h>
 #include <core/str.h>
 #include <terminal/terminal_helpers.h>
 
 //------------------------------------------------------------------------------
 static thread_local int32 s_filter = 0;
 
+//------------------------------------------------------------------------------
+// Gets queued log lines into the log file before the process goes away.  This
+// allocates and takes locks, so it happens after the core dump is written, so
+// that the dump reflects the state at the time of the exception even if this
+// fails.
+static void flush_log(const EXCEPTION_POINTERS* info)
+{
+    LOG("Unhandled exception 0x%08x at 0x%p", info->ExceptionRecord->ExceptionCode, info->ExceptionRecord->ExceptionAddress);
+    logger::flush(true/*crashing*/);
+}
+
 //------------------------------------------------------------------------------
 static LONG WINAPI exception_filter(EXCEPTION_POINTERS* info)
 {
@@ -76,6 +88,8 @@ static LONG WINAPI exception_filter(EXCEPTION_POINTERS* info)
     fputs(ok ? "\n!!! ...ok" : "\n!!! ...failed", stderr);
     fputs("\n!!!", stderr);
 
+    flush_log(info);
+
     // Output some useful modules' base addresses
     buffer.format("\n!!! Clink: 0x%p", GetModuleHandle(CLINK_DLL));
     fputs(buffer.c_str(), stderr);
@@ -112,6 +126,8 @@ static LONG WINAPI exception_filter(EXCEPTION_POINTERS* info)
 
     fputs("\n\nPress Enter to exit...", stderr);
     fgetc(stdin);
+#else
+    flush_log(info);
 #endif // _MSC_VER
 
     return EXCEPTION_CONTINUE_SEARCH;
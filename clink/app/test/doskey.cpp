@@ -10,6 +10,7 @@
 #include <core/base.h>
 #include <core/settings.h>
 #include <core/str.h>
+#include <lib/alias_cache.h>
 #include <lib/doskey.h>
 #include <lua/lua_match_generator.h>
 #include <lua/lua_script_loader.h>
@@ -656,3 +657,62 @@ TEST_CASE("Doskey issue 773")
 
     doskey.remove_alias("dir");
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("Doskey alias snapshot")
+{
+    doskey doskey("shell");
+    doskey.add_alias("alias", "text");
+
+    str<> text;
+    alias_snapshot& snapshot = alias_snapshot::get(L"shell");
+    snapshot.validate();
+    REQUIRE(snapshot.find("alias", text));
+    REQUIRE(text.equals("text"));
+    REQUIRE(snapshot.find("ALIAS", text));
+    REQUIRE(!snapshot.find("other", text));
+
+    // Validating again without changes keeps the generation.
+    const uint32 generation = snapshot.get_generation();
+    snapshot.validate();
+    REQUIRE(snapshot.get_generation() == generation);
+
+    // Redefining an alias is seen even though the size is the same.
+    doskey.add_alias("alias", "TEXT");
+    snapshot.validate();
+    REQUIRE(snapshot.find("alias", text));
+    REQUIRE(text.equals("TEXT"));
+    REQUIRE(snapshot.get_generation() != generation);
+
+    // Changes made directly through the console are seen via the size.
+    AddConsoleAliasW(const_cast<wchar_t*>(L"other"), const_cast<wchar_t*>(L"more"), const_cast<wchar_t*>(L"shell"));
+    snapshot.validate();
+    REQUIRE(snapshot.find("other", text));
+    REQUIRE(text.equals("more"));
+
+    // Expansion uses the same snapshot.
+    doskey_alias alias;
+    doskey.resolve("other", alias);
+    REQUIRE(alias);
+    REQUIRE(alias.next(text));
+    REQUIRE(text.equals("more"));
+
+    // Compiled macros are reused, and discarded when the alias changes.
+    doskey.add_alias("swap", "x $2 $1$Gout");
+    for (int32 i = 0; i < 2; ++i)
+    {
+        doskey.resolve("swap a b", alias);
+        REQUIRE(alias.next(text));
+        REQUIRE(text.equals("x b a>out"));
+    }
+    doskey.add_alias("swap", "y $* $$1");
+    doskey.resolve("swap a b", alias);
+    REQUIRE(alias.next(text));
+    REQUIRE(text.equals("y a b $1"));
+
+    doskey.remove_alias("swap");
+    doskey.remove_alias("other");
+    doskey.remove_alias("alias");
+    snapshot.validate();
+    REQUIRE(!snapshot.find("alias", text));
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "env_fixture.h"
+
+#include <core/settings.h>
+#include <lua/lua_script_loader.h>
+#include <lua/lua_state.h>
+#include <lua/prompt.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Prompt filter cache")
+{
+    static const char* env_desc[] = {
+        "CACHETEST_VALUE",  "one",
+        nullptr
+    };
+
+    env_fixture env(env_desc);
+
+    lua_state lua;
+    prompt_filter prompt_filter(lua);
+    lua_load_script(lua, app, prompt);
+
+    const char* script = "\
+    _calls = 0\
+    _rcalls = 0\
+    \
+    local pf = clink.promptfilter(1)\
+    pf.cachekeys = { 'env:CACHETEST_VALUE' }\
+    function pf:filter(prompt)\
+        _calls = _calls + 1\
+        return prompt..os.getenv('CACHETEST_VALUE')\
+    end\
+    function pf:rightfilter(rprompt)\
+        _rcalls = _rcalls + 1\
+        return rprompt..'R'\
+    end\
+    \
+    local uncached = clink.promptfilter(2)\
+    function uncached:filter(prompt)\
+        _uncached = (_uncached or 0) + 1\
+        return prompt..'!'\
+    end\
+    \
+    function expect_calls(calls, rcalls, uncached)\
+        if _calls ~= calls or _rcalls ~= rcalls or _uncached ~= uncached then\
+            error(string.format('calls %d, rcalls %d, uncached %d', _calls, _rcalls, _uncached or 0))\
+        end\
+    end\
+    ";
+
+    REQUIRE_LUA_DO_STRING(lua, script);
+
+    str<> out;
+    str<> rout;
+
+    SECTION("Unchanged")
+    {
+        REQUIRE(prompt_filter.filter(">", "<", out, rout));
+        REQUIRE(out.equals(">one!"));
+        REQUIRE(rout.equals("<R"));
+        REQUIRE_LUA_DO_STRING(lua, "expect_calls(1, 1, 1)");
+
+        REQUIRE(prompt_filter.filter(">", "<", out, rout));
+        REQUIRE(out.equals(">one!"));
+        REQUIRE(rout.equals("<R"));
+        REQUIRE_LUA_DO_STRING(lua, "expect_calls(1, 1, 2)");
+    }
+
+    SECTION("Dependency changed")
+    {
+        REQUIRE(prompt_filter.filter(">", "<", out, rout));
+        REQUIRE(out.equals(">one!"));
+
+        REQUIRE_LUA_DO_STRING(lua, "os.setenv('CACHETEST_VALUE', 'two')");
+        REQUIRE(prompt_filter.filter(">", "<", out, rout));
+        REQUIRE(out.equals(">two!"));
+        REQUIRE_LUA_DO_STRING(lua, "expect_calls(2, 1, 2)");
+    }
+
+    SECTION("Input changed")
+    {
+        REQUIRE(prompt_filter.filter(">", "<", out, rout));
+        REQUIRE(prompt_filter.filter("$", "<", out, rout));
+        REQUIRE(out.equals("$one!"));
+        REQUIRE_LUA_DO_STRING(lua, "expect_calls(2, 1, 2)");
+    }
+
+    SECTION("Disabled")
+    {
+        settings::find("prompt.cache")->set("false");
+
+        REQUIRE(prompt_filter.filter(">", "<", out, rout));
+        REQUIRE(prompt_filter.filter(">", "<", out, rout));
+        REQUIRE(out.equals(">one!"));
+        REQUIRE_LUA_DO_STRING(lua, "expect_calls(2, 2, 2)");
+
+        settings::find("prompt.cache")->set();
+    }
+}
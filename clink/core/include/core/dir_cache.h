@@ -0,0 +1,93 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "str.h"
+
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+struct dir_listing_entry
+{
+    uint32          name;           // Offset of the name in the arena.
+    uint32          short_name;     // Offset of the 8.3 name in the arena.
+    uint16          name_len;
+    uint16          short_len;      // 0 if there's no 8.3 name.
+    uint32          attr;
+    uint32          reparse_tag;
+    uint64          size;
+    FILETIME        accessed;
+    FILETIME        modified;
+    FILETIME        created;
+};
+
+//------------------------------------------------------------------------------
+// Snapshot of the entries in a directory.  The names are stored in one arena,
+// and a listing never changes once it's been loaded, so it can be shared by
+// any number of globbers on any thread.
+class dir_listing
+{
+    friend class dir_cache;
+
+public:
+    uint32          count() const { return uint32(m_entries.size()); }
+    const dir_listing_entry& get(uint32 index) const { return m_entries[index]; }
+    const wchar_t*  get_name(const dir_listing_entry& entry) const { return m_arena.data() + entry.name; }
+    const wchar_t*  get_short_name(const dir_listing_entry& entry) const { return m_arena.data() + entry.short_name; }
+    bool            matches_prefix(const dir_listing_entry& entry, const wchar_t* prefix, uint32 len) const;
+    void            get_find_data(uint32 index, WIN32_FIND_DATAW& data) const;
+
+private:
+    bool            load(const wchar_t* dir);
+    str_moveable    m_key;
+    std::vector<dir_listing_entry> m_entries;
+    std::vector<wchar_t> m_arena;
+    FILETIME        m_dir_mtime = {};
+    DWORD           m_loaded_tick = 0;
+    DWORD           m_used_tick = 0;
+};
+
+//------------------------------------------------------------------------------
+struct dir_cache_stats
+{
+    uint32          listings = 0;       // Listings currently cached.
+    uint32          entries = 0;        // Entries in the cached listings.
+    uint32          hits = 0;
+    uint32          misses = 0;
+    uint32          invalidated = 0;    // Listings reloaded because they changed or expired.
+    uint32          evicted = 0;
+};
+
+//------------------------------------------------------------------------------
+// Cache of directory listings, keyed by full directory path.  A listing is
+// reused until the directory's last write time changes (which happens when
+// entries are added, removed, or renamed), or until it's old enough that the
+// sizes, times, and attributes of the entries may be stale.  When the total
+// number of cached entries gets too large, the least recently used listings
+// are evicted.
+//
+// Whether globbers use the cache is controlled by the files.cache setting.
+// Settings may only be read on the main thread, so code that globs on another
+// thread should call is_enabled() beforehand and pass the result to the
+// globber.
+class dir_cache
+{
+public:
+    std::shared_ptr<const dir_listing> get_listing(const char* dir);
+    void            clear();
+    void            get_stats(dir_cache_stats& stats) const;
+
+    static dir_cache& get();
+    static bool     is_enabled();
+
+    static const DWORD c_max_age = 30 * 1000;
+    static const uint32 c_max_entries = 250000;
+
+private:
+    void            evict(uint32 needed);
+    mutable SRWLOCK m_lock = SRWLOCK_INIT;
+    std::vector<std::shared_ptr<dir_listing>> m_listings;
+    dir_cache_stats m_stats;
+};
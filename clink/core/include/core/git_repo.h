@@ -0,0 +1,80 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "os.h"
+#include "str.h"
+
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// State of a git repo that can be read directly from the files in the git dir,
+// without running git.exe.  Working tree status (dirty files, etc) is not
+// included, since that requires comparing the index against the working tree.
+// Conflicts are only counted by git_repo_cache::get_conflicts(), since that
+// reads the whole index.
+struct git_repo_state
+{
+    str_moveable    branch;             // Branch name, or short hash if detached.
+    str_moveable    head;               // HEAD commit id, or empty in a new repo.
+    str_moveable    upstream;           // Upstream name (e.g. "origin/main"), or empty.
+    str_moveable    upstream_head;      // Upstream commit id, or empty if unknown.
+    str_moveable    action;             // Action in progress (see git.getaction()), or empty.
+    uint32          step = 0;           // Current step of the action, or 0.
+    uint32          total = 0;          // Total steps of the action, or 0.
+    uint32          stashes = 0;
+    int32           conflicts = -1;     // Conflicted files, or -1 if unknown.
+    bool            detached = false;
+    bool            reftable = false;   // Refs are in a reftable, so the branch is unknown.
+};
+
+//------------------------------------------------------------------------------
+struct git_file_stamp : public os::file_stamp
+{
+    wstr_moveable   path;
+};
+
+//------------------------------------------------------------------------------
+struct git_repo_stats
+{
+    uint32          repos = 0;          // Repos currently cached.
+    uint32          hits = 0;
+    uint32          misses = 0;
+    uint32          invalidated = 0;    // States reloaded because a file changed.
+};
+
+//------------------------------------------------------------------------------
+// Cache of git repo states, keyed by git dir.  Each state remembers the size
+// and last write time of every file that was consulted while reading it
+// (including files that didn't exist), and is reused until any of them change.
+// The conflict count is cached separately, so that only callers that need it
+// read the index (which git rewrites often, e.g. whenever git status runs).
+class git_repo_cache
+{
+public:
+    std::shared_ptr<const git_repo_state> get_state(const char* git_dir);
+    int32           get_conflicts(const char* git_dir);
+    void            clear();
+    void            get_stats(git_repo_stats& stats) const;
+
+    static git_repo_cache& get();
+
+    static const uint32 c_max_repos = 16;
+
+private:
+    std::shared_ptr<const git_repo_state> lookup(const char* git_dir, bool conflicts);
+
+    struct entry
+    {
+        str_moveable    key;            // Prefixed with '?' for conflicts.
+        std::shared_ptr<const git_repo_state> state;
+        std::vector<git_file_stamp> stamps;
+        DWORD           used_tick;
+    };
+
+    mutable SRWLOCK m_lock = SRWLOCK_INIT;
+    std::vector<entry> m_entries;
+    git_repo_stats  m_stats;
+};
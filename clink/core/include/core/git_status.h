@@ -0,0 +1,61 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "str.h"
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Aggregated counts from "git status --branch --porcelain=v2" output.  These
+// are the same counts git.getstatus() reports.
+struct git_status_counts
+{
+    // Branch headers.
+    bool            has_header = false;
+    str_moveable    oid;                // "# branch.oid".
+    str_moveable    head;               // "# branch.head".
+    str_moveable    upstream;           // "# branch.upstream".
+    uint32          ahead = 0;          // From "# branch.ab".
+    uint32          behind = 0;         // From "# branch.ab".
+
+    // Working tree changes.
+    uint32          w_add = 0;
+    uint32          w_modify = 0;
+    uint32          w_delete = 0;
+    uint32          w_conflict = 0;
+    uint32          w_untracked = 0;
+
+    // Staged changes.
+    uint32          s_add = 0;
+    uint32          s_modify = 0;
+    uint32          s_delete = 0;
+    uint32          s_rename = 0;
+
+    // Files counted uniquely across working and staged changes.
+    uint32          t_add = 0;
+    uint32          t_modify = 0;
+    uint32          t_delete = 0;
+
+    uint32          only_staged = 0;
+    uint32          lines = 0;
+};
+
+//------------------------------------------------------------------------------
+// Parses porcelain v2 status output incrementally.  Output can be fed in chunks
+// of any size; lines that span chunks are reassembled.
+class git_status_parser
+{
+public:
+    void            feed(const char* data, uint32 len);
+    void            finish();
+    const git_status_counts& get_counts() const { return m_counts; }
+
+private:
+    void            parse_line(const char* line, uint32 len);
+    void            parse_header(const char* line, uint32 len);
+    void            parse_change(const char* xy);
+    git_status_counts m_counts;
+    std::vector<char> m_partial;
+};
@@ -5,6 +5,10 @@
 
 #include "str.h"
 
+#include <memory>
+
+class dir_listing;
+
 //------------------------------------------------------------------------------
 class globber
 {
@@ -20,6 +24,7 @@ public:
     };
 
                         globber(const char* pattern);
+                        globber(const char* pattern, bool use_cache);
                         ~globber();
     void                files(bool state)       { m_files = state; }
     void                directories(bool state) { m_directories = state; }
@@ -34,9 +39,14 @@ public:
 private:
                         globber(const globber&) = delete;
     void                operator = (const globber&) = delete;
+    bool                use_listing(const char* pattern);
+    bool                next_listing_entry();
     void                next_file();
     WIN32_FIND_DATAW    m_data;
     HANDLE              m_handle;
+    std::shared_ptr<const dir_listing> m_listing;
+    uint32              m_listing_index = 0;
+    wstr<32>            m_prefix;
     str<280>            m_root;
     bool                m_files;
     bool                m_directories;
@@ -46,5 +56,4 @@ private:
     bool                m_dots;
     bool                m_onlyolder;
     FILETIME            m_olderthan;
-
 };
@@ -35,9 +35,14 @@ public:
     static bool     can_defer();
     static void     defer_info(const char* function, int32 line, const char* fmt, ...);
 
+    // Writes any buffered lines.  When crashing, this doesn't wait long for
+    // a lock that may be held by a thread that's gone.
+    static void     flush(bool crashing=false);
+
 private:
     void            emit(const char* function, int32 line, const char* fmt, va_list args);
     virtual void    emit_impl(const char* function, int32 line, const char* msg) = 0;
+    virtual void    flush_impl(bool crashing) {}
 
     void            emit_deferred();
     size_t          begin_group();
@@ -50,9 +55,14 @@ private:
 };
 
 //------------------------------------------------------------------------------
+// Lines are queued by whichever thread logs them, and a background thread
+// appends them to the file in batches.
 class file_logger
     : public logger
 {
+    struct entry;
+    struct writer;
+
 public:
                     file_logger(const char* log_path);
                     ~file_logger();
@@ -60,10 +70,19 @@ public:
 
     static const char* get_path() { return s_this ? s_this->m_log_path.c_str() : nullptr; }
 
+    // Call before deleting the logger while the DLL is unloading, where the
+    // writer thread can't finish exiting.
+    static void     set_unloading() { s_unloading = true; }
+
+private:
+    virtual void    flush_impl(bool crashing) override;
+
 private:
     str<256>        m_log_path;
+    writer*         m_writer;
 
     static const file_logger* s_this;
+    static bool     s_unloading;
 };
 
 //------------------------------------------------------------------------------
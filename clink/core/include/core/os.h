@@ -67,6 +67,13 @@ private:
     int64       m_start;
 };
 
+struct file_stamp
+{
+    FILETIME    mtime;
+    uint64      size;
+    uint32      attr;       // INVALID_FILE_ATTRIBUTES if missing.
+};
+
 struct clipboard_provider
 {
     virtual bool get_clipboard_text(str_base& out) = 0;
@@ -78,6 +85,8 @@ DWORD   get_file_attributes(const char* path, bool* symlink=nullptr);
 int32   get_path_type(const char* path);
 int32   get_drive_type(const char* path, uint32 len=-1);
 int32   get_file_size(const char* path);
+void    get_file_stamp(const wchar_t* path, file_stamp& out);
+bool    is_file_stamp_current(const wchar_t* path, const file_stamp& stamp);
 bool    is_hidden(const char* path);
 bool    get_current_dir(str_base& out);
 bool    set_current_dir(const char* dir);
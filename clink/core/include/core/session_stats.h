@@ -0,0 +1,103 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "os.h"
+
+//------------------------------------------------------------------------------
+// Stages of handling a keystroke whose latency is measured.  Stages nest; for
+// example dispatch includes any display it causes.  The input stage is the
+// whole time from receiving a key until the redraw after it has finished.
+enum class latency_stage : uint32
+{
+    input,
+    dispatch,
+    update_internal,
+    generate,
+    classify,
+    suggest,
+    prompt,
+    display,
+    max
+};
+
+//------------------------------------------------------------------------------
+// Log-scale histogram of durations, with two buckets per power of two from 1
+// usec up to about 16 seconds.  The counts are halved whenever the histogram
+// holds c_latency_window samples, so it mostly reflects recent keystrokes.
+static const uint32 c_latency_buckets = 48;
+static const uint32 c_latency_window = 4096;
+struct latency_histogram
+{
+    uint32          count;                  // Samples in the buckets.
+    uint32          total;                  // Samples ever recorded.
+    uint32          max_us;                 // Max since the counts were last halved.
+    uint32          prev_max_us;            // Max before that.
+    uint32          buckets[c_latency_buckets];
+};
+
+//------------------------------------------------------------------------------
+// Counters that a Clink session publishes in named shared memory, so that
+// `clink info` can report them even though it runs in a different process.
+// Fields are only ever appended; readers use `size` to tell which fields the
+// session's version of Clink wrote.
+struct session_stats
+{
+    uint32          size;
+
+    // Command output cache (io.popencached).
+    uint32          cmdcache_entries;
+    uint32          cmdcache_bytes;
+    uint32          cmdcache_hits;
+    uint32          cmdcache_misses;
+    uint32          cmdcache_expired;       // Misses because the TTL elapsed.
+    uint32          cmdcache_invalidated;   // Misses because a dependency changed.
+    uint32          cmdcache_evicted;
+
+    // Keystroke latency, indexed by latency_stage.
+    latency_histogram latency[uint32(latency_stage::max)];
+
+    // Word collection.  Reused counts consumers that got words already
+    // collected for the same line during the same keystroke.
+    uint32          wordcollect_tokenised;
+    uint32          wordcollect_reused;
+};
+
+//------------------------------------------------------------------------------
+// Returns the stats block for the current process, creating it on first use.
+// Returns nullptr if the shared memory couldn't be created.
+session_stats* get_session_stats();
+
+// Copies the stats published by session_id.  Fields the session didn't write
+// are zero.  Returns false if the session hasn't published stats.
+bool read_session_stats(int32 session_id, session_stats& out);
+
+//------------------------------------------------------------------------------
+// Latency is only recorded on the main thread.
+void record_latency(latency_stage stage, double seconds);
+const char* get_latency_stage_name(latency_stage stage);
+
+// Returns the duration in usec that pct percent of the samples are at or
+// below (rounded up to the end of the bucket), or 0 if there are no samples.
+uint32 get_latency_percentile(const latency_histogram& histogram, uint32 pct);
+uint32 get_latency_max(const latency_histogram& histogram);
+
+// The terminal notes when a key arrives, and the line editor notes when it
+// has finished handling the key and redrawing.
+void latency_key_received();
+void latency_key_handled();
+
+//------------------------------------------------------------------------------
+class latency_scope
+{
+public:
+                    latency_scope(latency_stage stage) : m_stage(stage), m_begin(os::clock()) {}
+                    ~latency_scope() { record_latency(m_stage, os::clock() - m_begin); }
+private:
+    const latency_stage m_stage;
+    const double    m_begin;
+};
+
+//------------------------------------------------------------------------------
+#define LATENCY_SCOPE(stage)    const latency_scope _latency_scope(latency_stage::stage)
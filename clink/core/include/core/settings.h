@@ -50,6 +50,17 @@ struct setting_name_value
 
 setting_iter        first();
 setting*            find(const char* name);
+
+// A handle is an interned setting name.  It stays valid for the life of the
+// process, even while no setting by that name exists (e.g. while Lua scripts
+// are being reloaded), and resolves to the setting in O(1).  Handles are
+// never 0.
+uint32              get_handle(const char* name);
+setting*            from_handle(uint32 handle);
+
+// Increments whenever any setting's value changes, or a setting is added or
+// removed, so callers can cache values until the generation changes.
+uint32              get_generation();
 bool                load(const char* file, const char* default_file=nullptr);
 bool                save(const char* file);
 
@@ -109,6 +120,7 @@ public:
 protected:
                     setting(const char* name, const char* short_desc, const char* long_desc, type_e type);
     const char*     get_custom_default() const;
+    static void     changed();
     str<settings::c_max_len_name + 1, false> m_name;
     str<settings::c_max_len_short_desc + 1, false> m_short_desc;
     str<128>        m_long_desc;
@@ -188,6 +200,7 @@ template <typename T> void setting_impl<T>::set()
     if (!custom_default || !parse(custom_default, m_store))
         m_store.value = T(m_default);
     m_save = !is_default();
+    changed();
 }
 
 //------------------------------------------------------------------------------
@@ -196,6 +209,7 @@ template <typename T> bool setting_impl<T>::set(const char* value)
     if (!parse(value, m_store))
         return false;
     m_save = true;
+    changed();
     return true;
 }
 
@@ -267,6 +281,8 @@ protected:
 class setting_color
     : public setting_str
 {
+    friend void set_parsed_color(setting_color& s, const char* color);
+
 public:
                        setting_color(const char* name, const char* short_desc, const char* default_value);
                        setting_color(const char* name, const char* short_desc, const char* long_desc, const char* default_value);
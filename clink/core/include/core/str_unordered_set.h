@@ -33,8 +33,36 @@ struct match_comparator
     }
 };
 
+//------------------------------------------------------------------------------
+// Folds ASCII letters only, to agree with stricmp for the names it's used for
+// (settings, doskey aliases).
+struct match_hasher_caseless
+{
+    size_t operator()(const char* match) const
+    {
+        uint32 hash = 5381;
+        while (uint8 c = *match++)
+        {
+            if (c >= 'A' && c <= 'Z')
+                c += 'a' - 'A';
+            hash = ((hash << 5) + hash) ^ c;
+        }
+        return hash;
+    }
+};
+
+//------------------------------------------------------------------------------
+struct match_comparator_caseless
+{
+    bool operator()(const char* m1, const char* m2) const
+    {
+        return stricmp(m1, m2) == 0;
+    }
+};
+
 //------------------------------------------------------------------------------
 typedef std::unordered_set<const char*, match_hasher, match_comparator> str_unordered_set;
 typedef std::unordered_set<const wchar_t*, match_hasher, match_comparator> wstr_unordered_set;
 template <typename ValTy> class str_unordered_map : public std::unordered_map<const char*, ValTy, match_hasher, match_comparator> {};
 template <typename ValTy> class wstr_unordered_map : public std::unordered_map<const wchar_t*, ValTy, match_hasher, match_comparator> {};
+template <typename ValTy> class str_unordered_map_caseless : public std::unordered_map<const char*, ValTy, match_hasher_caseless, match_comparator_caseless> {};
@@ -0,0 +1,79 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+struct task_pool_stats
+{
+    uint32          workers = 0;        // Worker threads currently alive.
+    uint32          peak_workers = 0;   // Most worker threads alive at once.
+    uint32          busy_workers = 0;   // Worker threads currently running work.
+    uint32          blocked_workers = 0;// Worker threads currently running blocking work.
+    uint32          queued = 0;         // Work items waiting for a worker.
+    uint32          peak_queued = 0;    // Deepest the queue has been.
+    uint64          submitted = 0;
+    uint64          completed = 0;
+    uint64          stolen = 0;         // Items run by a worker other than the one they were queued to.
+    double          total_latency = 0;  // Seconds between submit and start, summed.
+    double          max_latency = 0;
+    double          total_runtime = 0;  // Seconds spent running work, summed.
+    double          max_runtime = 0;
+};
+
+//------------------------------------------------------------------------------
+// A bounded pool of worker threads.  Each worker has its own queue; submitted
+// work is distributed round robin, and idle workers steal from the back of
+// other workers' queues.  Workers are started on demand up to the maximum,
+// and exit after being idle for a while.
+//
+// Work that mostly waits (e.g. on a child process or the network) should be
+// submitted as blocking.  Workers running blocking work don't count against
+// the maximum, so blocking work can't occupy every worker and starve the rest
+// of the queue.
+//
+// Work items run to completion; cancellation is cooperative, so work that can
+// be canceled should check its own flag (e.g. async_lua_task::is_canceled()).
+class task_pool
+{
+    struct worker;
+    struct work_item;
+
+public:
+    typedef std::function<void()> work_func;
+
+                    task_pool(uint32 max_workers=0, uint32 idle_timeout=30000);
+                    ~task_pool();
+
+    bool            submit(work_func&& func, bool blocking=false);
+    void            get_stats(task_pool_stats& stats) const;
+    uint32          max_workers() const { return m_max_workers; }
+
+    static task_pool& get();
+
+private:
+    bool            can_start_worker() const;
+    bool            start_worker();
+    bool            pop_local(worker* w, work_item& item);
+    bool            steal(worker* w, work_item& item);
+    void            run_item(work_item& item, bool stolen);
+    void            worker_loop(worker* w);
+    static unsigned __stdcall threadproc(void* arg);
+
+private:
+    mutable SRWLOCK m_lock = SRWLOCK_INIT;
+    CONDITION_VARIABLE m_work_cv = CONDITION_VARIABLE_INIT;
+    CONDITION_VARIABLE m_exit_cv = CONDITION_VARIABLE_INIT;
+    std::vector<std::unique_ptr<worker>> m_workers;
+    const uint32    m_max_workers;
+    const uint32    m_idle_timeout;
+    uint32          m_next_worker = 0;
+    uint32          m_idle_workers = 0;
+    volatile long   m_pending = 0;
+    bool            m_shutdown = false;
+    task_pool_stats m_stats;
+};
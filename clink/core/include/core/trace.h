@@ -0,0 +1,48 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "os.h"
+
+//------------------------------------------------------------------------------
+// Records timed spans into a ring buffer per thread, and writes them as Chrome
+// trace-event JSON (load the file in chrome://tracing or ui.perfetto.dev).
+// Timestamps come from os::clock(), which is also what Lua's os.clock()
+// returns.  When tracing is disabled, a span only tests a flag.
+namespace trace
+{
+
+extern volatile bool s_enabled;
+
+inline bool     is_enabled() { return s_enabled; }
+void            enable(bool enable);
+
+// Records a span on the current thread.  The name must stay valid until the
+// trace is written; use intern() for names that aren't string literals.
+void            record(const char* name, double begin, double end);
+const char*     intern(const char* name);
+
+// Discards the events recorded so far.
+void            clear();
+
+// Writes the recorded events (at most the most recent c_capacity per thread).
+bool            write_json(const char* file);
+
+static const uint32 c_capacity = 16384;
+
+}; // namespace trace
+
+//------------------------------------------------------------------------------
+class trace_span
+{
+public:
+                    trace_span(const char* name) : m_name(trace::is_enabled() ? name : nullptr), m_begin(m_name ? os::clock() : 0) {}
+                    ~trace_span() { if (m_name) trace::record(m_name, m_begin, os::clock()); }
+private:
+    const char* const m_name;
+    const double    m_begin;
+};
+
+//------------------------------------------------------------------------------
+#define TRACE_SCOPE(name)   const trace_span _trace_span(name)
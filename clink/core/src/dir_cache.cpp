@@ -0,0 +1,310 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "dir_cache.h"
+#include "debugheap.h"
+#include "os.h"
+#include "path.h"
+#include "settings.h"
+#include "str_transform.h"
+
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+static const uint32 c_max_listings = 64;
+
+static setting_bool g_files_cache(
+    "files.cache",
+    "Cache directory listings",
+    "When enabled, directory listings are cached and reused when generating file\n"
+    "lists, until the directory changes or the listing is 30 seconds old.  This\n"
+    "can make completion much faster in large directories or on network drives.\n"
+    "Removable drives are never cached.",
+    false);
+
+//------------------------------------------------------------------------------
+// Directory last write times are only trustworthy on some drives; e.g. FAT
+// volumes on removable drives don't reliably update them.
+static bool is_cacheable_dir(const char* dir)
+{
+    if (path::is_unc(dir))
+        return true;
+
+    const char* p = dir + path::past_ssqs(dir);
+    if (!p[0] || p[1] != ':')
+        return false;
+
+    char drive[4];
+    drive[0] = p[0];
+    drive[1] = ':';
+    drive[2] = '\\';
+    drive[3] = '\0';
+    switch (os::get_drive_type(drive))
+    {
+    case os::drive_type_remote:
+    case os::drive_type_fixed:
+    case os::drive_type_ramdisk:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//------------------------------------------------------------------------------
+static bool get_dir_mtime(const wchar_t* dir, FILETIME& mtime)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(dir, GetFileExInfoStandard, &data) ||
+        !(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        return false;
+
+    mtime = data.ftLastWriteTime;
+    return true;
+}
+
+
+
+//------------------------------------------------------------------------------
+bool dir_listing::matches_prefix(const dir_listing_entry& entry, const wchar_t* prefix, uint32 len) const
+{
+    if (!len)
+        return true;
+
+    // FindFirstFileW matches wildcards against 8.3 names as well.
+    if (entry.name_len >= len &&
+        CompareStringOrdinal(get_name(entry), len, prefix, len, true) == CSTR_EQUAL)
+        return true;
+    if (entry.short_len >= len &&
+        CompareStringOrdinal(get_short_name(entry), len, prefix, len, true) == CSTR_EQUAL)
+        return true;
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void dir_listing::get_find_data(uint32 index, WIN32_FIND_DATAW& data) const
+{
+    const dir_listing_entry& entry = m_entries[index];
+
+    data.dwFileAttributes = entry.attr;
+    data.ftCreationTime = entry.created;
+    data.ftLastAccessTime = entry.accessed;
+    data.ftLastWriteTime = entry.modified;
+    data.nFileSizeHigh = DWORD(entry.size >> 32);
+    data.nFileSizeLow = DWORD(entry.size);
+    data.dwReserved0 = entry.reparse_tag;
+    data.dwReserved1 = 0;
+
+    const uint32 len = min<uint32>(entry.name_len, sizeof_array(data.cFileName) - 1);
+    memcpy(data.cFileName, get_name(entry), len * sizeof(wchar_t));
+    data.cFileName[len] = '\0';
+
+    const uint32 short_len = min<uint32>(entry.short_len, sizeof_array(data.cAlternateFileName) - 1);
+    memcpy(data.cAlternateFileName, get_short_name(entry), short_len * sizeof(wchar_t));
+    data.cAlternateFileName[short_len] = '\0';
+}
+
+//------------------------------------------------------------------------------
+bool dir_listing::load(const wchar_t* dir)
+{
+    m_entries.clear();
+    m_arena.clear();
+
+    // Capture the time before enumerating, so a change that happens while
+    // enumerating invalidates the listing.
+    if (!get_dir_mtime(dir, m_dir_mtime))
+        return false;
+
+    wstr<280> pattern(dir);
+    if (pattern.length() && !path::is_separator(pattern.c_str()[pattern.length() - 1]))
+        pattern.concat(L"\\");
+    pattern.concat(L"*");
+
+    WIN32_FIND_DATAW fd;
+    HANDLE h = FindFirstFileExW(pattern.c_str(), FindExInfoStandard, &fd, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    do
+    {
+        const size_t name_len = wcslen(fd.cFileName);
+        const size_t short_len = wcslen(fd.cAlternateFileName);
+
+        dir_listing_entry entry;
+        entry.name = uint32(m_arena.size());
+        entry.name_len = uint16(name_len);
+        m_arena.insert(m_arena.end(), fd.cFileName, fd.cFileName + name_len + 1);
+        entry.short_name = uint32(m_arena.size());
+        entry.short_len = uint16(short_len);
+        m_arena.insert(m_arena.end(), fd.cAlternateFileName, fd.cAlternateFileName + short_len + 1);
+        entry.attr = fd.dwFileAttributes;
+        entry.reparse_tag = fd.dwReserved0;
+        entry.size = (uint64(fd.nFileSizeHigh) << 32) | fd.nFileSizeLow;
+        entry.accessed = fd.ftLastAccessTime;
+        entry.modified = fd.ftLastWriteTime;
+        entry.created = fd.ftCreationTime;
+        m_entries.emplace_back(entry);
+    }
+    while (FindNextFileW(h, &fd));
+
+    FindClose(h);
+
+    m_entries.shrink_to_fit();
+    m_arena.shrink_to_fit();
+    m_loaded_tick = GetTickCount();
+    m_used_tick = m_loaded_tick;
+    return true;
+}
+
+
+
+//------------------------------------------------------------------------------
+dir_cache& dir_cache::get()
+{
+    static dir_cache* s_cache = nullptr;
+    if (!s_cache)
+    {
+        dbg_ignore_scope(snapshot, "Directory listing cache");
+        s_cache = new dir_cache;
+    }
+    return *s_cache;
+}
+
+//------------------------------------------------------------------------------
+// Reads the files.cache setting, so it's current even for globs that happen
+// outside of match generation.  Only call this on the main thread.
+bool dir_cache::is_enabled()
+{
+    return g_files_cache.get();
+}
+
+//------------------------------------------------------------------------------
+// Returns the cached listing for the directory, loading it if necessary.
+// Returns nullptr if the directory can't be cached; the caller should
+// enumerate it directly instead.
+std::shared_ptr<const dir_listing> dir_cache::get_listing(const char* dir)
+{
+    str<280> full;
+    if (!os::get_full_path_name(*dir ? dir : ".", full))
+        return nullptr;
+    path::maybe_strip_last_separator(full);
+    if (!is_cacheable_dir(full.c_str()))
+        return nullptr;
+
+    str<280> key;
+    str_transform(full.c_str(), full.length(), key, transform_mode::lower);
+
+    wstr<280> wfull(full.c_str());
+    const DWORD now = GetTickCount();
+
+    AcquireSRWLockExclusive(&m_lock);
+
+    auto iter = std::find_if(m_listings.begin(), m_listings.end(), [&key](const std::shared_ptr<dir_listing>& listing) {
+        return listing->m_key.equals(key.c_str());
+    });
+
+    if (iter != m_listings.end())
+    {
+        // There's no way to get a directory's entry count without enumerating
+        // it, which is what the cache avoids.  Adding, removing, or renaming
+        // an entry updates the directory's last write time on the drives that
+        // is_cacheable_dir() allows, so the time alone catches count changes.
+        const std::shared_ptr<dir_listing> listing = *iter;
+        FILETIME mtime;
+        if (now - listing->m_loaded_tick < c_max_age &&
+            get_dir_mtime(wfull.c_str(), mtime) &&
+            CompareFileTime(&mtime, &listing->m_dir_mtime) == 0)
+        {
+            listing->m_used_tick = now;
+            ++m_stats.hits;
+            ReleaseSRWLockExclusive(&m_lock);
+            return listing;
+        }
+
+        m_stats.entries -= listing->count();
+        --m_stats.listings;
+        ++m_stats.invalidated;
+        m_listings.erase(iter);
+    }
+    else
+    {
+        ++m_stats.misses;
+    }
+
+    ReleaseSRWLockExclusive(&m_lock);
+
+    // Load without holding the lock, since enumerating can be slow.
+    std::shared_ptr<dir_listing> listing;
+    {
+        dbg_ignore_scope(snapshot, "Directory listing cache");
+        listing = std::make_shared<dir_listing>();
+        listing->m_key = key.c_str();
+        if (!listing->load(wfull.c_str()))
+            return nullptr;
+    }
+
+    // Too big to cache; still usable by the caller.
+    if (listing->count() > c_max_entries)
+        return listing;
+
+    AcquireSRWLockExclusive(&m_lock);
+
+    // Another thread may have loaded the same directory meanwhile.
+    iter = std::find_if(m_listings.begin(), m_listings.end(), [&key](const std::shared_ptr<dir_listing>& listing) {
+        return listing->m_key.equals(key.c_str());
+    });
+    if (iter != m_listings.end())
+    {
+        m_stats.entries -= (*iter)->count();
+        --m_stats.listings;
+        m_listings.erase(iter);
+    }
+
+    evict(listing->count());
+
+    {
+        dbg_ignore_scope(snapshot, "Directory listing cache");
+        m_listings.emplace_back(listing);
+    }
+    m_stats.entries += listing->count();
+    ++m_stats.listings;
+
+    ReleaseSRWLockExclusive(&m_lock);
+    return listing;
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::clear()
+{
+    AcquireSRWLockExclusive(&m_lock);
+    m_listings.clear();
+    m_stats = dir_cache_stats();
+    ReleaseSRWLockExclusive(&m_lock);
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::get_stats(dir_cache_stats& stats) const
+{
+    AcquireSRWLockShared(&m_lock);
+    stats = m_stats;
+    ReleaseSRWLockShared(&m_lock);
+}
+
+//------------------------------------------------------------------------------
+// Evicts least recently used listings to make room.  The caller must hold the
+// lock exclusively.
+void dir_cache::evict(uint32 needed)
+{
+    while (!m_listings.empty() &&
+           (m_listings.size() >= c_max_listings || m_stats.entries + needed > c_max_entries))
+    {
+        const DWORD now = GetTickCount();
+        auto oldest = std::max_element(m_listings.begin(), m_listings.end(), [now](const std::shared_ptr<dir_listing>& a, const std::shared_ptr<dir_listing>& b) {
+            return (now - a->m_used_tick) < (now - b->m_used_tick);
+        });
+        m_stats.entries -= (*oldest)->count();
+        --m_stats.listings;
+        ++m_stats.evicted;
+        m_listings.erase(oldest);
+    }
+}
@@ -0,0 +1,882 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "git_repo.h"
+#include "debugheap.h"
+#include "os.h"
+#include "path.h"
+#include "str_transform.h"
+
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+static const uint32 c_max_file_size = 16 * 1024 * 1024;
+static const uint32 c_max_index_size = 128 * 1024 * 1024;
+static const uint32 c_max_symref_depth = 5;
+
+//------------------------------------------------------------------------------
+static bool is_current(const git_file_stamp& stamp)
+{
+    return os::is_file_stamp_current(stamp.path.c_str(), stamp);
+}
+
+//------------------------------------------------------------------------------
+static bool is_oid(const char* s)
+{
+    uint32 len = 0;
+    for (; *s; ++s, ++len)
+    {
+        if (!isxdigit(uint8(*s)))
+            return false;
+    }
+    return len == 40 || len == 64;
+}
+
+//------------------------------------------------------------------------------
+// Ref names come from files in the git dir, and are used to build file paths,
+// so reject anything that could refer outside the git dir.
+static bool is_safe_ref(const char* ref)
+{
+    if (strncmp(ref, "refs/", 5) != 0)
+        return false;
+    if (strpbrk(ref, "\\:") || strstr(ref, ".."))
+        return false;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Refs that are per-worktree live in the git dir; all others live in the
+// common dir.
+static bool is_per_worktree_ref(const char* ref)
+{
+    return (strncmp(ref, "refs/bisect/", 12) == 0 ||
+            strncmp(ref, "refs/worktree/", 14) == 0 ||
+            strncmp(ref, "refs/rewritten/", 15) == 0);
+}
+
+//------------------------------------------------------------------------------
+static uint32 read_be32(const uint8* p)
+{
+    return (uint32(p[0]) << 24) | (uint32(p[1]) << 16) | (uint32(p[2]) << 8) | uint32(p[3]);
+}
+
+//------------------------------------------------------------------------------
+static uint32 read_be16(const uint8* p)
+{
+    return (uint32(p[0]) << 8) | uint32(p[1]);
+}
+
+//------------------------------------------------------------------------------
+static const char* skip_space(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+    return p;
+}
+
+//------------------------------------------------------------------------------
+// Parses a git config value:  strips comments and surrounding whitespace, and
+// removes quotes.  Escapes are not needed for the values Clink looks up.
+static void parse_config_value(const char* p, const char* end, str_base& out)
+{
+    out.clear();
+    p = skip_space(p, end);
+
+    bool quoted = false;
+    uint32 keep = 0;
+    for (; p < end; ++p)
+    {
+        const char c = *p;
+        if (c == '"')
+        {
+            quoted = !quoted;
+            keep = out.length();
+            continue;
+        }
+        if (!quoted && (c == '#' || c == ';'))
+            break;
+        if (c == '\r' || c == '\n')
+            break;
+        out.concat(&c, 1);
+        if (quoted || (c != ' ' && c != '\t'))
+            keep = out.length();
+    }
+
+    out.truncate(keep);
+}
+
+
+
+//------------------------------------------------------------------------------
+class git_repo_reader
+{
+public:
+                    git_repo_reader(const char* git_dir, std::vector<git_file_stamp>& stamps);
+    bool            read(git_repo_state& state);
+    bool            read_conflicts(git_repo_state& state);
+
+private:
+    bool            read_file(const char* dir, const char* name, std::vector<char>& out, uint32 max_size=c_max_file_size);
+    bool            read_line(const char* dir, const char* name, str_base& out);
+    uint32          get_attr(const char* dir, const char* name);
+    bool            is_file(const char* dir, const char* name);
+    bool            is_dir(const char* dir, const char* name);
+    void            read_config(const char* branch);
+    bool            resolve_ref(const char* ref, str_base& oid);
+    bool            find_packed_ref(const char* ref, str_base& oid);
+    void            read_upstream(git_repo_state& state);
+    void            read_action(git_repo_state& state);
+    void            read_steps(const char* step_name, const char* total_name, git_repo_state& state);
+    void            read_stashes(git_repo_state& state);
+    bool            is_default_fetch() const;
+    bool            read_common_dir();
+    int32           count_conflicts();
+
+    struct fetch_spec
+    {
+        str_moveable    remote;
+        str_moveable    spec;
+    };
+
+    str<280>        m_git_dir;
+    str<280>        m_common_dir;
+    std::vector<git_file_stamp>& m_stamps;
+    std::vector<char> m_packed_refs;
+    bool            m_packed_refs_loaded = false;
+    str_moveable    m_remote;
+    str_moveable    m_merge;
+    std::vector<fetch_spec> m_fetch;
+    uint32          m_hash_len = 20;
+    bool            m_reftable = false;
+};
+
+//------------------------------------------------------------------------------
+git_repo_reader::git_repo_reader(const char* git_dir, std::vector<git_file_stamp>& stamps)
+: m_git_dir(git_dir)
+, m_stamps(stamps)
+{
+}
+
+//------------------------------------------------------------------------------
+bool git_repo_reader::read(git_repo_state& state)
+{
+    str<> head;
+    if (!read_line(m_git_dir.c_str(), "HEAD", head))
+        return false;
+
+    read_common_dir();
+
+    const char* ref = nullptr;
+    if (strncmp(head.c_str(), "ref: ", 5) == 0)
+    {
+        ref = head.c_str() + 5;
+        if (strncmp(ref, "refs/heads/", 11) == 0)
+            state.branch = ref + 11;
+        else
+            state.branch = ref;
+    }
+    else if (is_oid(head.c_str()))
+    {
+        state.head = head.c_str();
+        state.branch.concat(head.c_str(), 7);
+        state.detached = true;
+    }
+    else
+    {
+        return false;
+    }
+
+    read_config(state.detached ? nullptr : state.branch.c_str());
+
+    // A repo with a reftable has a placeholder HEAD, and no loose refs or
+    // packed-refs file.
+    if (m_reftable || state.branch.equals(".invalid"))
+    {
+        state.branch.clear();
+        state.reftable = true;
+    }
+    else
+    {
+        str<> oid;
+        if (ref && resolve_ref(ref, oid))
+            state.head = oid.c_str();
+        read_upstream(state);
+        read_stashes(state);
+    }
+
+    read_action(state);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Only reads what's needed to count conflicts:  the config for the hash
+// length, and the index.
+bool git_repo_reader::read_conflicts(git_repo_state& state)
+{
+    if (!is_file(m_git_dir.c_str(), "HEAD"))
+        return false;
+
+    read_common_dir();
+    read_config(nullptr);
+    state.conflicts = count_conflicts();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// In a worktree, refs and config are shared with the main repo.
+bool git_repo_reader::read_common_dir()
+{
+    str<280> common;
+    if (read_line(m_git_dir.c_str(), "commondir", common))
+    {
+        if (path::is_rooted(common.c_str()))
+            m_common_dir = common.c_str();
+        else
+            path::join(m_git_dir.c_str(), common.c_str(), m_common_dir);
+        path::normalise(m_common_dir);
+        path::maybe_strip_last_separator(m_common_dir);
+        return true;
+    }
+
+    m_common_dir = m_git_dir.c_str();
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Reads a file and records its stamp.  The stamp is taken before reading, so
+// that a change made while reading invalidates the cached state.
+bool git_repo_reader::read_file(const char* dir, const char* name, std::vector<char>& out, uint32 max_size)
+{
+    out.clear();
+
+    str<280> file;
+    path::join(dir, name, file);
+
+    git_file_stamp stamp;
+    stamp.path = file.c_str();
+    os::get_file_stamp(stamp.path.c_str(), stamp);
+    const bool exists = (stamp.attr != INVALID_FILE_ATTRIBUTES && !(stamp.attr & FILE_ATTRIBUTE_DIRECTORY));
+    const uint64 size = stamp.size;
+    m_stamps.emplace_back(std::move(stamp));
+
+    if (!exists || size > max_size)
+        return false;
+
+    HANDLE h = CreateFileW(m_stamps.back().path.c_str(), GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    out.resize(size_t(size));
+    DWORD read = 0;
+    const bool ok = (!size || ReadFile(h, out.data(), DWORD(size), &read, nullptr));
+    CloseHandle(h);
+
+    out.resize(ok ? read : 0);
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+bool git_repo_reader::read_line(const char* dir, const char* name, str_base& out)
+{
+    out.clear();
+
+    std::vector<char> content;
+    if (!read_file(dir, name, content, 4096))
+        return false;
+
+    const char* p = content.data();
+    const char* end = p + content.size();
+    const char* eol = p;
+    while (eol < end && *eol != '\r' && *eol != '\n')
+        ++eol;
+    while (eol > p && (eol[-1] == ' ' || eol[-1] == '\t'))
+        --eol;
+
+    out.concat(p, int32(eol - p));
+    return !out.empty();
+}
+
+//------------------------------------------------------------------------------
+uint32 git_repo_reader::get_attr(const char* dir, const char* name)
+{
+    str<280> file;
+    path::join(dir, name, file);
+
+    git_file_stamp stamp;
+    stamp.path = file.c_str();
+    os::get_file_stamp(stamp.path.c_str(), stamp);
+    const uint32 attr = stamp.attr;
+    m_stamps.emplace_back(std::move(stamp));
+    return attr;
+}
+
+//------------------------------------------------------------------------------
+bool git_repo_reader::is_file(const char* dir, const char* name)
+{
+    const uint32 attr = get_attr(dir, name);
+    return attr != INVALID_FILE_ATTRIBUTES && !(attr & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+//------------------------------------------------------------------------------
+bool git_repo_reader::is_dir(const char* dir, const char* name)
+{
+    const uint32 attr = get_attr(dir, name);
+    return attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+//------------------------------------------------------------------------------
+// Looks up only the few config values needed:  the hash algorithm, the ref
+// storage format, the upstream for the current branch, and the remotes' fetch
+// refspecs.  Includes are not followed.
+void git_repo_reader::read_config(const char* branch)
+{
+    std::vector<char> config;
+    if (!read_file(m_common_dir.c_str(), "config", config))
+        return;
+
+    str<32> section;
+    str<> subsection;
+    str<32> key;
+    str<> value;
+
+    const char* p = config.data();
+    const char* const end = p + config.size();
+    while (p < end)
+    {
+        const char* eol = p;
+        while (eol < end && *eol != '\n')
+            ++eol;
+        const char* next = (eol < end) ? eol + 1 : eol;
+
+        p = skip_space(p, eol);
+        if (p < eol && *p == '[')
+        {
+            section.clear();
+            subsection.clear();
+
+            for (++p; p < eol && *p != ']' && *p != '"' && *p != ' ' && *p != '\t' && *p != '.'; ++p)
+            {
+                const char c = char(tolower(uint8(*p)));
+                section.concat(&c, 1);
+            }
+
+            if (p < eol && *p == '.')
+            {
+                // Deprecated [section.subsection] syntax.
+                const char* sub = ++p;
+                while (p < eol && *p != ']')
+                    ++p;
+                subsection.concat(sub, int32(p - sub));
+            }
+            else
+            {
+                p = skip_space(p, eol);
+                if (p < eol && *p == '"')
+                {
+                    for (++p; p < eol && *p != '"'; ++p)
+                    {
+                        if (*p == '\\' && p + 1 < eol)
+                            ++p;
+                        subsection.concat(p, 1);
+                    }
+                }
+            }
+        }
+        else if (p < eol && isalpha(uint8(*p)))
+        {
+            key.clear();
+            for (; p < eol && (isalnum(uint8(*p)) || *p == '-'); ++p)
+            {
+                const char c = char(tolower(uint8(*p)));
+                key.concat(&c, 1);
+            }
+
+            p = skip_space(p, eol);
+            if (p < eol && *p == '=')
+                parse_config_value(p + 1, eol, value);
+            else
+                value.clear();
+
+            if (section.equals("extensions"))
+            {
+                if (key.equals("objectformat"))
+                    m_hash_len = value.iequals("sha256") ? 32 : 20;
+                else if (key.equals("refstorage"))
+                    m_reftable = value.iequals("reftable");
+            }
+            else if (branch && section.equals("branch") && subsection.equals(branch))
+            {
+                if (key.equals("remote"))
+                    m_remote = value.c_str();
+                else if (key.equals("merge"))
+                    m_merge = value.c_str();
+            }
+            else if (branch && section.equals("remote") && key.equals("fetch"))
+            {
+                fetch_spec fetch;
+                fetch.remote = subsection.c_str();
+                fetch.spec = value.c_str();
+                m_fetch.emplace_back(std::move(fetch));
+            }
+        }
+
+        p = next;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Resolves a ref to a commit id.  A loose ref takes precedence over a packed
+// ref.  Returns false if the ref doesn't exist (e.g. an unborn branch).
+bool git_repo_reader::resolve_ref(const char* ref, str_base& oid)
+{
+    oid.clear();
+
+    str<> name(ref);
+    str<> line;
+    for (uint32 depth = 0; depth < c_max_symref_depth; ++depth)
+    {
+        if (!is_safe_ref(name.c_str()))
+            return false;
+
+        const char* dir = is_per_worktree_ref(name.c_str()) ? m_git_dir.c_str() : m_common_dir.c_str();
+        if (!read_line(dir, name.c_str(), line))
+            return find_packed_ref(name.c_str(), oid);
+
+        if (strncmp(line.c_str(), "ref: ", 5) == 0)
+        {
+            name = line.c_str() + 5;
+            continue;
+        }
+
+        if (!is_oid(line.c_str()))
+            return false;
+
+        oid = line.c_str();
+        return true;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+bool git_repo_reader::find_packed_ref(const char* ref, str_base& oid)
+{
+    if (!m_packed_refs_loaded)
+    {
+        read_file(m_common_dir.c_str(), "packed-refs", m_packed_refs);
+        m_packed_refs_loaded = true;
+    }
+
+    const uint32 ref_len = uint32(strlen(ref));
+    const char* p = m_packed_refs.data();
+    const char* const end = p + m_packed_refs.size();
+    while (p < end)
+    {
+        const char* eol = p;
+        while (eol < end && *eol != '\n')
+            ++eol;
+
+        // Lines are "<oid> <ref>"; skip the header and peeled "^<oid>" lines.
+        const char* line_end = eol;
+        if (line_end > p && line_end[-1] == '\r')
+            --line_end;
+        if (*p != '#' && *p != '^')
+        {
+            const char* space = static_cast<const char*>(memchr(p, ' ', line_end - p));
+            if (space &&
+                uint32(line_end - (space + 1)) == ref_len &&
+                memcmp(space + 1, ref, ref_len) == 0)
+            {
+                oid.clear();
+                oid.concat(p, int32(space - p));
+                return is_oid(oid.c_str());
+            }
+        }
+
+        p = (eol < end) ? eol + 1 : eol;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Returns whether the remote maps its branches into refs/remotes/<remote> the
+// default way.  Other refspecs are allowed as long as they don't map branches.
+bool git_repo_reader::is_default_fetch() const
+{
+    str<> expected;
+    expected.format("refs/heads/*:refs/remotes/%s/*", m_remote.c_str());
+
+    bool found = false;
+    for (const auto& fetch : m_fetch)
+    {
+        if (!fetch.remote.equals(m_remote.c_str()))
+            continue;
+
+        const char* spec = fetch.spec.c_str();
+        if (*spec == '+')
+            ++spec;
+        if (strcmp(spec, expected.c_str()) == 0)
+            found = true;
+        else if (strncmp(spec, "refs/heads/", 11) == 0)
+            return false;
+    }
+    return found;
+}
+
+//------------------------------------------------------------------------------
+// Only the default mapping of branch.<name>.merge into refs/remotes/<remote>
+// is supported.  With a custom fetch refspec the upstream is left empty, so
+// that callers fall back to asking git.
+void git_repo_reader::read_upstream(git_repo_state& state)
+{
+    if (m_remote.empty() || m_merge.empty())
+        return;
+    if (!m_remote.equals(".") && !is_default_fetch())
+        return;
+
+    const char* merge = m_merge.c_str();
+    if (strncmp(merge, "refs/heads/", 11) == 0)
+        merge += 11;
+
+    str<> upstream_ref;
+    if (m_remote.equals("."))
+    {
+        state.upstream = merge;
+        upstream_ref = m_merge.c_str();
+    }
+    else
+    {
+        state.upstream.format("%s/%s", m_remote.c_str(), merge);
+        upstream_ref.format("refs/remotes/%s/%s", m_remote.c_str(), merge);
+    }
+
+    str<> oid;
+    if (resolve_ref(upstream_ref.c_str(), oid))
+        state.upstream_head = oid.c_str();
+}
+
+//------------------------------------------------------------------------------
+// Same checks and order as git.getaction().
+void git_repo_reader::read_action(git_repo_state& state)
+{
+    const char* dir = m_git_dir.c_str();
+
+    if (is_dir(dir, "rebase-merge"))
+    {
+        state.action = is_file(dir, "rebase-merge/interactive") ? "rebase-i" : "rebase-m";
+        read_steps("rebase-merge/msgnum", "rebase-merge/end", state);
+    }
+    else if (is_dir(dir, "rebase-apply"))
+    {
+        if (is_file(dir, "rebase-apply/rebasing"))
+            state.action = "rebase";
+        else if (is_file(dir, "rebase-apply/applying"))
+            state.action = "am";
+        else
+            state.action = "am/rebase";
+        read_steps("rebase-apply/next", "rebase-apply/last", state);
+    }
+    else if (is_file(dir, "MERGE_HEAD"))
+        state.action = "merging";
+    else if (is_file(dir, "CHERRY_PICK_HEAD"))
+        state.action = "cherry-picking";
+    else if (is_file(dir, "REVERT_HEAD"))
+        state.action = "reverting";
+    else if (is_file(dir, "BISECT_LOG"))
+        state.action = "bisecting";
+}
+
+//------------------------------------------------------------------------------
+void git_repo_reader::read_steps(const char* step_name, const char* total_name, git_repo_state& state)
+{
+    str<32> step;
+    str<32> total;
+    read_line(m_git_dir.c_str(), step_name, step);
+    read_line(m_git_dir.c_str(), total_name, total);
+
+    const int32 s = atoi(step.c_str());
+    const int32 t = atoi(total.c_str());
+    if (s > 0 && t > 0)
+    {
+        state.step = s;
+        state.total = t;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Each stash is an entry in the stash reflog.
+void git_repo_reader::read_stashes(git_repo_state& state)
+{
+    std::vector<char> log;
+    if (read_file(m_common_dir.c_str(), "logs/refs/stash", log))
+    {
+        bool empty = true;
+        for (char c : log)
+        {
+            if (c == '\n')
+            {
+                if (!empty)
+                    ++state.stashes;
+                empty = true;
+            }
+            else if (c != '\r')
+            {
+                empty = false;
+            }
+        }
+        if (!empty)
+            ++state.stashes;
+    }
+
+    // The reflog can be disabled; then only the latest stash is visible.
+    str<> oid;
+    if (!state.stashes && resolve_ref("refs/stash", oid))
+        state.stashes = 1;
+}
+
+//------------------------------------------------------------------------------
+// Counts files with unmerged entries in the index.  An unmerged file has
+// entries with a nonzero stage, which sort together by name.  Returns -1 if
+// the index can't be interpreted.
+int32 git_repo_reader::count_conflicts()
+{
+    std::vector<char> index;
+    if (!read_file(m_git_dir.c_str(), "index", index, c_max_index_size))
+        return (m_stamps.back().attr == INVALID_FILE_ATTRIBUTES) ? 0 : -1;
+
+    if (index.size() < 12 + m_hash_len || memcmp(index.data(), "DIRC", 4) != 0)
+        return -1;
+
+    const uint8* p = reinterpret_cast<const uint8*>(index.data());
+    const uint8* const end = p + index.size() - m_hash_len;
+    const uint32 version = read_be32(p + 4);
+    const uint32 count = read_be32(p + 8);
+    if (version < 2 || version > 4)
+        return -1;
+    p += 12;
+
+    // Entries are 40 bytes of stat data, the object id, 16 bits of flags, and
+    // (in v3+) optionally 16 bits of extended flags, followed by the name.
+    const uint32 flags_offset = 40 + m_hash_len;
+
+    int32 conflicts = 0;
+    str<280> name;
+    str<280> conflict_name;
+    bool prev_conflicted = false;
+    for (uint32 i = 0; i < count; ++i)
+    {
+        if (uint32(end - p) < flags_offset + 2)
+            return -1;
+
+        const uint32 flags = read_be16(p + flags_offset);
+        const uint8* q = p + flags_offset + 2;
+        if (version >= 3 && (flags & 0x4000))
+            q += 2;
+        if (q >= end)
+            return -1;
+
+        if (version >= 4)
+        {
+            // v4 names are prefix compressed:  a varint for how many bytes to
+            // strip from the end of the previous name, then a suffix.
+            uint8 c = *(q++);
+            uint32 strip = c & 0x7f;
+            while (c & 0x80)
+            {
+                if (q >= end || strip > 0xffff)
+                    return -1;
+                c = *(q++);
+                strip = ((strip + 1) << 7) | (c & 0x7f);
+            }
+            if (strip > name.length())
+                return -1;
+
+            const uint8* nul = static_cast<const uint8*>(memchr(q, 0, end - q));
+            if (!nul)
+                return -1;
+
+            name.truncate(name.length() - strip);
+            name.concat(reinterpret_cast<const char*>(q), int32(nul - q));
+            p = nul + 1;
+        }
+        else
+        {
+            const uint8* nul = static_cast<const uint8*>(memchr(q, 0, end - q));
+            if (!nul)
+                return -1;
+
+            name.clear();
+            name.concat(reinterpret_cast<const char*>(q), int32(nul - q));
+
+            // Entries are padded with 1 to 8 NULs to a multiple of 8 bytes.
+            const size_t len = ((q - p) + (nul - q) + 8) & ~size_t(7);
+            if (len > size_t(end - p))
+                return -1;
+            p += len;
+        }
+
+        const uint32 stage = (flags >> 12) & 0x3;
+        if (stage)
+        {
+            if (!prev_conflicted || !name.equals(conflict_name.c_str()))
+            {
+                ++conflicts;
+                conflict_name = name.c_str();
+            }
+        }
+        prev_conflicted = !!stage;
+    }
+
+    // With a split index, the entries are spread across two files.
+    while (uint32(end - p) >= 8)
+    {
+        if (memcmp(p, "link", 4) == 0)
+            return -1;
+        const uint32 size = read_be32(p + 4);
+        if (size > uint32(end - p) - 8)
+            break;
+        p += 8 + size;
+    }
+
+    return conflicts;
+}
+
+
+
+//------------------------------------------------------------------------------
+git_repo_cache& git_repo_cache::get()
+{
+    static git_repo_cache* s_cache = nullptr;
+    if (!s_cache)
+    {
+        dbg_ignore_scope(snapshot, "Git repo state cache");
+        s_cache = new git_repo_cache;
+    }
+    return *s_cache;
+}
+
+//------------------------------------------------------------------------------
+// Returns the state of the repo for the git dir, reading it if necessary.
+// Returns nullptr if the git dir doesn't look like a git dir.
+std::shared_ptr<const git_repo_state> git_repo_cache::get_state(const char* git_dir)
+{
+    return lookup(git_dir, false);
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of conflicted files in the repo for the git dir, or -1
+// if it's unknown.  Only this reads the index.
+int32 git_repo_cache::get_conflicts(const char* git_dir)
+{
+    const auto state = lookup(git_dir, true);
+    return state ? state->conflicts : -1;
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const git_repo_state> git_repo_cache::lookup(const char* git_dir, bool conflicts)
+{
+    str<280> full;
+    if (!git_dir || !*git_dir || !os::get_full_path_name(git_dir, full))
+        return nullptr;
+    path::maybe_strip_last_separator(full);
+
+    str<280> lower;
+    str<280> key;
+    str_transform(full.c_str(), full.length(), lower, transform_mode::lower);
+    key.format("%s%s", conflicts ? "?" : "", lower.c_str());
+
+    AcquireSRWLockExclusive(&m_lock);
+
+    auto iter = std::find_if(m_entries.begin(), m_entries.end(), [&key](const entry& e) {
+        return e.key.equals(key.c_str());
+    });
+
+    if (iter != m_entries.end())
+    {
+        if (std::all_of(iter->stamps.begin(), iter->stamps.end(), is_current))
+        {
+            const std::shared_ptr<const git_repo_state> state = iter->state;
+            iter->used_tick = GetTickCount();
+            ++m_stats.hits;
+            ReleaseSRWLockExclusive(&m_lock);
+            return state;
+        }
+
+        --m_stats.repos;
+        ++m_stats.invalidated;
+        m_entries.erase(iter);
+    }
+    else
+    {
+        ++m_stats.misses;
+    }
+
+    ReleaseSRWLockExclusive(&m_lock);
+
+    // Read without holding the lock, since reading the index can be slow.
+    entry e;
+    {
+        dbg_ignore_scope(snapshot, "Git repo state cache");
+        std::shared_ptr<git_repo_state> state = std::make_shared<git_repo_state>();
+        git_repo_reader reader(full.c_str(), e.stamps);
+        if (!(conflicts ? reader.read_conflicts(*state) : reader.read(*state)))
+            return nullptr;
+        e.key = key.c_str();
+        e.state = std::move(state);
+        e.used_tick = GetTickCount();
+    }
+
+    const std::shared_ptr<const git_repo_state> state = e.state;
+
+    AcquireSRWLockExclusive(&m_lock);
+
+    // Another thread may have read the same repo meanwhile.
+    iter = std::find_if(m_entries.begin(), m_entries.end(), [&key](const entry& e) {
+        return e.key.equals(key.c_str());
+    });
+    if (iter != m_entries.end())
+    {
+        --m_stats.repos;
+        m_entries.erase(iter);
+    }
+
+    // Evict the least recently used repo to make room.
+    if (m_entries.size() >= c_max_repos)
+    {
+        const DWORD now = GetTickCount();
+        auto oldest = std::max_element(m_entries.begin(), m_entries.end(), [now](const entry& a, const entry& b) {
+            return (now - a.used_tick) < (now - b.used_tick);
+        });
+        --m_stats.repos;
+        m_entries.erase(oldest);
+    }
+
+    {
+        dbg_ignore_scope(snapshot, "Git repo state cache");
+        m_entries.emplace_back(std::move(e));
+    }
+    ++m_stats.repos;
+
+    ReleaseSRWLockExclusive(&m_lock);
+    return state;
+}
+
+//------------------------------------------------------------------------------
+void git_repo_cache::clear()
+{
+    AcquireSRWLockExclusive(&m_lock);
+    m_entries.clear();
+    m_stats = git_repo_stats();
+    ReleaseSRWLockExclusive(&m_lock);
+}
+
+//------------------------------------------------------------------------------
+void git_repo_cache::get_stats(git_repo_stats& stats) const
+{
+    AcquireSRWLockShared(&m_lock);
+    stats = m_stats;
+    ReleaseSRWLockShared(&m_lock);
+}
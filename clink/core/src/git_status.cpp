@@ -0,0 +1,206 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "git_status.h"
+
+//------------------------------------------------------------------------------
+static uint32 parse_count(const char* p, const char* end)
+{
+    uint32 n = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p)
+        n = n * 10 + (*p - '0');
+    return n;
+}
+
+
+
+//------------------------------------------------------------------------------
+void git_status_parser::feed(const char* data, uint32 len)
+{
+    const char* p = data;
+    const char* const end = data + len;
+
+    // Finish a line left over from the previous chunk.
+    if (!m_partial.empty())
+    {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', len));
+        if (!eol)
+        {
+            m_partial.insert(m_partial.end(), p, end);
+            return;
+        }
+
+        m_partial.insert(m_partial.end(), p, eol);
+        parse_line(m_partial.data(), uint32(m_partial.size()));
+        m_partial.clear();
+        p = eol + 1;
+    }
+
+    while (p < end)
+    {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!eol)
+        {
+            m_partial.insert(m_partial.end(), p, end);
+            return;
+        }
+
+        parse_line(p, uint32(eol - p));
+        p = eol + 1;
+    }
+}
+
+//------------------------------------------------------------------------------
+void git_status_parser::finish()
+{
+    if (!m_partial.empty())
+    {
+        parse_line(m_partial.data(), uint32(m_partial.size()));
+        m_partial.clear();
+    }
+}
+
+//------------------------------------------------------------------------------
+void git_status_parser::parse_line(const char* line, uint32 len)
+{
+    if (len && line[len - 1] == '\r')
+        --len;
+
+    ++m_counts.lines;
+
+    if (len < 2 || line[1] != ' ')
+        return;
+
+    switch (line[0])
+    {
+    case '#':
+        parse_header(line + 2, len - 2);
+        break;
+    case '?':
+        ++m_counts.w_untracked;
+        break;
+    case 'u':
+    case 'U':
+        ++m_counts.w_conflict;
+        break;
+    case '1':
+    case '2':
+        if (len >= 5 && line[4] == ' ')
+            parse_change(line + 2);
+        break;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Parses "branch.<key> <value>" headers.
+void git_status_parser::parse_header(const char* line, uint32 len)
+{
+    const char* const end = line + len;
+    if (len < 7 || memcmp(line, "branch.", 7) != 0)
+        return;
+
+    const char* key = line + 7;
+    const char* value = key;
+    while (value < end && *value != ' ' && *value != '\t')
+        ++value;
+    if (value == key || value >= end)
+        return;
+
+    const uint32 key_len = uint32(value - key);
+    ++value;
+
+    m_counts.has_header = true;
+
+    if (key_len == 3 && memcmp(key, "oid", 3) == 0)
+    {
+        m_counts.oid.clear();
+        m_counts.oid.concat(value, int32(end - value));
+    }
+    else if (key_len == 4 && memcmp(key, "head", 4) == 0)
+    {
+        m_counts.head.clear();
+        m_counts.head.concat(value, int32(end - value));
+    }
+    else if (key_len == 8 && memcmp(key, "upstream", 8) == 0)
+    {
+        m_counts.upstream.clear();
+        m_counts.upstream.concat(value, int32(end - value));
+    }
+    else if (key_len == 2 && memcmp(key, "ab", 2) == 0)
+    {
+        // "+<ahead> -<behind>".
+        const char* plus = static_cast<const char*>(memchr(value, '+', end - value));
+        const char* minus = static_cast<const char*>(memchr(value, '-', end - value));
+        m_counts.ahead = plus ? parse_count(plus + 1, end) : 0;
+        m_counts.behind = minus ? parse_count(minus + 1, end) : 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Counts an ordinary or renamed/copied entry from its "XY" field, where X is
+// the staged status and Y is the working tree status.
+void git_status_parser::parse_change(const char* xy)
+{
+    const char staged = xy[0];
+    const char working = xy[1];
+
+    bool added = false;
+    bool modified = false;
+    bool deleted = false;
+
+    bool w = true;
+    switch (working)
+    {
+    case 'A':
+    case 'C':
+        ++m_counts.w_add;
+        added = true;
+        break;
+    case 'M':
+    case 'T':
+    case 'R':
+        ++m_counts.w_modify;
+        modified = true;
+        break;
+    case 'D':
+        ++m_counts.w_delete;
+        deleted = true;
+        break;
+    default:
+        w = false;
+        break;
+    }
+
+    switch (staged)
+    {
+    case 'A':
+    case 'C':
+        ++m_counts.s_add;
+        added = added || !w;
+        break;
+    case 'M':
+    case 'T':
+        ++m_counts.s_modify;
+        modified = modified || !w;
+        break;
+    case 'D':
+        ++m_counts.s_delete;
+        deleted = deleted || !w;
+        break;
+    case 'R':
+        ++m_counts.s_rename;
+        modified = modified || !w;
+        break;
+    }
+
+    if (added)
+        ++m_counts.t_add;
+    else if (deleted)
+        ++m_counts.t_delete;
+    else if (modified)
+        ++m_counts.t_modify;
+
+    if (staged != '.' && working == '.')
+        ++m_counts.only_staged;
+}
@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "globber.h"
+#include "dir_cache.h"
 #include "os.h"
 #include "path.h"
 #include "str.h"
@@ -11,6 +12,14 @@
 
 //------------------------------------------------------------------------------
 globber::globber(const char* pattern)
+: globber(pattern, dir_cache::is_enabled())
+{
+}
+
+//------------------------------------------------------------------------------
+// When globbing on a thread other than the main thread, use_cache must be
+// supplied by the caller since settings can only be read on the main thread.
+globber::globber(const char* pattern, bool use_cache)
 : m_files(true)
 , m_directories(true)
 , m_dir_suffix(true)
@@ -62,10 +71,14 @@ globber::globber(const char* pattern)
         }
     }
 
-    wstr<280> wglob(pattern);
-    m_handle = FindFirstFileW(wglob.c_str(), &m_data);
-    if (m_handle == INVALID_HANDLE_VALUE)
-        m_handle = nullptr;
+    m_handle = nullptr;
+    if (!use_cache || !use_listing(pattern))
+    {
+        wstr<280> wglob(pattern);
+        m_handle = FindFirstFileW(wglob.c_str(), &m_data);
+        if (m_handle == INVALID_HANDLE_VALUE)
+            m_handle = nullptr;
+    }
 
     path::get_directory(pattern, m_root);
     path::normalise_separators(m_root.data());
@@ -106,7 +119,7 @@ bool globber::next(str_base& out, bool rooted, extrainfo* extrainfo)
 {
     while (true)
     {
-        if (m_handle == nullptr)
+        if (m_handle == nullptr && !m_listing)
             return false;
 
         bool again = false;
@@ -177,11 +190,77 @@ void globber::close()
         FindClose(m_handle);
         m_handle = nullptr;
     }
+    m_listing.reset();
+}
+
+//------------------------------------------------------------------------------
+// Patterns of the form `dir\prefix*` can be satisfied from a cached listing
+// of the directory.  Other patterns fall back to FindFirstFileW, which
+// implements the full wildcard semantics.
+bool globber::use_listing(const char* pattern)
+{
+    const char* name = path::get_name(pattern);
+    const uint32 name_len = uint32(strlen(name));
+    if (!name_len || name[name_len - 1] != '*')
+        return false;
+
+    uint32 prefix_len = name_len - 1;
+    if (prefix_len == 2 && name[0] == '*' && name[1] == '.')
+        prefix_len = 0;             // `*.*` matches everything.
+    if (strpbrk(name, "?<>\"") || memchr(name, '*', prefix_len))
+        return false;
+
+    // Trailing dots and spaces have special meaning to FindFirstFileW.
+    if (prefix_len && (name[prefix_len - 1] == '.' || name[prefix_len - 1] == ' '))
+        return false;
+
+    str<280> dir;
+    dir.concat(pattern, int32(name - pattern));
+    if (strpbrk(dir.c_str(), "*?<>\""))
+        return false;
+
+    m_listing = dir_cache::get().get_listing(dir.c_str());
+    if (!m_listing)
+        return false;
+
+    str<32> prefix;
+    prefix.concat(name, prefix_len);
+    m_prefix = prefix.c_str();
+
+    m_listing_index = 0;
+    if (!next_listing_entry())
+        m_listing.reset();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Fills m_data from the next listing entry that matches the prefix, starting
+// at m_listing_index.
+bool globber::next_listing_entry()
+{
+    const uint32 count = m_listing->count();
+    while (m_listing_index < count)
+    {
+        const uint32 index = m_listing_index++;
+        if (m_listing->matches_prefix(m_listing->get(index), m_prefix.c_str(), m_prefix.length()))
+        {
+            m_listing->get_find_data(index, m_data);
+            return true;
+        }
+    }
+    return false;
 }
 
 //------------------------------------------------------------------------------
 void globber::next_file()
 {
+    if (m_listing)
+    {
+        if (!next_listing_entry())
+            m_listing.reset();
+        return;
+    }
+
     if (m_handle && !FindNextFileW(m_handle, &m_data))
         close();
 }
@@ -5,6 +5,7 @@
 #include "log.h"
 #include "os.h"
 
+#include <process.h>
 #include <stdarg.h>
 
 //------------------------------------------------------------------------------
@@ -92,17 +93,30 @@ void logger::defer_info(const char* function, int32 line, const char* fmt, ...)
 }
 
 //------------------------------------------------------------------------------
-void logger::emit(const char* function, int32 line, const char* fmt, va_list args)
+void logger::flush(bool crashing)
 {
-    str_moveable msg;
-    msg.vformat(fmt, args);
+    logger* instance = logger::get();
+    if (instance == nullptr)
+        return;
 
+    instance->flush_impl(crashing);
+}
+
+//------------------------------------------------------------------------------
+void logger::emit(const char* function, int32 line, const char* fmt, va_list args)
+{
     if (m_grouping <= 0)
     {
+        // Most messages fit in the buffer, so this usually doesn't allocate.
+        str<256> msg;
+        msg.vformat(fmt, args);
         emit_impl(function, line, msg.c_str());
     }
     else
     {
+        str_moveable msg;
+        msg.vformat(fmt, args);
+
         deferred d;
         d.function = function;
         d.line = line;
@@ -157,35 +171,125 @@ void logger::end_group(size_t rollback_index, bool discard)
         if (discard)
             m_deferred.resize(rollback_index);
     }
+
+    // Get the group's lines into the file before moving on.
+    if (m_grouping <= 0)
+        flush_impl(false/*crashing*/);
 }
 
 
 
+//------------------------------------------------------------------------------
+struct file_logger::entry
+{
+    entry*          next;
+    uint32          len;
+    char            text[1];
+};
+
+//------------------------------------------------------------------------------
+// The state shared with the writer thread lives apart from the file_logger, so
+// that if the thread can't be stopped (e.g. during DLL unload) the state can be
+// left behind instead of being freed out from under the thread.
+struct file_logger::writer
+{
+                    writer(const char* log_path) : log_path(log_path) {}
+    void            push(entry* e);
+    bool            flush(bool crashing);
+    bool            write_batch(const entry* ordered);
+    static void     free_entries(entry* list);
+    static unsigned __stdcall threadproc(void* arg);
+
+    const str_moveable log_path;
+    entry* volatile pending = nullptr;  // Newest first.
+    entry*          retry = nullptr;    // Oldest first; only used while holding
+    uint32          retry_count = 0;    // the lock.
+    volatile bool   has_retry = false;
+    SRWLOCK         lock = SRWLOCK_INIT;
+    HANDLE          wake = nullptr;
+    HANDLE          stopped = nullptr;
+    HANDLE          thread = nullptr;
+    volatile bool   shutdown = false;
+};
+
+//------------------------------------------------------------------------------
+// When the file can't be opened, lines are kept and retried this often, up to
+// this many lines.  Beyond that the oldest lines are dropped.
+static const DWORD c_retry_ms = 250;
+static const uint32 c_max_retry_lines = 4096;
+
 //------------------------------------------------------------------------------
 const file_logger* file_logger::s_this = nullptr;
+bool file_logger::s_unloading = false;
+
+//------------------------------------------------------------------------------
+// Writes lines that are still queued when the process exits, in case the
+// logger is never deleted.  The writer thread may have been terminated while
+// holding the lock, hence crashing=true.
+static struct flush_at_exit
+{
+    ~flush_at_exit() { logger::flush(true/*crashing*/); }
+} s_flush_at_exit;
 
 //------------------------------------------------------------------------------
 file_logger::file_logger(const char* log_path)
 {
     m_log_path << log_path;
     s_this = this;
+
+    m_writer = new writer(log_path);
+    m_writer->wake = CreateEvent(nullptr, false, false, nullptr);
+    m_writer->stopped = CreateEvent(nullptr, true, false, nullptr);
+    if (m_writer->wake && m_writer->stopped)
+        m_writer->thread = reinterpret_cast<HANDLE>(_beginthreadex(nullptr, 0, &writer::threadproc, m_writer, 0, nullptr));
 }
 
 //------------------------------------------------------------------------------
 file_logger::~file_logger()
 {
     s_this = nullptr;
+
+    writer* const w = m_writer;
+    bool stopped = true;
+    if (w->thread)
+    {
+        w->shutdown = true;
+        SetEvent(w->wake);
+        if (!s_unloading)
+        {
+            WaitForSingleObject(w->thread, INFINITE);
+        }
+        else
+        {
+            // While the DLL is unloading, the thread can't finish exiting
+            // because that needs the loader lock, so wait for it to leave its
+            // loop instead.  At process exit the thread has already been
+            // terminated, which signals its handle.  If neither happens soon,
+            // the thread may still be using the writer, so leave it allocated.
+            HANDLE handles[] = { w->stopped, w->thread };
+            if (WaitForMultipleObjects(sizeof_array(handles), handles, false, 500) == WAIT_TIMEOUT)
+                return;
+        }
+        stopped = (WaitForSingleObject(w->stopped, 0) == WAIT_OBJECT_0);
+    }
+
+    // If the thread was terminated, it may have been holding the lock.
+    if (w->flush(!stopped/*crashing*/))
+        writer::free_entries(w->retry);
+    writer::free_entries(static_cast<entry*>(InterlockedExchangePointer(reinterpret_cast<void* volatile*>(&w->pending), nullptr)));
+
+    if (w->thread)
+        CloseHandle(w->thread);
+    if (w->stopped)
+        CloseHandle(w->stopped);
+    if (w->wake)
+        CloseHandle(w->wake);
+    delete w;
 }
 
 //------------------------------------------------------------------------------
 void file_logger::emit_impl(const char* function, int32 line, const char* msg)
 {
-    FILE* file;
-
-    file = fopen(m_log_path.c_str(), "at");
-    if (file == nullptr)
-        return;
-
     str<24> func_name;
     func_name << function;
 
@@ -193,9 +297,193 @@ void file_logger::emit_impl(const char* function, int32 line, const char* msg)
 
     str<256> buffer;
     buffer.format("%04x %-24s %4d %s\n", pid, func_name.c_str(), line, msg);
-    fputs(buffer.c_str(), file);
 
-    fclose(file);
+    // The file used to be written in text mode, so translate newlines the
+    // same way.
+    uint32 newlines = 0;
+    for (const char* p = buffer.c_str(); *p; ++p)
+        newlines += (*p == '\n');
+
+    entry* e = static_cast<entry*>(malloc(sizeof(entry) + buffer.length() + newlines));
+    if (!e)
+        return;
+
+    char* out = e->text;
+    for (const char* p = buffer.c_str(); *p; ++p)
+    {
+        if (*p == '\n')
+            *(out++) = '\r';
+        *(out++) = *p;
+    }
+    e->len = uint32(out - e->text);
+
+    m_writer->push(e);
+}
+
+//------------------------------------------------------------------------------
+void file_logger::flush_impl(bool crashing)
+{
+    m_writer->flush(crashing);
+}
+
+//------------------------------------------------------------------------------
+// Any thread can push; only the thread holding the lock takes the list.
+void file_logger::writer::push(entry* e)
+{
+    entry* head;
+    do
+    {
+        head = pending;
+        e->next = head;
+    }
+    while (InterlockedCompareExchangePointer(reinterpret_cast<void* volatile*>(&pending), e, head) != head);
+
+    // Only wake the writer for the first line of a batch.  Without a writer
+    // thread, write synchronously.
+    if (!head)
+    {
+        if (thread)
+            SetEvent(wake);
+        else
+            flush(false/*crashing*/);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Returns whether the lock was acquired.
+bool file_logger::writer::flush(bool crashing)
+{
+    // The lock keeps batches in order.  When crashing, the lock may be held by
+    // a thread that's gone, so only wait briefly for it.  If it still can't be
+    // acquired, the holder may be in the middle of writing the file, so leave
+    // the lines queued rather than touch the file.
+    if (!crashing)
+        AcquireSRWLockExclusive(&lock);
+    else
+    {
+        bool locked;
+        for (int32 tries = 0; !(locked = !!TryAcquireSRWLockExclusive(&lock)) && tries < 50; ++tries)
+            Sleep(2);
+        if (!locked)
+            return false;
+    }
+
+    entry* list = static_cast<entry*>(InterlockedExchangePointer(reinterpret_cast<void* volatile*>(&pending), nullptr));
+
+    // The list is newest first; reverse it.
+    entry* ordered = nullptr;
+    uint32 count = 0;
+    while (list)
+    {
+        entry* next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+        ++count;
+    }
+
+    // Lines that couldn't be written last time go first.
+    if (retry)
+    {
+        entry* tail = retry;
+        while (tail->next)
+            tail = tail->next;
+        tail->next = ordered;
+        ordered = retry;
+        count += retry_count;
+        retry = nullptr;
+        retry_count = 0;
+    }
+
+    if (ordered)
+    {
+        if (write_batch(ordered))
+        {
+            free_entries(ordered);
+        }
+        else
+        {
+            // The file may be pending deletion after another session deleted
+            // it to start a new log; keep the lines and try again later.
+            for (; count > c_max_retry_lines; --count)
+            {
+                entry* next = ordered->next;
+                free(ordered);
+                ordered = next;
+            }
+            retry = ordered;
+            retry_count = count;
+        }
+    }
+    has_retry = !!retry;
+
+    ReleaseSRWLockExclusive(&lock);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// The file is opened for each batch and closed again, so that another session
+// can delete it to start a new log even on volumes without POSIX delete
+// semantics.
+bool file_logger::writer::write_batch(const entry* ordered)
+{
+    // FILE_APPEND_DATA makes each write append atomically, even when other
+    // sessions are writing to the same file.
+    wstr<> wpath(log_path.c_str());
+    HANDLE file = CreateFileW(wpath.c_str(), FILE_APPEND_DATA|SYNCHRONIZE, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    // Coalesce lines so a batch takes few writes.
+    DWORD written;
+    char buffer[8192];
+    uint32 used = 0;
+    for (; ordered; ordered = ordered->next)
+    {
+        if (used + ordered->len > sizeof(buffer))
+        {
+            WriteFile(file, buffer, used, &written, nullptr);
+            used = 0;
+        }
+        if (ordered->len > sizeof(buffer))
+            WriteFile(file, ordered->text, ordered->len, &written, nullptr);
+        else
+        {
+            memcpy(buffer + used, ordered->text, ordered->len);
+            used += ordered->len;
+        }
+    }
+    if (used)
+        WriteFile(file, buffer, used, &written, nullptr);
+
+    CloseHandle(file);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void file_logger::writer::free_entries(entry* list)
+{
+    while (list)
+    {
+        entry* next = list->next;
+        free(list);
+        list = next;
+    }
+}
+
+//------------------------------------------------------------------------------
+unsigned __stdcall file_logger::writer::threadproc(void* arg)
+{
+    writer* self = static_cast<writer*>(arg);
+    while (!self->shutdown)
+    {
+        WaitForSingleObject(self->wake, self->has_retry ? c_retry_ms : INFINITE);
+        self->flush(false/*crashing*/);
+    }
+
+    // The writer may be freed as soon as this is signaled.
+    SetEvent(self->stopped);
+    return 0;
 }
 
 
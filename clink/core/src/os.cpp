@@ -595,6 +595,34 @@ int32 get_file_size(const char* path)
     return ret;
 }
 
+//------------------------------------------------------------------------------
+void get_file_stamp(const wchar_t* path, file_stamp& out)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (GetFileAttributesExW(path, GetFileExInfoStandard, &data))
+    {
+        out.mtime = data.ftLastWriteTime;
+        out.size = (uint64(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        out.attr = data.dwFileAttributes;
+    }
+    else
+    {
+        out.mtime = {};
+        out.size = 0;
+        out.attr = INVALID_FILE_ATTRIBUTES;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool is_file_stamp_current(const wchar_t* path, const file_stamp& stamp)
+{
+    file_stamp now;
+    get_file_stamp(path, now);
+    return (now.attr == stamp.attr &&
+            now.size == stamp.size &&
+            CompareFileTime(&now.mtime, &stamp.mtime) == 0);
+}
+
 //------------------------------------------------------------------------------
 bool get_current_dir(str_base& out)
 {
@@ -0,0 +1,185 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "session_stats.h"
+#include "str.h"
+
+//------------------------------------------------------------------------------
+// One page, so fields can be added without changing the mapping size.
+static const uint32 c_mapping_size = 4096;
+static_assert(sizeof(session_stats) <= c_mapping_size, "session_stats is too large");
+
+//------------------------------------------------------------------------------
+static void get_mapping_name(int32 session_id, wstr_base& out)
+{
+    str<64> name;
+    name.format("Local\\clink_session_stats_%d", session_id);
+    out = name.c_str();
+}
+
+//------------------------------------------------------------------------------
+session_stats* get_session_stats()
+{
+    static session_stats* s_stats = nullptr;
+    static bool s_tried = false;
+    if (s_tried)
+        return s_stats;
+    s_tried = true;
+
+    wstr<64> name;
+    get_mapping_name(GetCurrentProcessId(), name);
+
+    // The handle stays open for the life of the process.
+    HANDLE h = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, c_mapping_size, name.c_str());
+    if (!h)
+        return nullptr;
+
+    void* view = MapViewOfFile(h, FILE_MAP_WRITE, 0, 0, c_mapping_size);
+    if (!view)
+    {
+        CloseHandle(h);
+        return nullptr;
+    }
+
+    s_stats = static_cast<session_stats*>(view);
+    s_stats->size = sizeof(*s_stats);
+    return s_stats;
+}
+
+//------------------------------------------------------------------------------
+bool read_session_stats(int32 session_id, session_stats& out)
+{
+    memset(&out, 0, sizeof(out));
+
+    wstr<64> name;
+    get_mapping_name(session_id, name);
+
+    HANDLE h = OpenFileMappingW(FILE_MAP_READ, false, name.c_str());
+    if (!h)
+        return false;
+
+    bool ok = false;
+    if (const void* view = MapViewOfFile(h, FILE_MAP_READ, 0, 0, c_mapping_size))
+    {
+        const uint32 size = static_cast<const session_stats*>(view)->size;
+        memcpy(&out, view, min<uint32>(size, sizeof(out)));
+        out.size = size;
+        UnmapViewOfFile(view);
+        ok = (size != 0);
+    }
+
+    CloseHandle(h);
+    return ok;
+}
+
+
+
+//------------------------------------------------------------------------------
+static double s_key_received = -1;
+
+//------------------------------------------------------------------------------
+static uint32 get_bucket(uint32 us)
+{
+    DWORD octave;
+    if (!_BitScanReverse(&octave, us))
+        return 0;
+
+    // Second half of the octave?
+    const bool upper = octave && (us & (1u << (octave - 1)));
+    return min<uint32>(octave * 2 + upper, c_latency_buckets - 1);
+}
+
+//------------------------------------------------------------------------------
+static uint32 get_bucket_limit(uint32 bucket)
+{
+    const uint32 octave = bucket / 2;
+    return (bucket & 1) ? (2u << octave) : (1u << octave) + (1u << octave >> 1);
+}
+
+//------------------------------------------------------------------------------
+void record_latency(latency_stage stage, double seconds)
+{
+    session_stats* stats = get_session_stats();
+    if (!stats || stage >= latency_stage::max)
+        return;
+
+    latency_histogram& h = stats->latency[uint32(stage)];
+    const uint32 us = uint32(clamp<double>(seconds * 1000000, 0, 0xffffffff));
+
+    if (h.count >= c_latency_window)
+    {
+        h.count = 0;
+        for (uint32& n : h.buckets)
+        {
+            n /= 2;
+            h.count += n;
+        }
+        h.prev_max_us = h.max_us;
+        h.max_us = 0;
+    }
+
+    ++h.buckets[get_bucket(us)];
+    ++h.count;
+    ++h.total;
+    if (h.max_us < us)
+        h.max_us = us;
+}
+
+//------------------------------------------------------------------------------
+const char* get_latency_stage_name(latency_stage stage)
+{
+    static const char* const c_names[] =
+    {
+        "input",
+        "dispatch",
+        "update_internal",
+        "generate",
+        "classify",
+        "suggest",
+        "prompt",
+        "display",
+    };
+    static_assert(sizeof_array(c_names) == uint32(latency_stage::max), "c_names must match latency_stage");
+
+    return (stage < latency_stage::max) ? c_names[uint32(stage)] : "";
+}
+
+//------------------------------------------------------------------------------
+uint32 get_latency_percentile(const latency_histogram& histogram, uint32 pct)
+{
+    if (!histogram.count)
+        return 0;
+
+    const uint64 rank = max<uint64>(1, (uint64(histogram.count) * pct + 99) / 100);
+    uint64 seen = 0;
+    for (uint32 i = 0; i < c_latency_buckets; ++i)
+    {
+        seen += histogram.buckets[i];
+        if (seen >= rank)
+            return min<uint32>(get_bucket_limit(i), get_latency_max(histogram));
+    }
+    return get_latency_max(histogram);
+}
+
+//------------------------------------------------------------------------------
+uint32 get_latency_max(const latency_histogram& histogram)
+{
+    return max<uint32>(histogram.max_us, histogram.prev_max_us);
+}
+
+//------------------------------------------------------------------------------
+void latency_key_received()
+{
+    s_key_received = os::clock();
+}
+
+//------------------------------------------------------------------------------
+void latency_key_handled()
+{
+    if (s_key_received < 0)
+        return;
+
+    record_latency(latency_stage::input, os::clock() - s_key_received);
+    s_key_received = -1;
+}
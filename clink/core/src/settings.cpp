@@ -6,16 +6,20 @@
 #include "str.h"
 #include "str_tokeniser.h"
 #include "str_compare.h"
+#include "str_unordered_set.h"
 #include "path.h"
 #include "os.h"
 
 #include <assert.h>
 #include <string>
 #include <map>
+#include <deque>
 #include <functional>
 
 #include "debugheap.h"
 
+#include "../../app/src/version.h" // Ugh.
+
 //------------------------------------------------------------------------------
 struct loaded_setting
 {
@@ -29,7 +33,22 @@ struct loaded_setting
 typedef std::map<std::string, loaded_setting> loaded_settings_map;
 
 //------------------------------------------------------------------------------
-static setting_map* g_setting_map = nullptr;
+// Every setting name is interned in a slot, and its handle is the slot's
+// position plus one.  The slots live in a deque so the names the index points
+// at don't move when more slots are added.
+struct setting_slot
+{
+    str<settings::c_max_len_name + 1, false> name;
+    setting*        current = nullptr;
+};
+
+typedef str_unordered_map_caseless<uint32> setting_index;
+
+//------------------------------------------------------------------------------
+static setting_map* g_setting_map = nullptr;    // Sorted, for enumerating.
+static setting_index* g_setting_index = nullptr;
+static std::deque<setting_slot>* g_setting_slots = nullptr;
+static uint32 s_generation = 0;
 static loaded_settings_map* g_loaded_settings = nullptr;
 static loaded_settings_map* g_custom_defaults = nullptr;
 static str_moveable* g_last_file = nullptr;
@@ -49,6 +68,20 @@ static auto& get_map()
     return *g_setting_map;
 }
 
+static auto& get_index()
+{
+    if (!g_setting_index)
+        g_setting_index = new setting_index;
+    return *g_setting_index;
+}
+
+static auto& get_slots()
+{
+    if (!g_setting_slots)
+        g_setting_slots = new std::deque<setting_slot>;
+    return *g_setting_slots;
+}
+
 static auto& get_loaded_map()
 {
     if (!g_loaded_settings)
@@ -65,6 +98,44 @@ static auto& get_custom_default_map()
 
 
 
+//------------------------------------------------------------------------------
+static uint32 find_handle(const char* name)
+{
+    auto& index = get_index();
+    auto i = index.find(name);
+    if (i != index.end())
+        return i->second;
+
+    size_t len = strlen(name);
+    if (len > settings::c_max_len_name)
+    {
+        str<> trunc_name(name);
+        trunc_name.truncate(settings::c_max_len_name);
+        return find_handle(trunc_name.c_str());
+    }
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static uint32 intern_handle(const char* name)
+{
+    uint32 handle = find_handle(name);
+    if (handle)
+        return handle;
+
+    auto& slots = get_slots();
+    slots.emplace_back();
+    setting_slot& slot = slots.back();
+    slot.name = name;
+
+    handle = uint32(slots.size());
+    get_index().emplace(slot.name.c_str(), handle);
+    return handle;
+}
+
+
+
 //------------------------------------------------------------------------------
 setting_iter::setting_iter(setting_map& map)
 : m_map(map)
@@ -323,6 +394,16 @@ static bool parse_ini(FILE* in, std::vector<settings::setting_name_value>& out)
     fclose(in);
 }
 
+//------------------------------------------------------------------------------
+// Mingw can't handle 'static' here, due to 'friend'.
+/*static*/ void set_parsed_color(setting_color& s, const char* color)
+{
+    // Same effect as setting the value the color was parsed from.
+    s.m_store.value = color;
+    s.m_save = true;
+    setting_color::changed();
+}
+
 
 
 namespace settings
@@ -337,19 +418,28 @@ setting_iter first()
 //------------------------------------------------------------------------------
 setting* find(const char* name)
 {
-    auto i = get_map().find(name);
-    if (i != get_map().end())
-        return i->second;
+    return from_handle(find_handle(name));
+}
 
-    size_t len = strlen(name);
-    if (len > c_max_len_name)
-    {
-        str<> trunc_name(name);
-        trunc_name.truncate(c_max_len_name);
-        return find(trunc_name.c_str());
-    }
+//------------------------------------------------------------------------------
+uint32 get_handle(const char* name)
+{
+    dbg_ignore_scope(snapshot, "Setting handles");
+    return intern_handle(name);
+}
+
+//------------------------------------------------------------------------------
+setting* from_handle(uint32 handle)
+{
+    if (!handle || !g_setting_slots || handle > g_setting_slots->size())
+        return nullptr;
+    return (*g_setting_slots)[handle - 1].current;
+}
 
-    return nullptr;
+//------------------------------------------------------------------------------
+uint32 get_generation()
+{
+    return s_generation;
 }
 
 //------------------------------------------------------------------------------
@@ -515,6 +605,328 @@ bool migrate_setting(const char* name, const char* value, std::vector<setting_na
     return true;
 }
 
+
+
+//------------------------------------------------------------------------------
+// After the settings file is loaded as text, a binary snapshot of what was
+// loaded is written next to it.  In the snapshot the names are already split
+// from the values and resolved to handles, and colors are already parsed.
+// It's used instead of the text files as long as the size and last write time
+// of the settings file and the custom defaults file are unchanged.  It's safe
+// to delete the snapshot.  Setting %CLINK_NO_SETTINGS_SNAPSHOT% (to any value)
+// turns it off; a setting can't control it since it's read before settings
+// are loaded.  The parsed colors are only valid for the parse_color() that
+// produced them, so a snapshot written by a different Clink version is
+// ignored.
+static const char c_snapshot_magic[4] = { 'C', 'L', 'S', 'S' };
+static const uint32 c_snapshot_format = 2;
+static const uint64 c_max_snapshot_size = 4 * 1024 * 1024;
+static const uint32 c_no_color = ~0u;
+
+// File times are only updated every few milliseconds, so a file that was
+// written very recently could be written again without its size or time
+// changing.  The snapshot isn't written until the files are this old (in
+// FILETIME units).
+static const uint64 c_racy_window = 2 * 10000000ull;
+
+//------------------------------------------------------------------------------
+struct file_stamp
+{
+    uint64          size = 0;
+    uint64          time = 0;
+};
+
+//------------------------------------------------------------------------------
+struct snapshot_header
+{
+    char            magic[4];
+    uint32          format;
+    uint32          version;        // CLINK_VERSION_ENCODED of the writer.
+    file_stamp      file;
+    file_stamp      default_file;
+    uint32          default_count;  // Records for custom defaults come first,
+    uint32          loaded_count;   // then records for the settings file.
+};
+
+//------------------------------------------------------------------------------
+struct snapshot_record
+{
+    uint32          handle;         // Only a hint; it's checked against the name.
+    uint32          name_len;       // The strings follow the record in this
+    uint32          value_len;      // order, each with a NUL terminator.
+    uint32          comment_len;
+    uint32          color_len;      // Parsed color, or c_no_color if none.
+};
+
+//------------------------------------------------------------------------------
+struct snapshot_entry
+{
+    uint32          handle;
+    const char*     name;
+    const char*     value;
+    const char*     comment;
+    const char*     color;
+};
+
+//------------------------------------------------------------------------------
+struct text_entry
+{
+    std::string     name;
+    std::string     value;
+    std::string     comment;
+};
+
+
+
+//------------------------------------------------------------------------------
+static void get_file_stamp(const char* file, file_stamp& stamp)
+{
+    stamp = file_stamp();
+    if (!file || !*file)
+        return;
+
+    wstr<280> wfile(file);
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(wfile.c_str(), GetFileExInfoStandard, &fad) ||
+        (fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        return;
+
+    stamp.size = (uint64(fad.nFileSizeHigh) << 32) | fad.nFileSizeLow;
+    stamp.time = (uint64(fad.ftLastWriteTime.dwHighDateTime) << 32) | fad.ftLastWriteTime.dwLowDateTime;
+}
+
+//------------------------------------------------------------------------------
+static bool is_snapshot_enabled()
+{
+    str<16> tmp;
+    return !os::get_env("CLINK_NO_SETTINGS_SNAPSHOT", tmp);
+}
+
+//------------------------------------------------------------------------------
+static void get_snapshot_file(const char* file, str_base& out)
+{
+    out = file;
+    out.concat(".snapshot");
+}
+
+//------------------------------------------------------------------------------
+static bool read_snapshot(const char* file, const file_stamp& stamp, const file_stamp& default_stamp,
+                          std::vector<char>& data, std::vector<snapshot_entry>& entries, uint32& default_count)
+{
+    str<280> snapshot_file;
+    get_snapshot_file(file, snapshot_file);
+
+    wstr<280> wfile(snapshot_file.c_str());
+    HANDLE h = CreateFileW(wfile.c_str(), GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool ok = false;
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(h, &size) &&
+        uint64(size.QuadPart) >= sizeof(snapshot_header) &&
+        uint64(size.QuadPart) <= c_max_snapshot_size)
+    {
+        DWORD read = 0;
+        data.resize(size_t(size.QuadPart));
+        ok = (ReadFile(h, data.data(), DWORD(data.size()), &read, nullptr) && read == data.size());
+    }
+
+    CloseHandle(h);
+    if (!ok)
+        return false;
+
+    snapshot_header header;
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, c_snapshot_magic, sizeof(header.magic)) != 0 ||
+        header.format != c_snapshot_format ||
+        header.version != CLINK_VERSION_ENCODED ||
+        header.file.size != stamp.size ||
+        header.file.time != stamp.time ||
+        header.default_file.size != default_stamp.size ||
+        header.default_file.time != default_stamp.time)
+        return false;
+
+    // Make sure every record is intact before any of them get used.
+    const char* walk = data.data() + sizeof(header);
+    const char* const end = data.data() + data.size();
+    auto take = [&walk, end] (uint32 len, const char*& out)
+    {
+        if (uint32(end - walk) <= len || walk[len])
+            return false;
+        out = walk;
+        walk += len + 1;
+        return true;
+    };
+
+    const uint32 count = header.default_count + header.loaded_count;
+    if (count < header.default_count || count > uint32(end - walk) / sizeof(snapshot_record))
+        return false;
+
+    entries.reserve(count);
+    for (uint32 i = 0; i < count; ++i)
+    {
+        snapshot_record record;
+        if (uint32(end - walk) < sizeof(record))
+            return false;
+        memcpy(&record, walk, sizeof(record));
+        walk += sizeof(record);
+
+        snapshot_entry entry = { record.handle };
+        if (!take(record.name_len, entry.name) ||
+            !take(record.value_len, entry.value) ||
+            !take(record.comment_len, entry.comment))
+            return false;
+        if (record.color_len == c_no_color)
+            entry.color = nullptr;
+        else if (!take(record.color_len, entry.color))
+            return false;
+
+        entries.push_back(entry);
+    }
+
+    default_count = header.default_count;
+    return walk == end;
+}
+
+//------------------------------------------------------------------------------
+static void append_record(std::vector<char>& data, uint32 handle, const char* name, const char* value, const char* comment, const char* color)
+{
+    snapshot_record record;
+    record.handle = handle;
+    record.name_len = uint32(strlen(name));
+    record.value_len = uint32(strlen(value));
+    record.comment_len = uint32(strlen(comment));
+    record.color_len = color ? uint32(strlen(color)) : c_no_color;
+
+    const char* const bytes = reinterpret_cast<const char*>(&record);
+    data.insert(data.end(), bytes, bytes + sizeof(record));
+    data.insert(data.end(), name, name + record.name_len + 1);
+    data.insert(data.end(), value, value + record.value_len + 1);
+    data.insert(data.end(), comment, comment + record.comment_len + 1);
+    if (color)
+        data.insert(data.end(), color, color + record.color_len + 1);
+}
+
+//------------------------------------------------------------------------------
+static void write_snapshot(const char* file, const file_stamp& stamp, const file_stamp& default_stamp,
+                           const std::vector<text_entry>& loaded)
+{
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    const uint64 now = (uint64(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    if (now < stamp.time + c_racy_window || (default_stamp.time && now < default_stamp.time + c_racy_window))
+        return;
+
+    const auto& defaults = get_custom_default_map();
+
+    snapshot_header header = {};
+    memcpy(header.magic, c_snapshot_magic, sizeof(header.magic));
+    header.format = c_snapshot_format;
+    header.version = CLINK_VERSION_ENCODED;
+    header.file = stamp;
+    header.default_file = default_stamp;
+    header.default_count = uint32(defaults.size());
+    header.loaded_count = uint32(loaded.size());
+
+    std::vector<char> data;
+    data.reserve(sizeof(header) + (defaults.size() + loaded.size()) * 64);
+    data.resize(sizeof(header));
+    memcpy(data.data(), &header, sizeof(header));
+
+    for (const auto& iter : defaults)
+        append_record(data, 0, iter.first.c_str(), iter.second.value.c_str(), "", nullptr);
+
+    str<> color;
+    for (const auto& entry : loaded)
+    {
+        const uint32 handle = find_handle(entry.name.c_str());
+        const setting* s = settings::from_handle(handle);
+        const bool parsed = (s && s->get_type() == setting::type_color && settings::parse_color(entry.value.c_str(), color));
+        append_record(data, handle, entry.name.c_str(), entry.value.c_str(), entry.comment.c_str(), parsed ? color.c_str() : nullptr);
+    }
+
+    if (data.size() > c_max_snapshot_size)
+        return;
+
+    // Write to a temporary file and then rename it, so that concurrent
+    // sessions never read a partially written snapshot.
+    str<280> snapshot_file;
+    get_snapshot_file(file, snapshot_file);
+    str<280> tmp;
+    tmp.format("%s.%x.tmp", snapshot_file.c_str(), GetCurrentProcessId());
+
+    wstr<280> wtmp(tmp.c_str());
+    HANDLE h = CreateFileW(wtmp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        return;
+
+    DWORD written = 0;
+    const bool ok = (WriteFile(h, data.data(), DWORD(data.size()), &written, nullptr) && written == data.size());
+    CloseHandle(h);
+
+    wstr<280> wfile(snapshot_file.c_str());
+    if (!ok || !MoveFileExW(wtmp.c_str(), wfile.c_str(), MOVEFILE_REPLACE_EXISTING))
+        DeleteFileW(wtmp.c_str());
+}
+
+//------------------------------------------------------------------------------
+static bool load_snapshot(const char* file, const file_stamp& stamp, const file_stamp& default_stamp)
+{
+    dbg_ignore_scope(snapshot, "Settings");
+
+    std::vector<char> data;
+    std::vector<snapshot_entry> entries;
+    uint32 default_count;
+    if (!read_snapshot(file, stamp, default_stamp, data, entries, default_count))
+        return false;
+
+    // This has the same effect as loading the custom defaults file and then
+    // the settings file; see load_custom_defaults() and set_setting().
+    auto& defaults = get_custom_default_map();
+    defaults.clear();
+    for (uint32 i = 0; i < default_count; ++i)
+    {
+        loaded_setting custom_default;
+        custom_default.value = entries[i].value;
+        defaults.emplace(entries[i].name, std::move(custom_default));
+    }
+
+    get_loaded_map().clear();
+
+    for (auto iter = settings::first(); auto* next = iter.next();)
+        next->set();
+
+    for (uint32 i = default_count; i < uint32(entries.size()); ++i)
+    {
+        const snapshot_entry& entry = entries[i];
+        setting* s = settings::from_handle(entry.handle);
+        if (!s || stricmp(s->get_name(), entry.name) != 0)
+            s = settings::find(entry.name);
+
+        if (!s)
+        {
+            loaded_setting loaded;
+            loaded.comment = entry.comment;
+            loaded.value = entry.value;
+            get_loaded_map().emplace(entry.name, std::move(loaded));
+        }
+        else if (entry.color && s->get_type() == setting::type_color)
+        {
+            set_parsed_color(*static_cast<setting_color*>(s), entry.color);
+        }
+        else
+        {
+            s->set(entry.value);
+        }
+    }
+
+    return true;
+}
+
+
+
 //------------------------------------------------------------------------------
 static bool save_internal(const char* file, bool migrating);
 
@@ -540,6 +952,18 @@ bool load(const char* file, const char* default_file)
             *g_last_default_file = default_file;
     }
 
+    // Stamp the files before reading them, so that if they change while being
+    // read the snapshot is stale rather than wrong.
+    file_stamp stamp;
+    file_stamp default_stamp;
+    if (file && is_snapshot_enabled())
+    {
+        get_file_stamp(file, stamp);
+        get_file_stamp(default_file, default_stamp);
+        if (stamp.time && load_snapshot(file, stamp, default_stamp))
+            return true;
+    }
+
     load_custom_defaults(default_file);
     get_loaded_map().clear();
 
@@ -568,7 +992,8 @@ bool load(const char* file, const char* default_file)
         migrating = true;
     }
 
-    load_internal(in, [migrating](const char* name, const char* value, const char* comment)
+    std::vector<text_entry> loaded;
+    load_internal(in, [migrating, &loaded](const char* name, const char* value, const char* comment)
     {
         // Migrate old setting.
         if (migrating)
@@ -584,6 +1009,7 @@ bool load(const char* file, const char* default_file)
 
         // Find the setting and set its value.
         set_setting(name, value, comment);
+        loaded.push_back({ name, value, comment });
     });
 
     // When migrating, ensure the new settings file is created so that the old
@@ -591,6 +1017,8 @@ bool load(const char* file, const char* default_file)
     // clean up the old settings file, so don't rely on it staying around.
     if (migrating)
         save_internal(file, migrating);
+    else if (stamp.time)
+        write_snapshot(file, stamp, default_stamp, loaded);
 
     return true;
 }
@@ -1269,15 +1697,21 @@ setting::setting(
     assert(!settings::find(m_name.c_str()));
 
     get_map()[m_name.c_str()] = this;
+    get_slots()[intern_handle(m_name.c_str()) - 1].current = this;
+    changed();
 }
 
 //------------------------------------------------------------------------------
 setting::~setting()
 {
-    auto i = settings::find(m_name.c_str());
+    const uint32 handle = find_handle(m_name.c_str());
 
-    if (i && i == this)
+    if (handle && settings::from_handle(handle) == this)
+    {
         get_map().erase(m_name.c_str());
+        get_slots()[handle - 1].current = nullptr;
+        changed();
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -1304,6 +1738,12 @@ const char* setting::get_long_desc() const
     return m_long_desc.c_str();
 }
 
+//------------------------------------------------------------------------------
+void setting::changed()
+{
+    ++s_generation;
+}
+
 //------------------------------------------------------------------------------
 const char* setting::get_loaded_value(const char* name)
 {
@@ -1607,6 +2047,7 @@ void setting_color::set()
     if (!custom_default || !parse(custom_default, m_store))
         parse(static_cast<const char*>(m_default), m_store);
     m_save = !is_default();
+    changed();
 }
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,307 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "task_pool.h"
+#include "debugheap.h"
+#include "os.h"
+
+#include <process.h>
+#include <assert.h>
+#include <deque>
+
+//------------------------------------------------------------------------------
+struct task_pool::work_item
+{
+    work_func       func;
+    double          queued_clock = 0;
+    bool            blocking = false;
+};
+
+//------------------------------------------------------------------------------
+struct task_pool::worker
+{
+    task_pool*      pool = nullptr;
+    HANDLE          thread = nullptr;
+    SRWLOCK         lock = SRWLOCK_INIT;
+    std::deque<work_item> items;
+};
+
+//------------------------------------------------------------------------------
+static uint32 default_max_workers()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return clamp<uint32>(info.dwNumberOfProcessors * 2, 4, 16);
+}
+
+
+
+//------------------------------------------------------------------------------
+task_pool::task_pool(uint32 max_workers, uint32 idle_timeout)
+: m_max_workers(max_workers ? max_workers : default_max_workers())
+, m_idle_timeout(idle_timeout)
+{
+}
+
+//------------------------------------------------------------------------------
+task_pool::~task_pool()
+{
+    // Let the workers finish the queued work, and wait for them to exit.
+    AcquireSRWLockExclusive(&m_lock);
+    m_shutdown = true;
+    WakeAllConditionVariable(&m_work_cv);
+    while (!m_workers.empty())
+        SleepConditionVariableSRW(&m_exit_cv, &m_lock, INFINITE, 0);
+    ReleaseSRWLockExclusive(&m_lock);
+}
+
+//------------------------------------------------------------------------------
+task_pool& task_pool::get()
+{
+    // The shared pool is intentionally never destroyed:  work may still be
+    // running when the process exits, and waiting for worker threads during
+    // DLL unload can deadlock.
+    static task_pool* s_pool = nullptr;
+    if (!s_pool)
+    {
+        dbg_ignore_scope(snapshot, "task_pool");
+        s_pool = new task_pool();
+    }
+    return *s_pool;
+}
+
+//------------------------------------------------------------------------------
+bool task_pool::submit(work_func&& func, bool blocking)
+{
+    work_item item;
+    item.func = std::move(func);
+    item.queued_clock = os::clock();
+    item.blocking = blocking;
+
+    AcquireSRWLockExclusive(&m_lock);
+
+    if (m_shutdown)
+    {
+        ReleaseSRWLockExclusive(&m_lock);
+        return false;
+    }
+
+    // Start another worker if there aren't enough idle workers to pick up the
+    // pending work.
+    if (m_idle_workers <= uint32(m_pending) && can_start_worker())
+        start_worker();
+
+    if (m_workers.empty())
+    {
+        ReleaseSRWLockExclusive(&m_lock);
+        return false;
+    }
+
+    worker* w = m_workers[m_next_worker++ % m_workers.size()].get();
+    AcquireSRWLockExclusive(&w->lock);
+    w->items.emplace_back(std::move(item));
+    ReleaseSRWLockExclusive(&w->lock);
+
+    const uint32 pending = uint32(InterlockedIncrement(&m_pending));
+    ++m_stats.submitted;
+    if (m_stats.peak_queued < pending)
+        m_stats.peak_queued = pending;
+
+    WakeConditionVariable(&m_work_cv);
+    ReleaseSRWLockExclusive(&m_lock);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void task_pool::get_stats(task_pool_stats& stats) const
+{
+    AcquireSRWLockShared(&m_lock);
+    stats = m_stats;
+    stats.workers = uint32(m_workers.size());
+    stats.queued = uint32(m_pending);
+    ReleaseSRWLockShared(&m_lock);
+}
+
+//------------------------------------------------------------------------------
+bool task_pool::can_start_worker() const
+{
+    // Caller must hold m_lock.  Workers running blocking work are mostly
+    // waiting, so they don't count against the maximum.
+    return m_workers.size() - m_stats.blocked_workers < m_max_workers;
+}
+
+//------------------------------------------------------------------------------
+bool task_pool::start_worker()
+{
+    // Caller must hold m_lock exclusively.
+    auto w = std::make_unique<worker>();
+    w->pool = this;
+
+    HANDLE h = reinterpret_cast<HANDLE>(_beginthreadex(nullptr, 0, &threadproc, w.get(), CREATE_SUSPENDED, nullptr));
+    if (!h)
+        return false;
+
+    w->thread = h;
+    m_workers.emplace_back(std::move(w));
+    if (m_stats.peak_workers < m_workers.size())
+        m_stats.peak_workers = uint32(m_workers.size());
+
+    ResumeThread(h);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool task_pool::pop_local(worker* w, work_item& item)
+{
+    bool found = false;
+    AcquireSRWLockExclusive(&w->lock);
+    if (!w->items.empty())
+    {
+        item = std::move(w->items.front());
+        w->items.pop_front();
+        found = true;
+    }
+    ReleaseSRWLockExclusive(&w->lock);
+    return found;
+}
+
+//------------------------------------------------------------------------------
+bool task_pool::steal(worker* w, work_item& item)
+{
+    bool found = false;
+    AcquireSRWLockShared(&m_lock);
+
+    // Start with the worker after this one, so that thieves spread out.
+    const size_t count = m_workers.size();
+    size_t self = 0;
+    while (self < count && m_workers[self].get() != w)
+        ++self;
+
+    for (size_t i = 1; !found && i < count; ++i)
+    {
+        worker* victim = m_workers[(self + i) % count].get();
+        AcquireSRWLockExclusive(&victim->lock);
+        if (!victim->items.empty())
+        {
+            item = std::move(victim->items.back());
+            victim->items.pop_back();
+            found = true;
+        }
+        ReleaseSRWLockExclusive(&victim->lock);
+    }
+
+    ReleaseSRWLockShared(&m_lock);
+    return found;
+}
+
+//------------------------------------------------------------------------------
+void task_pool::run_item(work_item& item, bool stolen)
+{
+    InterlockedDecrement(&m_pending);
+
+    const double start = os::clock();
+    const double latency = start - item.queued_clock;
+
+    AcquireSRWLockExclusive(&m_lock);
+    ++m_stats.busy_workers;
+    if (stolen)
+        ++m_stats.stolen;
+    m_stats.total_latency += latency;
+    if (m_stats.max_latency < latency)
+        m_stats.max_latency = latency;
+    if (item.blocking)
+    {
+        // This worker no longer counts against the maximum, so start another
+        // worker if there's pending work that no idle worker will pick up.
+        ++m_stats.blocked_workers;
+        if (!m_shutdown && m_idle_workers < uint32(m_pending) && can_start_worker())
+            start_worker();
+    }
+    ReleaseSRWLockExclusive(&m_lock);
+
+    item.func();
+    item.func = nullptr;    // Release anything the work captured.
+
+    const double runtime = os::clock() - start;
+
+    AcquireSRWLockExclusive(&m_lock);
+    --m_stats.busy_workers;
+    if (item.blocking)
+        --m_stats.blocked_workers;
+    ++m_stats.completed;
+    m_stats.total_runtime += runtime;
+    if (m_stats.max_runtime < runtime)
+        m_stats.max_runtime = runtime;
+    ReleaseSRWLockExclusive(&m_lock);
+}
+
+//------------------------------------------------------------------------------
+void task_pool::worker_loop(worker* w)
+{
+    work_item item;
+    while (true)
+    {
+        if (pop_local(w, item))
+        {
+            run_item(item, false);
+            continue;
+        }
+        if (steal(w, item))
+        {
+            run_item(item, true);
+            continue;
+        }
+
+        AcquireSRWLockExclusive(&m_lock);
+
+        bool retire = false;
+        while (!m_pending && !retire)
+        {
+            if (m_shutdown)
+            {
+                retire = true;
+                break;
+            }
+
+            ++m_idle_workers;
+            const DWORD timeout = m_idle_timeout ? m_idle_timeout : INFINITE;
+            const bool woken = !!SleepConditionVariableSRW(&m_work_cv, &m_lock, timeout, 0);
+            --m_idle_workers;
+
+            // Keep one worker around, so bursts don't always pay for starting
+            // a thread.
+            if (!woken && !m_pending && m_workers.size() > 1)
+                retire = true;
+        }
+
+        if (retire)
+        {
+            // Nothing is pending, so this worker's queue is empty, and holding
+            // m_lock prevents new work from being queued to it.
+            assert(w->items.empty());
+            CloseHandle(w->thread);
+            for (auto iter = m_workers.begin(); iter != m_workers.end(); ++iter)
+            {
+                if (iter->get() == w)
+                {
+                    m_workers.erase(iter);
+                    break;
+                }
+            }
+            WakeAllConditionVariable(&m_exit_cv);
+            ReleaseSRWLockExclusive(&m_lock);
+            return;
+        }
+
+        ReleaseSRWLockExclusive(&m_lock);
+    }
+}
+
+//------------------------------------------------------------------------------
+unsigned __stdcall task_pool::threadproc(void* arg)
+{
+    worker* w = static_cast<worker*>(arg);
+    w->pool->worker_loop(w);
+    return 0;
+}
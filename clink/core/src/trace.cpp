@@ -0,0 +1,216 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "trace.h"
+#include "debugheap.h"
+#include "str.h"
+#include "str_unordered_set.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Each thread writes only to its own ring, so recording needs no lock.  The
+// writer publishes each event by advancing head; the reader takes at most
+// the most recent c_capacity events.  An event being overwritten while it's
+// read can come out garbled, which is acceptable for a diagnostic trace.
+struct trace_event
+{
+    const char*         name;
+    double              begin;
+    double              end;
+};
+
+struct trace_ring
+{
+    uint32              tid;
+    std::atomic<uint32> head { 0 };
+    uint32              tail = 0;       // Events before this were cleared.
+    trace_event         events[trace::c_capacity];
+};
+
+struct retired_event
+{
+    uint32              tid;
+    trace_event         event;
+};
+
+static_assert((trace::c_capacity & (trace::c_capacity - 1)) == 0, "c_capacity must be a power of 2");
+
+//------------------------------------------------------------------------------
+// When a thread exits, its ring is freed and the events it still holds move
+// to s_retired, so the trace can be written after the thread exits.  At most
+// c_capacity retired events are kept, across all exited threads.
+struct ring_owner
+{
+                        ~ring_owner();
+    trace_ring*         ring = nullptr;
+};
+
+//------------------------------------------------------------------------------
+static std::mutex s_mutex;
+static std::vector<trace_ring*> s_rings;
+static std::deque<retired_event> s_retired;
+static str_unordered_set s_names;
+static threadlocal trace_ring* ts_ring = nullptr;
+static thread_local ring_owner ts_ring_owner;
+
+//------------------------------------------------------------------------------
+ring_owner::~ring_owner()
+{
+    if (!ring)
+        return;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    for (auto iter = s_rings.begin(); iter != s_rings.end(); ++iter)
+    {
+        if (*iter == ring)
+        {
+            s_rings.erase(iter);
+            break;
+        }
+    }
+
+    const uint32 head = ring->head.load(std::memory_order_acquire);
+    uint32 i = ring->tail;
+    if (head - i > trace::c_capacity)
+        i = head - trace::c_capacity;
+    for (; i != head; ++i)
+        s_retired.push_back({ ring->tid, ring->events[i & (trace::c_capacity - 1)] });
+    while (s_retired.size() > trace::c_capacity)
+        s_retired.pop_front();
+
+    ts_ring = nullptr;
+    delete ring;
+    ring = nullptr;
+}
+
+
+
+namespace trace
+{
+
+//------------------------------------------------------------------------------
+volatile bool s_enabled = false;
+
+//------------------------------------------------------------------------------
+void enable(bool enable)
+{
+    s_enabled = enable;
+}
+
+//------------------------------------------------------------------------------
+void record(const char* name, double begin, double end)
+{
+    trace_ring* ring = ts_ring;
+    if (!ring)
+    {
+        // The ring is freed when the thread exits; see ring_owner.
+        dbg_ignore_scope(snapshot, "Trace ring");
+        ring = new trace_ring;
+        ring->tid = GetCurrentThreadId();
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_rings.push_back(ring);
+        ts_ring = ring;
+        ts_ring_owner.ring = ring;
+    }
+
+    const uint32 head = ring->head.load(std::memory_order_relaxed);
+    trace_event& event = ring->events[head & (c_capacity - 1)];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+const char* intern(const char* name)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    auto found = s_names.find(name);
+    if (found != s_names.end())
+        return *found;
+
+    dbg_ignore_scope(snapshot, "Trace names");
+    const size_t len = strlen(name);
+    char* copy = static_cast<char*>(malloc(len + 1));
+    if (!copy)
+        return "";
+    memcpy(copy, name, len + 1);
+    s_names.insert(copy);
+    return copy;
+}
+
+//------------------------------------------------------------------------------
+void clear()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (trace_ring* ring : s_rings)
+        ring->tail = ring->head.load(std::memory_order_acquire);
+    s_retired.clear();
+}
+
+//------------------------------------------------------------------------------
+static void write_json_string(FILE* f, const char* s)
+{
+    fputc('"', f);
+    for (; *s; ++s)
+    {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', f);
+        if (uint8(*s) < 0x20)
+            fprintf(f, "\\u%04x", uint8(*s));
+        else
+            fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+//------------------------------------------------------------------------------
+static void write_json_event(FILE* f, const trace_event& event, DWORD pid, uint32 tid, bool& first)
+{
+    fputs(first ? "{\"name\":" : ",\n{\"name\":", f);
+    write_json_string(f, event.name);
+    // Chrome trace timestamps are in microseconds.
+    fprintf(f, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u}",
+            event.begin * 1e6, (event.end - event.begin) * 1e6, pid, tid);
+    first = false;
+}
+
+//------------------------------------------------------------------------------
+bool write_json(const char* file)
+{
+    FILE* f = fopen(file, "w");
+    if (!f)
+        return false;
+
+    const DWORD pid = GetCurrentProcessId();
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    bool first = true;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (const retired_event& retired : s_retired)
+        write_json_event(f, retired.event, pid, retired.tid, first);
+    for (const trace_ring* ring : s_rings)
+    {
+        const uint32 head = ring->head.load(std::memory_order_acquire);
+        uint32 i = ring->tail;
+        if (head - i > c_capacity)
+            i = head - c_capacity;
+
+        for (; i != head; ++i)
+            write_json_event(f, ring->events[i & (c_capacity - 1)], pid, ring->tid, first);
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    return true;
+}
+
+}; // namespace trace
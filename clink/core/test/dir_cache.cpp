@@ -0,0 +1,159 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "fs_fixture.h"
+
+#include <core/dir_cache.h>
+#include <core/globber.h>
+#include <core/settings.h>
+#include <core/str.h>
+
+#include <algorithm>
+#include <vector>
+
+//------------------------------------------------------------------------------
+static void set_files_cache(bool enabled)
+{
+    setting* setting = settings::find("files.cache");
+    REQUIRE(setting);
+    setting->set(enabled ? "true" : "false");
+}
+
+//------------------------------------------------------------------------------
+// Enables the cache for the duration of a test, and leaves it empty and
+// disabled afterwards.
+struct dir_cache_scope
+{
+    dir_cache_scope()   { dir_cache::get().clear(); set_files_cache(true); }
+    ~dir_cache_scope()  { set_files_cache(false); dir_cache::get().clear(); }
+};
+
+//------------------------------------------------------------------------------
+static std::vector<str_moveable> glob(const char* pattern, bool hidden=false, bool dirs=true)
+{
+    std::vector<str_moveable> out;
+
+    globber globber(pattern);
+    globber.hidden(hidden);
+    globber.directories(dirs);
+
+    str<> file;
+    while (globber.next(file))
+        out.emplace_back(file.c_str());
+
+    std::sort(out.begin(), out.end(), [](const str_moveable& a, const str_moveable& b) {
+        return strcmp(a.c_str(), b.c_str()) < 0;
+    });
+    return out;
+}
+
+//------------------------------------------------------------------------------
+static bool same(const std::vector<str_moveable>& a, const std::vector<str_moveable>& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (!a[i].equals(b[i].c_str()))
+            return false;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Directory cache")
+{
+    fs_fixture fs;
+    dir_cache_scope scope;
+
+    dir_cache_stats stats;
+
+    SECTION("Hit")
+    {
+        glob("*");
+        glob("file*");
+        dir_cache::get().get_stats(stats);
+        REQUIRE(stats.listings == 1);
+        REQUIRE(stats.misses == 1);
+        REQUIRE(stats.hits == 1);
+
+        glob("dir1\\*");
+        dir_cache::get().get_stats(stats);
+        REQUIRE(stats.listings == 2);
+        REQUIRE(stats.misses == 2);
+    }
+
+    SECTION("Same results")
+    {
+        static const char* const patterns[] = {
+            "*", "*.*", "file*", "FILE*", "case_map*", "dir1\\*", "dir1\\f*", "nomatch*", "dir2\\*",
+        };
+
+        for (const char* pattern : patterns)
+        {
+            for (int32 flags = 0; flags < 4; ++flags)
+            {
+                const bool hidden = !!(flags & 1);
+                const bool dirs = !!(flags & 2);
+
+                set_files_cache(true);
+                std::vector<str_moveable> cached = glob(pattern, hidden, dirs);
+                set_files_cache(false);
+                std::vector<str_moveable> uncached = glob(pattern, hidden, dirs);
+
+                REQUIRE(same(cached, uncached), [&] () {
+                    printf("pattern: %s, hidden %d, dirs %d\n", pattern, hidden, dirs);
+                });
+            }
+        }
+
+        dir_cache::get().get_stats(stats);
+        REQUIRE(stats.hits > 0);
+    }
+
+    SECTION("Invalidated")
+    {
+        REQUIRE(glob("new*").empty());
+
+        FILE* f = fopen("new_file", "w");
+        REQUIRE(f);
+        fclose(f);
+
+        std::vector<str_moveable> files = glob("new*");
+        REQUIRE(files.size() == 1);
+        REQUIRE(files[0].equals("new_file"));
+
+        dir_cache::get().get_stats(stats);
+        REQUIRE(stats.invalidated == 1);
+        REQUIRE(stats.listings == 1);
+
+        _unlink("new_file");
+        REQUIRE(glob("new*").empty());
+    }
+
+    SECTION("Disabled")
+    {
+        set_files_cache(false);
+        REQUIRE(glob("file*").size() == 2);
+
+        dir_cache::get().get_stats(stats);
+        REQUIRE(stats.listings == 0);
+        REQUIRE(stats.misses == 0);
+    }
+
+    SECTION("Explicit")
+    {
+        // Globbers on other threads are told whether to use the cache, since
+        // they can't read the setting.
+        set_files_cache(false);
+        globber globber("file*", true);
+        str<> file;
+        while (globber.next(file))
+        {
+        }
+
+        dir_cache::get().get_stats(stats);
+        REQUIRE(stats.listings == 1);
+    }
+}
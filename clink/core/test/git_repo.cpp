@@ -0,0 +1,330 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "fs_fixture.h"
+
+#include <core/git_repo.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+static const char c_oid_main[] = "1111111111111111111111111111111111111111";
+static const char c_oid_packed[] = "2222222222222222222222222222222222222222";
+static const char c_oid_origin[] = "3333333333333333333333333333333333333333";
+
+//------------------------------------------------------------------------------
+struct git_repo_cache_scope
+{
+    git_repo_cache_scope()  { git_repo_cache::get().clear(); }
+    ~git_repo_cache_scope() { git_repo_cache::get().clear(); }
+};
+
+//------------------------------------------------------------------------------
+static void write_file(const char* name, const char* content, size_t len=-1)
+{
+    str<> dir;
+    path::get_directory(name, dir);
+    os::make_dir(dir.c_str());
+
+    FILE* f = fopen(name, "wb");
+    REQUIRE(f);
+    fwrite(content, 1, (len == size_t(-1)) ? strlen(content) : len, f);
+    fclose(f);
+}
+
+//------------------------------------------------------------------------------
+static std::shared_ptr<const git_repo_state> get_state(const char* git_dir=".git")
+{
+    return git_repo_cache::get().get_state(git_dir);
+}
+
+//------------------------------------------------------------------------------
+struct index_entry
+{
+    const char*     name;
+    uint32          stage;
+};
+
+//------------------------------------------------------------------------------
+// Builds an index file containing the entries (with fake stat data and object
+// ids), in either v2 or v4 format.
+static void write_index(const char* name, const index_entry* entries, uint32 count, uint32 version)
+{
+    std::vector<char> data;
+    auto be32 = [&data](uint32 n) {
+        data.push_back(char(n >> 24));
+        data.push_back(char(n >> 16));
+        data.push_back(char(n >> 8));
+        data.push_back(char(n));
+    };
+
+    data.insert(data.end(), { 'D', 'I', 'R', 'C' });
+    be32(version);
+    be32(count);
+
+    const char* prev = "";
+    for (uint32 i = 0; i < count; ++i)
+    {
+        const size_t start = data.size();
+        const uint32 len = uint32(strlen(entries[i].name));
+        const uint32 flags = (entries[i].stage << 12) | min<uint32>(len, 0xfff);
+
+        data.insert(data.end(), 40 + 20, '\0');
+        data.push_back(char(flags >> 8));
+        data.push_back(char(flags));
+
+        if (version >= 4)
+        {
+            uint32 common = 0;
+            while (prev[common] && prev[common] == entries[i].name[common])
+                ++common;
+            const uint32 strip = uint32(strlen(prev)) - common;
+            REQUIRE(strip < 0x80);
+            data.push_back(char(strip));
+            data.insert(data.end(), entries[i].name + common, entries[i].name + len + 1);
+            prev = entries[i].name;
+        }
+        else
+        {
+            data.insert(data.end(), entries[i].name, entries[i].name + len);
+            const size_t padded = (data.size() - start + 8) & ~size_t(7);
+            data.insert(data.end(), start + padded - data.size(), '\0');
+        }
+    }
+
+    data.insert(data.end(), 20, '\0');
+    write_file(name, data.data(), data.size());
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Git repo state")
+{
+    static const char* repo_fs[] = {
+        ".git/HEAD",
+        ".git/refs/heads/main",
+        ".git/refs/tags/.",
+        ".git/objects/.",
+        nullptr,
+    };
+
+    fs_fixture fs(repo_fs);
+    git_repo_cache_scope scope;
+
+    write_file(".git/HEAD", "ref: refs/heads/main\n");
+    str<> main_ref;
+    main_ref.format("%s\n", c_oid_main);
+    write_file(".git/refs/heads/main", main_ref.c_str());
+
+    str<> packed_refs;
+    packed_refs.format("# pack-refs with: peeled fully-peeled sorted \n"
+                       "%s refs/heads/packed\n"
+                       "%s refs/remotes/origin/main\n"
+                       "^%s\n",
+                       c_oid_packed, c_oid_origin, c_oid_packed);
+    write_file(".git/packed-refs", packed_refs.c_str());
+
+    SECTION("Branch")
+    {
+        auto state = get_state();
+        REQUIRE(state);
+        REQUIRE(state->branch.equals("main"));
+        REQUIRE(state->head.equals(c_oid_main));
+        REQUIRE(!state->detached);
+        REQUIRE(!state->reftable);
+        REQUIRE(state->upstream.empty());
+        REQUIRE(state->action.empty());
+        REQUIRE(state->stashes == 0);
+        REQUIRE(git_repo_cache::get().get_conflicts(".git") == 0);
+    }
+
+    SECTION("Packed ref")
+    {
+        write_file(".git/HEAD", "ref: refs/heads/packed\n");
+        auto state = get_state();
+        REQUIRE(state);
+        REQUIRE(state->branch.equals("packed"));
+        REQUIRE(state->head.equals(c_oid_packed));
+    }
+
+    SECTION("Unborn branch")
+    {
+        write_file(".git/HEAD", "ref: refs/heads/new\n");
+        auto state = get_state();
+        REQUIRE(state);
+        REQUIRE(state->branch.equals("new"));
+        REQUIRE(state->head.empty());
+    }
+
+    SECTION("Detached")
+    {
+        write_file(".git/HEAD", c_oid_packed);
+        auto state = get_state();
+        REQUIRE(state);
+        REQUIRE(state->detached);
+        REQUIRE(state->branch.equals("2222222"));
+        REQUIRE(state->head.equals(c_oid_packed));
+    }
+
+    SECTION("Reftable")
+    {
+        write_file(".git/HEAD", "ref: refs/heads/.invalid\n");
+        auto state = get_state();
+        REQUIRE(state);
+        REQUIRE(state->reftable);
+        REQUIRE(state->branch.empty());
+    }
+
+    SECTION("Upstream")
+    {
+        write_file(".git/config",
+                   "[core]\n"
+                   "\trepositoryformatversion = 0\n"
+                   "[remote \"origin\"]\n"
+                   "\turl = https://example.com/repo.git\n"
+                   "\tfetch = +refs/heads/*:refs/remotes/origin/*\n"
+                   "[branch \"main\"]\n"
+                   "\tremote = origin ; comment\n"
+                   "\tMerge = \"refs/heads/main\"\n");
+
+        auto state = get_state();
+        REQUIRE(state);
+        REQUIRE(state->upstream.equals("origin/main"));
+        REQUIRE(state->upstream_head.equals(c_oid_origin));
+
+        // Same commit as upstream.  (Without a newline, so the size changes
+        // even if the last write time has coarse granularity.)
+        write_file(".git/refs/heads/main", c_oid_origin);
+        state = get_state();
+        REQUIRE(state->head.equals(state->upstream_head.c_str()));
+
+        // With a custom fetch refspec the upstream ref can't be derived.
+        write_file(".git/config",
+                   "[remote \"origin\"]\n"
+                   "\tfetch = +refs/heads/*:refs/remotes/mirror/*\n"
+                   "[branch \"main\"]\n"
+                   "\tremote = origin\n"
+                   "\tmerge = refs/heads/main\n");
+        state = get_state();
+        REQUIRE(state->upstream.empty());
+        REQUIRE(state->upstream_head.empty());
+    }
+
+    SECTION("Action")
+    {
+        auto state = get_state();
+        REQUIRE(state->action.empty());
+
+        write_file(".git/MERGE_HEAD", c_oid_packed);
+        state = get_state();
+        REQUIRE(state->action.equals("merging"));
+        REQUIRE(state->step == 0);
+
+        write_file(".git/rebase-merge/interactive", "");
+        write_file(".git/rebase-merge/msgnum", "2\n");
+        write_file(".git/rebase-merge/end", "5\n");
+        state = get_state();
+        REQUIRE(state->action.equals("rebase-i"));
+        REQUIRE(state->step == 2);
+        REQUIRE(state->total == 5);
+    }
+
+    SECTION("Stashes")
+    {
+        str<> log;
+        for (int32 i = 0; i < 3; ++i)
+            log.format_append("%s %s A U Thor <a@example.com> 1700000000 +0000\tWIP on main: stash %d\n", c_oid_main, c_oid_packed, i);
+        write_file(".git/logs/refs/stash", log.c_str());
+
+        auto state = get_state();
+        REQUIRE(state->stashes == 3);
+    }
+
+    SECTION("Conflicts")
+    {
+        static const index_entry entries[] = {
+            { "a.txt", 0 },
+            { "dir/b.txt", 1 },
+            { "dir/b.txt", 2 },
+            { "dir/b.txt", 3 },
+            { "dir/c.txt", 2 },
+            { "dir/c.txt", 3 },
+            { "dir/d.txt", 0 },
+        };
+
+        SECTION("v2")
+        {
+            write_index(".git/index", entries, sizeof_array(entries), 2);
+        }
+
+        SECTION("v4")
+        {
+            write_index(".git/index", entries, sizeof_array(entries), 4);
+        }
+
+        REQUIRE(git_repo_cache::get().get_conflicts(".git") == 2);
+
+        // Only the conflict count depends on the index.
+        git_repo_stats stats;
+        get_state();
+        write_index(".git/index", entries, 1, 2);
+        get_state();
+        git_repo_cache::get().get_stats(stats);
+        REQUIRE(stats.invalidated == 0);
+        REQUIRE(git_repo_cache::get().get_conflicts(".git") == 0);
+    }
+
+    SECTION("Worktree")
+    {
+        write_file(".git/worktrees/wt/HEAD", "ref: refs/heads/packed\n");
+        write_file(".git/worktrees/wt/commondir", "../..\n");
+        write_file(".git/worktrees/wt/MERGE_HEAD", c_oid_main);
+
+        auto state = get_state(".git/worktrees/wt");
+        REQUIRE(state);
+        REQUIRE(state->branch.equals("packed"));
+        REQUIRE(state->head.equals(c_oid_packed));
+        REQUIRE(state->action.equals("merging"));
+
+        // The main worktree isn't merging.
+        state = get_state();
+        REQUIRE(state->action.empty());
+    }
+
+    SECTION("Not a repo")
+    {
+        REQUIRE(!get_state("."));
+        write_file(".git/HEAD", "garbage\n");
+        REQUIRE(!get_state());
+    }
+
+    SECTION("Cached")
+    {
+        git_repo_stats stats;
+
+        auto state = get_state();
+        REQUIRE(state->branch.equals("main"));
+        get_state();
+        git_repo_cache::get().get_stats(stats);
+        REQUIRE(stats.misses == 1);
+        REQUIRE(stats.hits == 1);
+        REQUIRE(stats.repos == 1);
+
+        write_file(".git/HEAD", "ref: refs/heads/packed\n");
+        state = get_state();
+        REQUIRE(state->branch.equals("packed"));
+        git_repo_cache::get().get_stats(stats);
+        REQUIRE(stats.invalidated == 1);
+        REQUIRE(stats.repos == 1);
+
+        // A ref that didn't exist is noticed when it's created.
+        write_file(".git/refs/heads/packed", main_ref.c_str());
+        state = get_state();
+        REQUIRE(state->head.equals(c_oid_main));
+    }
+}
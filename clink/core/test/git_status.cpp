@@ -0,0 +1,99 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include <core/git_status.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("git status porcelain parser")
+{
+    static const char c_output[] =
+        "# branch.oid 0123456789abcdef0123456789abcdef01234567\n"
+        "# branch.head main\n"
+        "# branch.upstream origin/main\n"
+        "# branch.ab +3 -12\n"
+        "# stash 2\n"
+        "1 .M N... 100644 100644 100644 aaaa bbbb modified.txt\n"
+        "1 M. N... 100644 100644 100644 aaaa bbbb staged.txt\n"
+        "1 MM N... 100644 100644 100644 aaaa bbbb both.txt\n"
+        "1 A. N... 000000 100644 100644 0000 bbbb added.txt\n"
+        "1 AD N... 000000 100644 000000 0000 bbbb added_then_deleted.txt\n"
+        "1 .D N... 100644 100644 000000 aaaa aaaa deleted.txt\n"
+        "1 D. N... 100644 000000 000000 aaaa 0000 staged_deleted.txt\n"
+        "1 .T N... 100644 100644 120000 aaaa aaaa type.txt\n"
+        "2 R. N... 100644 100644 100644 aaaa aaaa R100 new.txt\told.txt\n"
+        "2 RM N... 100644 100644 100644 aaaa aaaa R90 new2.txt\told2.txt\n"
+        "u UU N... 100644 100644 100644 100644 aaaa bbbb cccc conflict.txt\n"
+        "? untracked.txt\r\n"
+        "? untracked_dir/\n"
+        "! ignored.txt\n"
+        "? no_newline.txt";
+
+    const uint32 len = sizeof(c_output) - 1;
+
+    git_status_parser parser;
+
+    SECTION("Whole")
+    {
+        parser.feed(c_output, len);
+    }
+
+    SECTION("Chunks")
+    {
+        // Lines split across chunks are reassembled.
+        for (uint32 chunk : { 1u, 7u, 64u })
+        {
+            git_status_parser chunked;
+            for (uint32 i = 0; i < len; i += chunk)
+                chunked.feed(c_output + i, min(chunk, len - i));
+            chunked.finish();
+            REQUIRE(chunked.get_counts().lines == 20);
+            REQUIRE(chunked.get_counts().w_untracked == 3);
+            REQUIRE(chunked.get_counts().s_rename == 2);
+            REQUIRE(chunked.get_counts().head.equals("main"));
+        }
+
+        parser.feed(c_output, len);
+    }
+
+    parser.finish();
+    const git_status_counts& counts = parser.get_counts();
+
+    REQUIRE(counts.lines == 20);
+    REQUIRE(counts.has_header);
+    REQUIRE(counts.oid.equals("0123456789abcdef0123456789abcdef01234567"));
+    REQUIRE(counts.head.equals("main"));
+    REQUIRE(counts.upstream.equals("origin/main"));
+    REQUIRE(counts.ahead == 3);
+    REQUIRE(counts.behind == 12);
+
+    REQUIRE(counts.w_add == 0);
+    REQUIRE(counts.w_modify == 4);      // .M MM .T RM
+    REQUIRE(counts.w_delete == 2);      // AD .D
+    REQUIRE(counts.w_conflict == 1);
+    REQUIRE(counts.w_untracked == 3);
+
+    REQUIRE(counts.s_add == 2);         // A. AD
+    REQUIRE(counts.s_modify == 2);      // M. MM
+    REQUIRE(counts.s_delete == 1);      // D.
+    REQUIRE(counts.s_rename == 2);      // R. RM
+
+    REQUIRE(counts.t_add == 1);         // A.
+    REQUIRE(counts.t_delete == 3);      // AD .D D.
+    REQUIRE(counts.t_modify == 6);      // .M M. MM .T R. RM
+
+    REQUIRE(counts.only_staged == 4);   // M. A. D. R.
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("git status porcelain parser, no header")
+{
+    git_status_parser parser;
+    parser.feed("? a\n? b\n", 8);
+    parser.finish();
+
+    REQUIRE(!parser.get_counts().has_header);
+    REQUIRE(parser.get_counts().w_untracked == 2);
+}
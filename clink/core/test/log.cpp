@@ -0,0 +1,125 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "fs_fixture.h"
+
+#include <core/log.h>
+#include <core/str.h>
+
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+static void read_file(const char* name, str_base& out)
+{
+    out.clear();
+    FILE* f = fopen(name, "rb");
+    if (!f)
+        return;
+    char buffer[1024];
+    size_t len;
+    while ((len = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        out.concat(buffer, int32(len));
+    fclose(f);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("File logger")
+{
+    fs_fixture fs;
+
+    REQUIRE(!logger::get());
+    file_logger* log = new file_logger("test.log");
+
+    str_moveable content;
+    str<> expected;
+
+    SECTION("Format")
+    {
+        const int32 line = __LINE__ + 1;
+        LOG("hello %d", 42);
+        LOG("two\nlines");
+        logger::flush();
+
+        read_file("test.log", content);
+        expected.format("%04x ", GetCurrentProcessId());
+        REQUIRE(strncmp(content.c_str(), expected.c_str(), expected.length()) == 0);
+        expected.format(" %4d hello 42\r\n", line);
+        REQUIRE(strstr(content.c_str(), expected.c_str()));
+        REQUIRE(strstr(content.c_str(), " two\r\nlines\r\n"));
+    }
+
+    SECTION("Group")
+    {
+        // Leaving the outermost group writes its lines.
+        LOG("before");
+        {
+            logging_group group;
+            LOG("grouped");
+        }
+        read_file("test.log", content);
+        REQUIRE(strstr(content.c_str(), "grouped\r\n"));
+
+        // A discarded group writes nothing.
+        {
+            logging_group group;
+            LOG("discarded");
+            group.discard();
+        }
+        logger::flush();
+        read_file("test.log", content);
+        REQUIRE(!strstr(content.c_str(), "discarded"));
+    }
+
+    SECTION("Reopen")
+    {
+        // Another session may delete the file to start a new log.
+        LOG("first");
+        logger::flush();
+        REQUIRE(_unlink("test.log") == 0);
+
+        LOG("second");
+        logger::flush();
+        read_file("test.log", content);
+        REQUIRE(!strstr(content.c_str(), "first"));
+        REQUIRE(strstr(content.c_str(), "second\r\n"));
+    }
+
+    SECTION("Threads")
+    {
+        // Lines from each thread stay in order.
+        std::vector<std::thread> threads;
+        for (int32 t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([t]() {
+                for (int32 i = 0; i < 500; ++i)
+                    LOG("thread %d line %d", t, i);
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        delete log;
+        log = nullptr;
+
+        read_file("test.log", content);
+        for (int32 t = 0; t < 4; ++t)
+        {
+            const char* p = content.c_str();
+            for (int32 i = 0; i < 500; ++i)
+            {
+                str<> find;
+                find.format("thread %d line %d\r\n", t, i);
+                p = strstr(p, find.c_str());
+                REQUIRE(p, [&]() {
+                    printf("missing: %s", find.c_str());
+                });
+            }
+        }
+    }
+
+    delete log;
+}
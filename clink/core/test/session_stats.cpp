@@ -0,0 +1,71 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include <core/session_stats.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Session stats")
+{
+    session_stats* stats = get_session_stats();
+    REQUIRE(stats);
+    REQUIRE(stats == get_session_stats());
+    REQUIRE(stats->size == sizeof(session_stats));
+
+    const uint32 hits = stats->cmdcache_hits;
+    stats->cmdcache_hits = hits + 3;
+
+    session_stats snapshot;
+    REQUIRE(read_session_stats(GetCurrentProcessId(), snapshot));
+    REQUIRE(snapshot.size == sizeof(session_stats));
+    REQUIRE(snapshot.cmdcache_hits == hits + 3);
+
+    stats->cmdcache_hits = hits;
+
+    // No session has this id.
+    REQUIRE(!read_session_stats(0, snapshot));
+    REQUIRE(snapshot.cmdcache_hits == 0);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Latency histogram")
+{
+    latency_histogram h = {};
+    REQUIRE(get_latency_percentile(h, 50) == 0);
+
+    session_stats* stats = get_session_stats();
+    REQUIRE(stats);
+    latency_histogram& live = stats->latency[uint32(latency_stage::classify)];
+    const latency_histogram saved = live;
+    memset(&live, 0, sizeof(live));
+
+    // 90 fast samples and 10 slow ones.
+    for (uint32 i = 0; i < 90; ++i)
+        record_latency(latency_stage::classify, 0.000100);
+    for (uint32 i = 0; i < 10; ++i)
+        record_latency(latency_stage::classify, 0.020000);
+
+    REQUIRE(live.count == 100);
+    REQUIRE(live.total == 100);
+    REQUIRE(get_latency_max(live) == 20000);
+    REQUIRE(get_latency_percentile(live, 50) >= 100);
+    REQUIRE(get_latency_percentile(live, 50) < 150);
+    REQUIRE(get_latency_percentile(live, 90) < 150);
+    REQUIRE(get_latency_percentile(live, 95) == 20000);
+
+    // Counts are halved once the window is full, but the total keeps going.
+    for (uint32 i = 100; i <= c_latency_window; ++i)
+        record_latency(latency_stage::classify, 0.000100);
+    REQUIRE(live.count == c_latency_window / 2 + 1);
+    REQUIRE(live.total == c_latency_window + 1);
+    REQUIRE(get_latency_max(live) == 20000);
+
+    // Another process sees the same numbers.
+    session_stats snapshot;
+    REQUIRE(read_session_stats(GetCurrentProcessId(), snapshot));
+    REQUIRE(snapshot.latency[uint32(latency_stage::classify)].total == c_latency_window + 1);
+
+    live = saved;
+}
@@ -4,9 +4,15 @@
 #include "pch.h"
 #include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
 
+#include "fs_fixture.h"
+
 #include <core/base.h>
+#include <core/os.h>
+#include <core/path.h>
 #include <core/settings.h>
 
+#include <string>
+
 //------------------------------------------------------------------------------
 TEST_CASE("settings : basic")
 {
@@ -69,6 +75,47 @@ TEST_CASE("settings : list")
     REQUIRE(settings::first().next() == first);
 }
 
+//------------------------------------------------------------------------------
+TEST_CASE("settings : handles")
+{
+    // Handles can be resolved before a setting exists.
+    const uint32 handle = settings::get_handle("Test.Handle");
+    REQUIRE(handle != 0);
+    REQUIRE(settings::from_handle(handle) == nullptr);
+    REQUIRE(settings::from_handle(0) == nullptr);
+
+    uint32 generation = settings::get_generation();
+    {
+        setting_int test("test.handle", "", "", 7);
+        REQUIRE(settings::get_generation() != generation);
+        REQUIRE(settings::get_handle("TEST.HANDLE") == handle);
+        REQUIRE(settings::from_handle(handle) == &test);
+        REQUIRE(settings::find("test.HANDLE") == &test);
+
+        // Changing the value changes the generation.
+        generation = settings::get_generation();
+        REQUIRE(test.set("42"));
+        REQUIRE(settings::get_generation() != generation);
+
+        // A failed change doesn't.
+        generation = settings::get_generation();
+        REQUIRE(!test.set("abc"));
+        REQUIRE(settings::get_generation() == generation);
+    }
+
+    // The handle outlives the setting, and resolves again if it's re-added.
+    REQUIRE(settings::from_handle(handle) == nullptr);
+    REQUIRE(settings::find("test.handle") == nullptr);
+    {
+        setting_bool test("test.handle", "", "", true);
+        REQUIRE(settings::from_handle(handle) == &test);
+    }
+
+    // Names that are too long are truncated, the same as setting names.
+    REQUIRE(settings::get_handle("test.0123456789012345678901234567") ==
+            settings::get_handle("test.0123456789012345678901234567890"));
+}
+
 //------------------------------------------------------------------------------
 TEST_CASE("settings : bool")
 {
@@ -205,3 +252,143 @@ TEST_CASE("settings : color")
     test.get_descriptive(tmp);
     REQUIRE(tmp.equals("bright yellow"));
 }
+
+//------------------------------------------------------------------------------
+static void write_settings_file(const char* file, const char* content, bool backdate)
+{
+    FILE* f = fopen(file, "wb");
+    REQUIRE(f);
+    fputs(content, f);
+    fclose(f);
+
+    // Snapshots aren't written for files that were written very recently.
+    if (backdate)
+        REQUIRE(backdate_file(file, 3600));
+}
+
+//------------------------------------------------------------------------------
+// Replaces the first occurrence of find that follows after in the file with
+// replace, which must be the same length.
+static void patch_file(const char* file, const char* after, const char* find, const char* replace)
+{
+    FILE* f = fopen(file, "r+b");
+    REQUIRE(f);
+    std::string data;
+    char buffer[1024];
+    for (size_t len; (len = fread(buffer, 1, sizeof(buffer), f)) > 0;)
+        data.append(buffer, len);
+
+    const size_t len = strlen(find);
+    REQUIRE(strlen(replace) == len);
+    size_t pos = data.find(after);
+    REQUIRE(pos != std::string::npos);
+    pos = data.find(find, pos, len);
+    REQUIRE(pos != std::string::npos);
+
+    fseek(f, long(pos), SEEK_SET);
+    fwrite(replace, 1, len, f);
+    fclose(f);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("settings : snapshot")
+{
+    fs_fixture fs;
+
+    setting_bool test_bool("snap.bool", "", false);
+    setting_color test_color("snap.color", "", "");
+
+    str<280> file;
+    str<280> snapshot;
+    os::get_current_dir(file);
+    path::append(file, "clink_settings");
+    snapshot = file.c_str();
+    snapshot.concat(".snapshot");
+
+    static const char* const c_content =
+        "# comment\n"
+        "snap.bool = true\n"
+        "snap.color = bold red on blue\n"
+        "snap.later = 42\n";
+
+    str<> expected_color;
+    REQUIRE(test_color.set("bold red on blue"));
+    test_color.get(expected_color);
+
+    // A file that was just written isn't snapshotted.
+    write_settings_file(file.c_str(), c_content, false);
+    REQUIRE(settings::load(file.c_str()));
+    REQUIRE(os::get_path_type(snapshot.c_str()) == os::path_type_invalid);
+
+    // Loading the text file writes the snapshot.
+    write_settings_file(file.c_str(), c_content, true);
+    REQUIRE(settings::load(file.c_str()));
+    REQUIRE(os::get_path_type(snapshot.c_str()) == os::path_type_file);
+
+    // Loading from the snapshot gives the same result as the text file,
+    // including for settings that aren't registered yet.  The value of
+    // snap.later is edited in the snapshot, without changing the text file, to
+    // show that the snapshot is what got loaded.
+    patch_file(snapshot.c_str(), "snap.later", "42", "43");
+    test_bool.set("false");
+    test_color.set("green");
+    REQUIRE(settings::load(file.c_str()));
+    str<> tmp;
+    REQUIRE(test_bool.get() == true);
+    test_color.get(tmp);
+    REQUIRE(tmp.equals(expected_color.c_str()));
+    {
+        setting_int later("snap.later", "", 0);
+        later.deferred_load();
+        REQUIRE(later.get() == 43);
+    }
+
+    // The snapshot isn't used when it's turned off.
+    REQUIRE(os::set_env("CLINK_NO_SETTINGS_SNAPSHOT", "1"));
+    REQUIRE(settings::load(file.c_str()));
+    os::set_env("CLINK_NO_SETTINGS_SNAPSHOT", nullptr);
+    {
+        setting_int later("snap.later", "", 0);
+        later.deferred_load();
+        REQUIRE(later.get() == 42);
+    }
+
+    // A snapshot written by a different version of Clink is ignored, since
+    // its parsed colors might not match what this version would parse.
+    {
+        FILE* f = fopen(snapshot.c_str(), "r+b");
+        REQUIRE(f);
+        const uint32 other_version = 1;
+        fseek(f, 8, SEEK_SET); // Past the magic and format.
+        fwrite(&other_version, sizeof(other_version), 1, f);
+        fclose(f);
+    }
+    REQUIRE(settings::load(file.c_str()));
+    {
+        setting_int later("snap.later", "", 0);
+        later.deferred_load();
+        REQUIRE(later.get() == 42);
+    }
+
+    // Changing the file makes the snapshot stale.
+    write_settings_file(file.c_str(), "snap.bool = false\n", true);
+    REQUIRE(settings::load(file.c_str()));
+    REQUIRE(test_bool.get() == false);
+    test_color.get(tmp);
+    REQUIRE(tmp.empty());
+
+    // A corrupt snapshot is ignored.  The file sets a value that differs from
+    // the default, so accepting the snapshot would leave the wrong value.
+    write_settings_file(file.c_str(), "snap.bool = true\n", true);
+    REQUIRE(settings::load(file.c_str()));
+    FILE* f = fopen(snapshot.c_str(), "r+b");
+    REQUIRE(f);
+    fseek(f, -2, SEEK_END);
+    fputs("xx", f);
+    fclose(f);
+    test_bool.set("false");
+    REQUIRE(settings::load(file.c_str()));
+    REQUIRE(test_bool.get() == true);
+
+    settings::load(nullptr);
+}
@@ -0,0 +1,228 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include <core/task_pool.h>
+
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Stand-in for an async_lua_task:  sleeps or computes, can be canceled, and
+// signals a wait handle when it's done.
+class test_task
+{
+public:
+                    test_task(uint32 sleep_ms, uint32 compute=0) : m_sleep_ms(sleep_ms), m_compute(compute) { m_event = CreateEvent(nullptr, true, false, nullptr); }
+                    ~test_task() { CloseHandle(m_event); }
+
+    void            cancel() { m_canceled = true; }
+    bool            is_canceled() const { return m_canceled; }
+    bool            is_complete() const { return m_complete; }
+    bool            did_work() const { return m_did_work; }
+    uint32          result() const { return m_result; }
+    bool            wait(uint32 timeout) const { return WaitForSingleObject(m_event, timeout) == WAIT_OBJECT_0; }
+
+    void run(volatile long* concurrent, volatile long* peak)
+    {
+        if (concurrent)
+        {
+            const long now = InterlockedIncrement(concurrent);
+            long old = *peak;
+            while (now > old && InterlockedCompareExchange(peak, now, old) != old)
+                old = *peak;
+        }
+
+        if (!is_canceled())
+        {
+            m_did_work = true;
+            for (uint32 slept = 0; slept < m_sleep_ms && !is_canceled(); slept += 5)
+                Sleep(5);
+            uint32 x = 1;
+            for (uint32 i = 0; i < m_compute && !is_canceled(); ++i)
+                x = x * 1664525 + 1013904223;
+            m_result = x;
+        }
+
+        if (concurrent)
+            InterlockedDecrement(concurrent);
+
+        m_complete = true;
+        SetEvent(m_event);
+    }
+
+private:
+    HANDLE          m_event;
+    const uint32    m_sleep_ms;
+    const uint32    m_compute;
+    uint32          m_result = 0;
+    volatile bool   m_canceled = false;
+    volatile bool   m_did_work = false;
+    volatile bool   m_complete = false;
+};
+
+//------------------------------------------------------------------------------
+static bool wait_all(const std::vector<std::shared_ptr<test_task>>& tasks, uint32 timeout=10000)
+{
+    for (const auto& task : tasks)
+    {
+        if (!task->wait(timeout))
+            return false;
+    }
+    return true;
+}
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("Task pool")
+{
+    SECTION("Runs all work")
+    {
+        task_pool pool(4);
+
+        std::vector<std::shared_ptr<test_task>> tasks;
+        for (uint32 i = 0; i < 32; ++i)
+        {
+            auto task = std::make_shared<test_task>(i % 3, 10000);
+            tasks.emplace_back(task);
+            REQUIRE(pool.submit([task]() { task->run(nullptr, nullptr); }));
+        }
+
+        REQUIRE(wait_all(tasks));
+        for (const auto& task : tasks)
+        {
+            REQUIRE(task->is_complete());
+            REQUIRE(task->did_work());
+            REQUIRE(task->result() != 0);
+        }
+
+        task_pool_stats stats;
+        pool.get_stats(stats);
+        REQUIRE(stats.submitted == 32);
+        REQUIRE(stats.peak_workers <= 4);
+        REQUIRE(stats.peak_queued >= 1);
+    }
+
+    SECTION("Bounded concurrency")
+    {
+        task_pool pool(2);
+
+        volatile long concurrent = 0;
+        volatile long peak = 0;
+        std::vector<std::shared_ptr<test_task>> tasks;
+        for (uint32 i = 0; i < 8; ++i)
+        {
+            auto task = std::make_shared<test_task>(20);
+            tasks.emplace_back(task);
+            REQUIRE(pool.submit([task, &concurrent, &peak]() { task->run(&concurrent, &peak); }));
+        }
+
+        REQUIRE(wait_all(tasks));
+        REQUIRE(peak >= 1);
+        REQUIRE(peak <= 2);
+
+        task_pool_stats stats;
+        pool.get_stats(stats);
+        REQUIRE(stats.peak_workers <= 2);
+        REQUIRE(stats.peak_queued >= 2);
+        REQUIRE(stats.max_latency > 0);
+    }
+
+    SECTION("Cancel")
+    {
+        task_pool pool(1);
+
+        // Occupy the only worker, so the next task stays queued.
+        auto blocker = std::make_shared<test_task>(5000);
+        auto queued = std::make_shared<test_task>(5000);
+        REQUIRE(pool.submit([blocker]() { blocker->run(nullptr, nullptr); }));
+        REQUIRE(pool.submit([queued]() { queued->run(nullptr, nullptr); }));
+
+        queued->cancel();
+        blocker->cancel();
+
+        REQUIRE(blocker->wait(5000));
+        REQUIRE(queued->wait(5000));
+        REQUIRE(queued->is_complete());
+        REQUIRE(!queued->did_work());
+    }
+
+    SECTION("Blocking work")
+    {
+        task_pool pool(1);
+
+        // Blocking work doesn't count against the maximum, so other work still
+        // runs while the blocking work waits.
+        auto blocker = std::make_shared<test_task>(5000);
+        auto other = std::make_shared<test_task>(0, 1000);
+        REQUIRE(pool.submit([blocker]() { blocker->run(nullptr, nullptr); }, true/*blocking*/));
+        REQUIRE(pool.submit([other]() { other->run(nullptr, nullptr); }));
+
+        REQUIRE(other->wait(2000));
+        REQUIRE(other->did_work());
+        REQUIRE(!blocker->is_complete());
+
+        task_pool_stats stats;
+        pool.get_stats(stats);
+        REQUIRE(stats.blocked_workers == 1);
+        REQUIRE(stats.peak_workers == 2);
+
+        blocker->cancel();
+        REQUIRE(blocker->wait(5000));
+    }
+
+    SECTION("Stats")
+    {
+        std::vector<std::shared_ptr<test_task>> tasks;
+        task_pool_stats stats;
+
+        {
+            task_pool pool(3);
+            for (uint32 i = 0; i < 12; ++i)
+            {
+                auto task = std::make_shared<test_task>(10);
+                tasks.emplace_back(task);
+                REQUIRE(pool.submit([task]() { task->run(nullptr, nullptr); }));
+            }
+
+            REQUIRE(wait_all(tasks));
+
+            // Tasks signal before the pool records their completion.
+            for (uint32 waited = 0; waited < 5000; waited += 5)
+            {
+                pool.get_stats(stats);
+                if (stats.completed == 12)
+                    break;
+                Sleep(5);
+            }
+        }
+
+        REQUIRE(stats.submitted == 12);
+        REQUIRE(stats.completed == 12);
+        REQUIRE(stats.queued == 0);
+        REQUIRE(stats.busy_workers == 0);
+        REQUIRE(stats.total_runtime > 0);
+        REQUIRE(stats.max_runtime >= stats.total_runtime / 12);
+    }
+
+    SECTION("Destructor drains queue")
+    {
+        std::vector<std::shared_ptr<test_task>> tasks;
+
+        {
+            task_pool pool(2);
+            for (uint32 i = 0; i < 6; ++i)
+            {
+                auto task = std::make_shared<test_task>(10);
+                tasks.emplace_back(task);
+                REQUIRE(pool.submit([task]() { task->run(nullptr, nullptr); }));
+            }
+        }
+
+        for (const auto& task : tasks)
+            REQUIRE(task->is_complete());
+    }
+}
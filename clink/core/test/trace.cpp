@@ -0,0 +1,107 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "fs_fixture.h"
+
+#include <core/str.h>
+#include <core/trace.h>
+
+#include <thread>
+
+//------------------------------------------------------------------------------
+static void read_file(const char* name, str_base& out)
+{
+    out.clear();
+    FILE* f = fopen(name, "rb");
+    REQUIRE(f);
+    char buffer[1024];
+    size_t len;
+    while ((len = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        out.concat(buffer, int32(len));
+    fclose(f);
+}
+
+//------------------------------------------------------------------------------
+static uint32 count(const char* text, const char* find)
+{
+    uint32 n = 0;
+    for (const char* p = text; (p = strstr(p, find)) != nullptr; ++p)
+        ++n;
+    return n;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Trace")
+{
+    fs_fixture fs;
+    str_moveable json;
+
+    trace::clear();
+
+    SECTION("Disabled")
+    {
+        trace::enable(false);
+        {
+            TRACE_SCOPE("disabled span");
+        }
+        REQUIRE(trace::write_json("trace.json"));
+        read_file("trace.json", json);
+        REQUIRE(count(json.c_str(), "disabled span") == 0);
+    }
+
+    SECTION("Enabled")
+    {
+        trace::enable(true);
+        {
+            TRACE_SCOPE("outer");
+            {
+                TRACE_SCOPE("inner");
+            }
+        }
+        str<> dynamic("dynamic \"quoted\"");
+        trace::record(trace::intern(dynamic.c_str()), 1.0, 1.5);
+        dynamic.clear();
+        REQUIRE(trace::intern("outer") == trace::intern("outer"));
+
+        // The thread's ring is freed when it exits, but its events are kept.
+        std::thread thread([]() {
+            TRACE_SCOPE("other thread");
+        });
+        thread.join();
+        trace::enable(false);
+
+        REQUIRE(trace::write_json("trace.json"));
+        read_file("trace.json", json);
+        REQUIRE(strncmp(json.c_str(), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 39) == 0);
+        REQUIRE(count(json.c_str(), "\"name\":\"outer\"") == 1);
+        REQUIRE(count(json.c_str(), "\"name\":\"inner\"") == 1);
+        REQUIRE(count(json.c_str(), "\"name\":\"other thread\"") == 1);
+        REQUIRE(count(json.c_str(), "\"name\":\"dynamic \\\"quoted\\\"\",\"ph\":\"X\",\"ts\":1000000.000,\"dur\":500000.000") == 1);
+        REQUIRE(count(json.c_str(), "\"ph\":\"X\"") == 4);
+
+        // Clearing discards what was recorded so far.
+        trace::clear();
+        REQUIRE(trace::write_json("trace.json"));
+        read_file("trace.json", json);
+        REQUIRE(count(json.c_str(), "\"ph\":\"X\"") == 0);
+    }
+
+    SECTION("Wrap")
+    {
+        // Only the most recent events are kept.
+        trace::enable(true);
+        for (uint32 i = 0; i < trace::c_capacity + 10; ++i)
+            trace::record(i < 10 ? "old" : "new", 0, 0);
+        trace::enable(false);
+
+        REQUIRE(trace::write_json("trace.json"));
+        read_file("trace.json", json);
+        REQUIRE(count(json.c_str(), "\"name\":\"old\"") == 0);
+        REQUIRE(count(json.c_str(), "\"name\":\"new\"") == trace::c_capacity);
+    }
+
+    trace::clear();
+}
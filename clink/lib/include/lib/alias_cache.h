@@ -4,18 +4,62 @@
 #pragma once
 
 #include <core/str.h>
-#include <core/str_map.h>
-#include <core/auto_free_str.h>
+#include <core/str_unordered_set.h>
 #include <core/linear_allocator.h>
 
+#include "doskey.h"
+
+#include <deque>
+
+//------------------------------------------------------------------------------
+// All doskey aliases for a shell, fetched with one console API call and kept
+// across input lines.  validate() compares a cheap signature (the total size
+// of the aliases) and reloads them when it differs.  invalidate() forces the
+// next validate() to reload, for when Clink knows aliases may have changed in
+// a way the signature could miss.  Macros are compiled the first time they're
+// expanded, and kept until the snapshot reloads.
+class alias_snapshot
+{
+    struct entry
+    {
+        const char* text;
+        doskey_macro* macro;
+    };
+
+public:
+    static alias_snapshot& get(const wchar_t* shell_name);
+    static void     invalidate();
+
+    void            validate();
+    bool            find(const char* name, str_base& out) const;
+    const doskey_macro* find_macro(const char* name, doskey_macro& temp);
+    uint32          get_generation() const { return m_generation; }
+
+private:
+                    alias_snapshot() : m_strings(4096) {}
+    void            load(uint32 signature);
+    bool            find_live(const char* name, str_base& out) const;
+
+    wstr<16>        m_shell_name;
+    str_unordered_map_caseless<entry> m_map;
+    std::deque<doskey_macro> m_macros;
+    linear_allocator m_strings;
+    uint32          m_signature = 0;
+    uint32          m_hash = 0;
+    uint32          m_generation = 0;
+    bool            m_loaded = false;
+    static bool     s_invalid;
+};
+
 //------------------------------------------------------------------------------
+// Looks up aliases in the snapshot for the current shell, validating the
+// snapshot on first use after each clear().
 class alias_cache
 {
 public:
-    alias_cache() : m_names(4096) {}
-    void clear();
+    void clear() { m_validated = false; }
     bool get_alias(const char* name, str_base& out);
+    uint32 get_generation() const;
 private:
-    str_map_caseless<auto_free_str>::type m_map;
-    linear_allocator m_names;
+    bool m_validated = false;
 };
@@ -37,6 +37,7 @@ public:
     void next_word();
     bool test(int32 c, tokeniser_state new_state);
     bool is_first() const { return m_first; }
+    bool is_failed() const { return m_failed; }
     void cancel() { m_failed = true; }
 private:
     str<16> m_word;
@@ -59,9 +60,11 @@ public:
 protected:
     char get_opening_quote() const;
     char get_closing_quote() const;
+    void skip_to(const char* ptr);
 protected:
     str_iter m_iter;
     const char* m_start;
+    const char* m_end;
     const char* m_quote_pair;
     alias_cache* m_alias_cache = nullptr;
     bool m_next_redir_arg;
@@ -73,6 +76,7 @@ class cmd_command_tokeniser : public cmd_tokeniser_impl
 public:
     word_token next(uint32& offset, uint32& length) override;
     bool has_deprecated_argmatcher(char const* command) override;
+    uint32 get_deprecated_argmatcher_generation() override;
 };
 
 //------------------------------------------------------------------------------
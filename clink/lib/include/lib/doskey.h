@@ -7,6 +7,8 @@
 #include <core/str.h>
 #include <core/str_iter.h>
 
+#include <vector>
+
 //------------------------------------------------------------------------------
 class doskey_alias
 {
@@ -26,6 +28,30 @@ private:
 
 
 
+//------------------------------------------------------------------------------
+// A macro's text compiled into literal spans and argument references, so that
+// expanding it copies spans instead of parsing the $ tags again.
+class doskey_macro
+{
+public:
+    void            compile(const char* text);
+
+private:
+    friend class    doskey;
+    enum : int32    { literal = -2, all_args = -1 }; // Else the arg index.
+    struct op
+    {
+        int32       arg;
+        uint32      offset;         // Into m_literals, for literal ops.
+        uint32      length;
+    };
+    std::vector<op> m_ops;
+    str_moveable    m_literals;
+    bool            m_quoted_args = false;
+};
+
+
+
 //------------------------------------------------------------------------------
 class doskey
 {
@@ -61,6 +61,7 @@ bool is_sparse_prompt_spacing();
 void clear_deprecated_argmatchers();
 void mark_deprecated_argmatcher(const char* name);
 bool has_deprecated_argmatcher(const char* name);
+uint32 get_deprecated_argmatcher_generation();
 
 //------------------------------------------------------------------------------
 bool host_can_suggest(const line_state& line);
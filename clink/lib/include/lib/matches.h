@@ -291,3 +291,5 @@ public:
 //------------------------------------------------------------------------------
 std::shared_ptr<match_builder_toolkit> make_match_builder_toolkit(int32 generation_id, uint32 end_word_offset);
 bool notify_matches_ready(std::shared_ptr<match_builder_toolkit> toolkit, int32 generation_id);
+std::shared_ptr<match_builder_toolkit> make_partial_match_builder_toolkit(const std::shared_ptr<match_builder_toolkit>& toolkit);
+bool notify_matches_partial(std::shared_ptr<match_builder_toolkit> partial, int32 generation_id);
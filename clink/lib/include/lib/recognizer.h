@@ -10,7 +10,9 @@ class str_base;
 // > 0 --> color.executable
 enum class recognition : char { unrecognized = -1, unknown, executable, navigate, max };
 
-recognition recognize_command(const char* line, const char* word, bool quoted, bool& ready, str_base* file);
+// The priority orders queued words for the background thread; lower values are
+// recognized sooner (e.g. the distance from the cursor).
+recognition recognize_command(const char* line, const char* word, bool quoted, bool& ready, str_base* file, uint32 priority=0);
 
 HANDLE get_recognizer_event();
 bool check_recognizer_refresh();
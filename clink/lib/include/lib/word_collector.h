@@ -35,6 +35,7 @@ public:
     virtual void start(const str_iter& iter, const char* quote_pair, bool at_beginning=true) = 0;
     virtual word_token next(uint32& offset, uint32& length) = 0;
     virtual bool has_deprecated_argmatcher(const char* command) { return false; }
+    virtual uint32 get_deprecated_argmatcher_generation() { return 0; }
 };
 
 //------------------------------------------------------------------------------
@@ -56,6 +57,7 @@ public:
     ~word_collector();
 
     void init_alias_cache();
+    void clear_cache();
 
     uint32 collect_words(const char* buffer, uint32 length, uint32 cursor,
                          words& words, collect_words_mode mode,
@@ -65,6 +67,22 @@ public:
                          commands* commands) const;
 
 private:
+    struct cache_entry
+    {
+        str_moveable    buffer;
+        uint32          cursor = 0;
+        uint32          generation = 0;
+        uint32          alias_generation = 0;
+        uint32          argmatcher_generation = 0;
+        uint32          command_offset = 0;
+        bool            valid = false;
+        ::words         collected;
+        ::commands      bounds;
+    };
+
+    uint32 tokenise(const char* buffer, uint32 length, uint32 cursor,
+                    words& words, collect_words_mode mode,
+                    commands& commands) const;
     char get_opening_quote() const;
     char get_closing_quote() const;
     void find_command_bounds(const char* buffer, uint32 length, uint32 cursor,
@@ -78,6 +96,7 @@ private:
     alias_cache* m_alias_cache = nullptr;
     const char* const m_quote_pair;
     bool m_delete_word_tokeniser = false;
+    mutable cache_entry m_cache[2];         // Indexed by collect_words_mode.
 };
 
 //------------------------------------------------------------------------------
@@ -5,32 +5,176 @@
 #include "alias_cache.h"
 
 #include <core/os.h>
+#include <core/str_hash.h>
+#include <core/debugheap.h>
 
 //------------------------------------------------------------------------------
-void alias_cache::clear()
+bool alias_snapshot::s_invalid = false;
+
+//------------------------------------------------------------------------------
+alias_snapshot& alias_snapshot::get(const wchar_t* shell_name)
+{
+    static alias_snapshot s_snapshot;
+
+    // Only one shell's aliases are kept; switching shells reloads.
+    if (!s_snapshot.m_loaded || !s_snapshot.m_shell_name.equals(shell_name))
+    {
+        s_snapshot.m_shell_name = shell_name;
+        s_snapshot.load(GetConsoleAliasesLengthW(s_snapshot.m_shell_name.data()));
+    }
+
+    return s_snapshot;
+}
+
+//------------------------------------------------------------------------------
+void alias_snapshot::invalidate()
+{
+    s_invalid = true;
+}
+
+//------------------------------------------------------------------------------
+void alias_snapshot::validate()
+{
+    const uint32 signature = GetConsoleAliasesLengthW(m_shell_name.data());
+    if (m_loaded && !s_invalid && signature == m_signature)
+        return;
+
+    load(signature);
+}
+
+//------------------------------------------------------------------------------
+void alias_snapshot::load(uint32 signature)
 {
+    dbg_ignore_scope(snapshot, "Alias snapshot");
+
     m_map.clear();
-    m_names.clear();
+    m_macros.clear();
+    m_strings.clear();
+    m_signature = signature;
+    m_loaded = true;
+    s_invalid = false;
+
+    // The buffer holds "name=text" entries, each NUL terminated.
+    wstr_moveable buffer;
+    uint32 hash = 0;
+    if (signature)
+    {
+        buffer.reserve(signature / sizeof(wchar_t) + 1, true/*exact*/);
+        const DWORD bytes = GetConsoleAliasesW(buffer.data(), signature, m_shell_name.data());
+        const wchar_t* walk = buffer.c_str();
+        const wchar_t* const end = walk + bytes / sizeof(wchar_t);
+
+        str<> name;
+        str<> text;
+        while (walk < end && *walk)
+        {
+            const uint32 len = uint32(wcsnlen(walk, end - walk));
+            const wchar_t* equals = wmemchr(walk, '=', len);
+            if (equals && equals > walk && equals + 1 < walk + len)
+            {
+                to_utf8(name, walk, int32(equals - walk));
+                to_utf8(text, equals + 1, int32(walk + len - (equals + 1)));
+                m_map.emplace(m_strings.store(name.c_str()), entry { m_strings.store(text.c_str()), nullptr });
+                hash = (hash * 31) ^ str_hash(name.c_str()) ^ (str_hash(text.c_str()) << 1);
+            }
+            walk += len + 1;
+        }
+    }
+
+    // The generation only changes when the aliases actually changed, so that
+    // anything derived from them can be kept.
+    if (hash != m_hash || !m_generation)
+    {
+        m_hash = hash;
+        ++m_generation;
+    }
 }
 
 //------------------------------------------------------------------------------
-bool alias_cache::get_alias(const char* name, str_base& out)
+static bool is_ascii(const char* name)
 {
-    const auto& iter = m_map.find(name);
-    if (iter != m_map.end())
+    for (const char* walk = name; *walk; ++walk)
     {
-        const char* value = iter->second.get();
-        if (!value || !*value)
+        if (uint8(*walk) >= 0x80)
             return false;
-        out = value;
-        return true;
     }
+    return true;
+}
 
-    const bool exists = os::get_alias(name, out);
+//------------------------------------------------------------------------------
+bool alias_snapshot::find(const char* name, str_base& out) const
+{
+    // The console compares names without regard to case, including non-ASCII
+    // letters, which the snapshot's map doesn't fold; ask the console.
+    if (!is_ascii(name))
+        return find_live(name, out);
+
+    const auto iter = m_map.find(name);
+    if (iter == m_map.end())
+        return false;
+
+    out = iter->second.text;
+    return true;
+}
 
-    const char* cache_name = m_names.store(name);
-    auto_free_str cache_value(out.c_str(), out.length());
-    m_map.emplace(cache_name, std::move(cache_value));
+//------------------------------------------------------------------------------
+const doskey_macro* alias_snapshot::find_macro(const char* name, doskey_macro& temp)
+{
+    if (!is_ascii(name))
+    {
+        str<> text;
+        if (!find_live(name, text))
+            return nullptr;
+        temp.compile(text.c_str());
+        return &temp;
+    }
 
-    return exists;
+    const auto iter = m_map.find(name);
+    if (iter == m_map.end())
+        return nullptr;
+
+    entry& found = iter->second;
+    if (!found.macro)
+    {
+        dbg_ignore_scope(snapshot, "Alias snapshot");
+        m_macros.emplace_back();
+        m_macros.back().compile(found.text);
+        found.macro = &m_macros.back();
+    }
+    return found.macro;
+}
+
+//------------------------------------------------------------------------------
+bool alias_snapshot::find_live(const char* name, str_base& out) const
+{
+    wstr<32> wname(name);
+    wstr<32> wtext;
+    wtext.reserve(8191);
+    if (!GetConsoleAliasW(wname.data(), wtext.data(), wtext.size(), const_cast<wchar_t*>(m_shell_name.c_str())) || !wtext.length())
+        return false;
+    out = wtext.c_str();
+    return true;
+}
+
+
+
+//------------------------------------------------------------------------------
+bool alias_cache::get_alias(const char* name, str_base& out)
+{
+    alias_snapshot& snapshot = alias_snapshot::get(os::get_shellname());
+    if (!m_validated)
+    {
+        snapshot.validate();
+        m_validated = true;
+    }
+
+    return snapshot.find(name, out);
+}
+
+//------------------------------------------------------------------------------
+// Changes whenever the snapshot reloads, including when another consumer
+// validated it.
+uint32 alias_cache::get_generation() const
+{
+    return alias_snapshot::get(os::get_shellname()).get_generation();
 }
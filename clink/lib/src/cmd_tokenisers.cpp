@@ -40,7 +40,7 @@ const char* const c_cmd_commands_shellwordbreaks[] =
 
 //------------------------------------------------------------------------------
 enum input_type { iTxt, iSpc, iDig, iIn, iOut, iAmp, iPipe, iMAX };
-static input_type get_input_type(int32 c)
+static input_type classify_input(int32 c)
 {
     switch (c)
     {
@@ -110,10 +110,19 @@ void cmd_tokeniser_impl::start(const str_iter& iter, const char* quote_pair, boo
 {
     m_iter = iter;
     m_start = iter.get_pointer();
+    m_end = m_start + iter.length();
     m_quote_pair = quote_pair;
     m_next_redir_arg = false;
 }
 
+//------------------------------------------------------------------------------
+void cmd_tokeniser_impl::skip_to(const char* ptr)
+{
+    assert(ptr >= m_iter.get_pointer());
+    assert(ptr <= m_end);
+    m_iter = str_iter(ptr, int32(m_end - ptr));
+}
+
 //------------------------------------------------------------------------------
 char cmd_tokeniser_impl::get_opening_quote() const
 {
@@ -264,13 +273,96 @@ static const char c_name_delims[] = "@ \t=;,(";
 static const char c_word_delims[] = " \t\n'`=+;,()[]{}";
 
 //------------------------------------------------------------------------------
-static const char* get_delims(bool command_word, bool redir_arg, bool in_word)
+// Each byte's input_type and delimiter classes come from one table lookup.
+// Plain bytes are ASCII text or digits that can't end a word or change the
+// tokeniser state by themselves, so runs of them can be consumed in bulk.
+enum : uint8
+{
+    bc_input_mask       = 0x07,
+    bc_plain            = 0x08,
+    bc_command_delim    = 0x10,
+    bc_name_delim       = 0x20,
+    bc_word_delim       = 0x40,
+};
+static_assert(iMAX - 1 <= bc_input_mask, "input_type doesn't fit in bc_input_mask");
+
+//------------------------------------------------------------------------------
+static class byte_classes
+{
+public:
+    byte_classes()
+    {
+        for (int32 c = 0; c < 256; ++c)
+        {
+            const input_type input = classify_input(c);
+            uint8 bits = uint8(input);
+            if (c && c < 0x80 && c != '^' && (input == iTxt || input == iDig))
+                bits |= bc_plain;
+            // Like str_chr, these treat NUL as a delimiter.
+            if (strchr(c_command_delims, c))
+                bits |= bc_command_delim;
+            if (strchr(c_name_delims, c))
+                bits |= bc_name_delim;
+            if (strchr(c_word_delims, c))
+                bits |= bc_word_delim;
+            m_classes[c] = bits;
+        }
+    }
+
+    uint8 operator[](uint8 c) const { return m_classes[c]; }
+
+private:
+    uint8 m_classes[256];
+} s_byte_classes;
+
+//------------------------------------------------------------------------------
+static input_type get_input_type(int32 c)
+{
+    return (c & ~0xff) ? iTxt : input_type(s_byte_classes[uint8(c)] & bc_input_mask);
+}
+
+//------------------------------------------------------------------------------
+static bool is_delim(int32 c, uint8 delims)
+{
+    return !(c & ~0xff) && (s_byte_classes[uint8(c)] & delims);
+}
+
+//------------------------------------------------------------------------------
+static uint8 get_delims(bool command_word, bool redir_arg, bool in_word)
 {
     if (redir_arg || (command_word && !in_word))
-        return c_name_delims;
+        return bc_name_delim;
     if (command_word)
-        return c_command_delims;
-    return c_word_delims;
+        return bc_command_delim;
+    return bc_word_delim;
+}
+
+//------------------------------------------------------------------------------
+// Returns the end of the run of bytes inside quotes that can't close the
+// quote.  Non-ASCII bytes end the run, so that str_iter still decodes them.
+static const char* scan_quoted(const char* p, const char* end, char cq)
+{
+    for (; p < end; ++p)
+    {
+        const uint8 c = uint8(*p);
+        if (!c || c >= 0x80 || c == uint8(cq))
+            break;
+    }
+    return p;
+}
+
+//------------------------------------------------------------------------------
+// Returns the end of the run of plain bytes that aren't in delims, and aren't
+// the opening quote or (if requested) a forward slash.
+static const char* scan_plain(const char* p, const char* end, char oq, uint8 delims, bool slash)
+{
+    for (; p < end; ++p)
+    {
+        const uint8 bits = s_byte_classes[uint8(*p)];
+        if (!(bits & bc_plain) || (bits & delims) || *p == oq || (slash && *p == '/'))
+            break;
+    }
+    return p;
 }
 
 //------------------------------------------------------------------------------
@@ -407,6 +499,19 @@ word_token cmd_command_tokeniser::next(uint32& offset, uint32& length)
 
     while (m_iter.more())
     {
+        // Inside quotes, and inside text once it can't be 'rem', bytes that
+        // can't change the state are consumed in bulk.
+        if (in_quote || (state == sTxt && any_text && (is_arg || cmd_state.is_failed())))
+        {
+            const char* p = m_iter.get_pointer();
+            const char* run = in_quote ? scan_quoted(p, m_end, cq) : scan_plain(p, m_end, oq, 0, false);
+            if (run > p)
+            {
+                skip_to(run);
+                continue;
+            }
+        }
+
         c = m_iter.next();
 
         if (in_quote)
@@ -430,7 +535,7 @@ word_token cmd_command_tokeniser::next(uint32& offset, uint32& length)
 
             if (new_state == sTxt || new_state == sDig)
             {
-                if (!any_text && !str_chr(c_name_delims, c) && c != '&' &&  c != '|')
+                if (!any_text && !is_delim(c, bc_name_delim) && c != '&' &&  c != '|')
                 {
                     any_text = true;
                     if (input == iDig && new_state == sTxt)
@@ -492,6 +597,12 @@ bool cmd_command_tokeniser::has_deprecated_argmatcher(const char* command)
     return ::has_deprecated_argmatcher(command);
 }
 
+//------------------------------------------------------------------------------
+uint32 cmd_command_tokeniser::get_deprecated_argmatcher_generation()
+{
+    return ::get_deprecated_argmatcher_generation();
+}
+
 
 
 //------------------------------------------------------------------------------
@@ -538,7 +649,7 @@ word_token cmd_word_tokeniser::next(uint32& offset, uint32& length)
             }
             else
             {
-                if (!str_chr(get_delims(command_word, redir_arg, false), c))
+                if (!is_delim(c, get_delims(command_word, redir_arg, false)))
                     break;
             }
             m_iter.next();
@@ -557,6 +668,23 @@ word_token cmd_word_tokeniser::next(uint32& offset, uint32& length)
     tokeniser_state state = sSpc;
     while (true)
     {
+        // Inside quotes, and inside text once it can't be an internal
+        // command, bytes that can't end the word are consumed in bulk.
+        if (!first_char && (in_quote || (state == sTxt && m_cmd_state.is_failed())))
+        {
+            const char* p = m_iter.get_pointer();
+            const char* run;
+            if (in_quote)
+                run = scan_quoted(p, m_end, cq);
+            else
+                run = scan_plain(p, m_end, oq, get_delims(command_word, redir_arg, !first_slash), command_word && !redir_arg);
+            if (run > p)
+            {
+                skip_to(run);
+                end_word = run;
+            }
+        }
+
         if (in_quote)
         {
             if (!m_iter.more())
@@ -643,7 +771,7 @@ word_token cmd_word_tokeniser::next(uint32& offset, uint32& length)
             // Space or equal or semicolon is a word break.
             if (new_state == sSpc)
                 break;
-            if (new_state == sTxt && str_chr(get_delims(command_word, redir_arg, !first_slash && !first_char), c))
+            if (new_state == sTxt && is_delim(c, get_delims(command_word, redir_arg, !first_slash && !first_char)))
                 break;
 
             // Normal text always updates the end of the word.
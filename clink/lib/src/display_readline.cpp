@@ -34,6 +34,8 @@
 #include <core/log.h>
 #include <core/settings.h>
 #include <core/debugheap.h>
+#include <core/session_stats.h>
+#include <core/trace.h>
 #include <terminal/ecma48_iter.h>
 #include <terminal/wcwidth.h>
 #include <terminal/terminal_helpers.h>
@@ -1763,6 +1765,9 @@ int32 display_manager::write_with_clear(FILE* stream, const char* text, int leng
 //------------------------------------------------------------------------------
 void display_manager::display()
 {
+    TRACE_SCOPE("display");
+    LATENCY_SCOPE(display);
+
     static const char* const UP = tgetstr("UP", nullptr);
 
     assert(g_printer);
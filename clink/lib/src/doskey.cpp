@@ -4,6 +4,7 @@
 #include "pch.h"
 #include "doskey.h"
 #include "cmd_tokenisers.h"
+#include "alias_cache.h"
 
 #include <core/base.h>
 #include <core/settings.h>
@@ -29,10 +30,9 @@ setting_bool g_enhanced_doskey(
 
 
 //------------------------------------------------------------------------------
-static bool get_alias(const wchar_t* shell_name, str_iter& in, uint32& skipped, str_base& alias, str_base& text, int32& parens, bool relaxed=false)
+static const doskey_macro* get_alias(alias_snapshot& aliases, str_iter& in, uint32& skipped, str_base& alias, doskey_macro& temp, int32& parens, bool relaxed=false)
 {
     alias.clear();
-    text.clear();
 
     // Skip leading spaces and parens.
     bool first = true;
@@ -45,7 +45,7 @@ static bool get_alias(const wchar_t* shell_name, str_iter& in, uint32& skipped,
     if (in.more() && *start == ' ')
     {
         in.reset_pointer(orig);
-        return false;
+        return nullptr;
     }
 
     while (true)
@@ -76,27 +76,19 @@ static bool get_alias(const wchar_t* shell_name, str_iter& in, uint32& skipped,
 fallback:
         in.reset_pointer(orig);
         if (relaxed || !g_enhanced_doskey.get())
-            return false;
-        return get_alias(shell_name, in, skipped, alias, text, parens, true);
+            return nullptr;
+        return get_alias(aliases, in, skipped, alias, temp, parens, true);
     }
 
-    // Find the alias' text. First check it exists.
-    wchar_t unused;
-    wstr<32> walias(alias.c_str());
-    if (!GetConsoleAliasW(walias.data(), &unused, sizeof(unused), const_cast<wchar_t*>(shell_name)))
-        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
-            goto fallback;
-
-    // It does. Allocate space and fetch it.
-    wstr_moveable wtext;
-    wtext.reserve(8192, true/*exact*/);
-    GetConsoleAliasW(walias.data(), wtext.data(), wtext.size(), const_cast<wchar_t*>(shell_name));
-    text = wtext.c_str();
+    // Find the alias' compiled macro.
+    const doskey_macro* macro = aliases.find_macro(alias.c_str(), temp);
+    if (!macro)
+        goto fallback;
 
     // Advance the iterator.
     while (in.peek() == ' ')
         in.next();
-    return true;
+    return macro;
 }
 
 //------------------------------------------------------------------------------
@@ -152,6 +144,7 @@ public:
                             ~str_stream();
     void                    operator << (TYPE c);
     void                    operator << (const range_desc desc);
+    void                    reserve(uint32 count);
     uint32                  length() const;
     uint32                  trimmed_length() const;
     void                    collect(str_impl<TYPE>& out);
@@ -194,8 +187,15 @@ void str_stream::operator << (const range_desc desc)
     if (m_cursor + desc.count >= m_end)
         grow(desc.count);
 
-    for (uint32 i = 0; i < desc.count; ++i, ++m_cursor)
-        *m_cursor = desc.ptr[i];
+    memcpy(m_cursor, desc.ptr, desc.count * sizeof(TYPE));
+    m_cursor += desc.count;
+}
+
+//------------------------------------------------------------------------------
+void str_stream::reserve(uint32 count)
+{
+    if (m_cursor + count >= m_end)
+        grow(count);
 }
 
 //------------------------------------------------------------------------------
@@ -284,6 +284,98 @@ doskey_alias::operator bool () const
 
 
 
+//------------------------------------------------------------------------------
+void doskey_macro::compile(const char* text)
+{
+    m_ops.clear();
+    m_literals.clear();
+    m_quoted_args = false;
+
+    // Suppose `ps=powershell "$*"`, then the `|` should be passed to
+    // powershell when `ps applet |Format-Table` is used.  So if $* or $1..9
+    // exists inside quotes, the input isn't split at command separators.
+    {
+        bool quote = false;
+        str_iter macro(text, int32(strlen(text)));
+        while (macro.more())
+        {
+            const int32 c = macro.next();
+            if (c == '\"')
+                quote = !quote;
+            if (c != '$')
+                continue;
+
+            const int32 tag = macro.peek();
+            if ((tag == '*') || (tag >= '1' && tag <= '9'))
+            {
+                if (quote)
+                {
+                    m_quoted_args = true;
+                    break;
+                }
+            }
+            else if (tag == '$')
+            {
+                // Skip both chars of '$$' tag.
+                macro.next();
+            }
+        }
+    }
+
+    // Adjacent literal chars, including converted $x tags, share one op.
+    auto add_literal = [this] (const char* chars, uint32 len)
+    {
+        if (!m_ops.empty() && m_ops.back().arg == literal)
+            m_ops.back().length += len;
+        else
+            m_ops.push_back({ literal, m_literals.length(), len });
+        m_literals.concat(chars, int32(len));
+    };
+
+    for (const char* read = text; *read; ++read)
+    {
+        char c = *read;
+        if (c != '$')
+        {
+            add_literal(&c, 1);
+            continue;
+        }
+
+        c = *++read;
+        if (!c)
+            break;
+
+        // Convert $x tags.
+        char o = 0;
+        switch (c)
+        {
+        case '$':           o = '$';  break;
+        case 'g': case 'G': o = '>';  break;
+        case 'l': case 'L': o = '<';  break;
+        case 'b': case 'B': o = '|';  break;
+        case 't': case 'T': o = '\n'; break;
+        }
+        if (o)
+        {
+            add_literal(&o, 1);
+            continue;
+        }
+
+        // Unknown tag? Perhaps it is a argument one?
+        if (unsigned(c - '1') < 9)
+            m_ops.push_back({ c - '1', 0, 0 });
+        else if (c == '*')
+            m_ops.push_back({ all_args, 0, 0 });
+        else
+        {
+            const char tag[] = { '$', c };
+            add_literal(tag, 2);
+        }
+    }
+}
+
+
+
 //------------------------------------------------------------------------------
 doskey::doskey(const char* shell_name)
 : m_shell_name(shell_name)
@@ -301,6 +393,7 @@ bool doskey::add_alias(const char* alias, const char* text)
 {
     wstr<64> walias(alias);
     wstr<> wtext(text);
+    alias_snapshot::invalidate();
     return (AddConsoleAliasW(walias.data(), wtext.data(), m_shell_name.data()) == TRUE);
 }
 
@@ -308,6 +401,7 @@ bool doskey::add_alias(const char* alias, const char* text)
 bool doskey::remove_alias(const char* alias)
 {
     wstr<64> walias(alias);
+    alias_snapshot::invalidate();
     return (AddConsoleAliasW(walias.data(), nullptr, m_shell_name.data()) == TRUE);
 }
 
@@ -319,12 +413,13 @@ bool doskey::resolve_impl(str_iter& s, str_stream& out, int32* _point)
     str_iter command = s;
     str_iter in = s;
 
-    // Get alias and macro text.
+    // Get alias and compiled macro.
     str<32> alias;
-    str<32> text;
+    doskey_macro temp;
     uint32 skipped;
     int32 parens;
-    if (!get_alias(m_shell_name.data(), in, skipped, alias, text, parens))
+    const doskey_macro* macro = get_alias(alias_snapshot::get(m_shell_name.c_str()), in, skipped, alias, temp, parens);
+    if (!macro)
         return false;
     out << str_stream::range(s.get_pointer(), skipped);
 
@@ -363,38 +458,7 @@ bool doskey::resolve_impl(str_iter& s, str_stream& out, int32* _point)
 
     // Either split the input at the next command separator, or use the entire
     // input, depending on the doskey.enhanced setting and the macro text.
-    bool split = g_enhanced_doskey.get();
-    if (split)
-    {
-        bool quote = false;
-        str_iter macro(text.c_str(), text.length());
-        while (macro.more())
-        {
-            const int32 c = macro.next();
-            if (c == '\"')
-                quote = !quote;
-            if (c != '$')
-                continue;
-
-            const int32 tag = macro.peek();
-            if ((tag == '*') || (tag >= '1' && tag <= '9'))
-            {
-                // $* or $1..9 exists inside quotes:  don't split.
-                // Suppose `ps=powershell "$*"`, then the `|` should be passed
-                // to powershell when `ps applet |Format-Table` is used.
-                if (quote)
-                {
-                    split = false;
-                    break;
-                }
-            }
-            else if (tag == '$')
-            {
-                // Skip both chars of '$$' tag.
-                macro.next();
-            }
-        }
-    }
+    const bool split = g_enhanced_doskey.get() && !macro->m_quoted_args;
     if (split)
     {
         // Restrict to resolve only up to the command separator.
@@ -483,55 +547,39 @@ bool doskey::resolve_impl(str_iter& s, str_stream& out, int32* _point)
     }
 #endif
 
-    // Expand the alias' text into 'out'.
-    bool set_point = !!point;
-    str_stream& stream = out;
-    const char* read = text.c_str();
-    int32 last_arg_resolved = -1;
-    for (int32 c = *read; c = *read; ++read)
+    // Expand the macro into 'out'.  The expanded length is known before
+    // copying anything, so the stream grows at most once.
+    const int32 arg_count = args.size();
+    uint32 expanded_len = macro->m_literals.length();
+    if (arg_count)
     {
-        if (c != '$')
-        {
-            stream << c;
-            continue;
-        }
-
-        c = *++read;
-        if (!c)
-            break;
-
-        // Convert $x tags.
-        char o = 0;
-        switch (c)
-        {
-        case '$':           o = '$';  break;
-        case 'g': case 'G': o = '>';  break;
-        case 'l': case 'L': o = '<';  break;
-        case 'b': case 'B': o = '|';  break;
-        case 't': case 'T': o = '\n'; break;
-        }
-        if (o)
+        for (const auto& op : macro->m_ops)
         {
-            if (o == '\n')
-                set_point = false; // Only adjust point for the first line.
-            stream << o;
-            continue;
+            if (op.arg == doskey_macro::all_args)
+                expanded_len += uint32(command.get_pointer() + command.length() - args.front()->ptr);
+            else if (op.arg >= 0 && op.arg < arg_count)
+                expanded_len += args.front()[op.arg].length;
         }
+    }
 
-        // Unknown tag? Perhaps it is a argument one?
-        if (unsigned(c - '1') < 9)  c -= '1';
-        else if (c == '*')          c = -1;
-        else
+    str_stream& stream = out;
+    stream.reserve(expanded_len);
+    const char* const literals = macro->m_literals.c_str();
+    int32 last_arg_resolved = -1;
+    for (const auto& op : macro->m_ops)
+    {
+        if (op.arg == doskey_macro::literal)
         {
-            stream << '$';
-            stream << c;
+            stream << str_stream::range(literals + op.offset, op.length);
             continue;
         }
 
-        int32 arg_count = args.size();
         if (!arg_count)
             continue;
 
+        // 'c' is the arg index or -1 if it is all of them.
+        const int32 c = op.arg;
+
         // Adjust point.
         if (point)
         {
@@ -590,7 +638,7 @@ bool doskey::resolve_impl(str_iter& s, str_stream& out, int32* _point)
             last_arg_resolved = c;
         }
 
-        // 'c' is now the arg index or -1 if it is all of them to be inserted.
+        // Insert the arg, or all of them.
         if (c < 0)
         {
             const char* end = command.get_pointer() + command.length();
@@ -639,6 +687,9 @@ void doskey::resolve(const char* chars, doskey_alias& out, int32* point)
 
     out.reset();
 
+    // Aliases may have changed since the previous line.
+    alias_snapshot::get(m_shell_name.c_str()).validate();
+
     str_stream stream;
 
     bool resolves = false;
@@ -33,6 +33,8 @@
 #include <core/str_tokeniser.h>
 #include <core/settings.h>
 #include <core/log.h>
+#include <core/session_stats.h>
+#include <core/trace.h>
 #include <terminal/terminal_in.h>
 #include <terminal/terminal_out.h>
 #include <terminal/input_idle.h>
@@ -247,6 +249,10 @@ line_editor_impl::line_editor_impl(const desc& desc)
     add_module(m_textlist);
     add_module(m_suggestionlist);
 
+    // Look up aliases in the shared snapshot rather than asking the console
+    // about each command word.
+    m_collector.init_alias_cache();
+
     key_tester* old_tester = desc.input->set_key_tester(this);
     assert(!old_tester);
 }
@@ -325,6 +331,7 @@ void line_editor_impl::begin_line()
     m_desc.output->begin();
     m_buffer.begin_line();
 
+    m_collector.clear_cache();
     m_prev_generate.clear();
     m_prev_plain = false;
     m_prev_cursor = 0;
@@ -519,9 +526,13 @@ bool line_editor_impl::update()
     maybe_handle_signal();
 
     if (!check_flag(flag_editing))
+    {
+        latency_key_handled();
         return false;
+    }
 
     update_internal();
+    latency_key_handled();
     return true;
 }
 
@@ -587,6 +598,8 @@ bool line_editor_impl::notify_matches_ready(int32 generation_id, matches* matche
     rollback<bool> rb(m_in_matches_ready, true);
 #endif
 
+    m_partial_generation_id = -1;
+
     // The generation matches, then use the newly generated matches.
     if (matches && generation_id == m_matches_generation_id)
     {
@@ -641,6 +654,35 @@ bool line_editor_impl::notify_matches_ready(int32 generation_id, matches* matche
     return true;
 }
 
+//------------------------------------------------------------------------------
+// Shows matches from a generator that's still running.  The matches are
+// volatile, so if completion is invoked before the generator finishes then
+// matches are generated anew, and notify_matches_ready() replaces them when
+// the generator finishes.
+bool line_editor_impl::notify_matches_partial(int32 generation_id, matches* matches)
+{
+    if (!matches || generation_id != m_matches_generation_id)
+        return false;
+
+    assert(&m_matches != matches);
+    m_matches.copy(static_cast<matches_impl&>(*matches));
+    m_matches.done_building();
+    m_partial_generation_id = generation_id;
+
+    if (get_log_generators())
+    {
+        LOG("PARTIAL MATCHES: %u matches, gen %d", m_matches.get_match_count(), generation_id);
+    }
+
+    // The partial matches are volatile; don't let try_suggest() regenerate
+    // matches because of that (see notify_matches_ready()).
+    {
+        ignore_volatile_matches ignore(m_matches);
+        try_suggest();
+    }
+    return true;
+}
+
 //------------------------------------------------------------------------------
 void line_editor_impl::notify_matches_changed(const char* needle)
 {
@@ -653,6 +695,8 @@ void line_editor_impl::notify_matches_changed(const char* needle)
 //------------------------------------------------------------------------------
 void line_editor_impl::update_matches()
 {
+    TRACE_SCOPE("update_matches");
+
     if (m_matches.is_volatile())
         reset_generate_matches();
 
@@ -786,6 +830,9 @@ matches* line_editor_impl::maybe_regenerate_matches(const char* needle, display_
 //------------------------------------------------------------------------------
 void line_editor_impl::dispatch(int32 bind_group)
 {
+    TRACE_SCOPE("dispatch");
+    LATENCY_SCOPE(dispatch);
+
     assert(check_flag(flag_init));
     assert(check_flag(flag_editing));
 
@@ -794,6 +841,10 @@ void line_editor_impl::dispatch(int32 bind_group)
     if (m_pending_binding)
         m_pending_binding->claim();
 
+    // Collected words are only reused within one keystroke, since they can
+    // depend on state that changes between keys (e.g. loaded argmatchers).
+    m_collector.clear_cache();
+
     // Handle one input.
 
     const int32 prev_bind_group = m_bind_resolver.get_group();
@@ -871,6 +922,8 @@ bool line_editor_impl::translate(const char* seq, int32 len, str_base& out)
 // to help dispatch() be able to dispatch an entire chord.
 bool line_editor_impl::update_input()
 {
+    TRACE_SCOPE("update_input");
+
     if (maybe_handle_signal())
         return true;
 
@@ -1594,6 +1647,9 @@ matches* line_editor_impl::get_mutable_matches(bool nosort)
 //------------------------------------------------------------------------------
 void line_editor_impl::update_internal(bool force)
 {
+    TRACE_SCOPE("update_internal");
+    LATENCY_SCOPE(update_internal);
+
     // This is responsible for updating the matches for the word under the
     // cursor.  It tries to call match generators only once for the current
     // word, and then repeatedly filter the results as the word is edited.
@@ -1763,8 +1819,13 @@ void line_editor_impl::try_suggest()
         }
 
         // Never generate matches here; let it be deferred and happen on demand
-        // in a coroutine.
-        if (!empty_matches && (!g_autosuggest_async.get() ||
+        // in a coroutine.  Partial matches from that coroutine can be used
+        // while it's still running.
+        if (!empty_matches && m_partial_generation_id == m_matches_generation_id)
+        {
+            matches = &m_matches;
+        }
+        else if (!empty_matches && (!g_autosuggest_async.get() ||
                                (!check_flag(flag_generate) && !m_matches.is_volatile())))
         {
             // Suggestions must use the TAB completion type, because they
@@ -92,6 +92,7 @@ public:
 #endif
     void                maybe_collect_words();
     bool                notify_matches_ready(int32 generation_id, matches* matches);
+    bool                notify_matches_partial(int32 generation_id, matches* matches);
     matches*            maybe_regenerate_matches(const char* needle, display_filter_flags flags);
     bool                call_lua_rl_global_function(const char* func_name);
     uint32              collect_words(const line_buffer& buffer, words& words, collect_words_mode mode) const;
@@ -175,6 +176,7 @@ private:
     key_t               m_prev_key;
     uint8               m_flags = 0;
     int32               m_matches_generation_id = 0;
+    int32               m_partial_generation_id = -1;
     str<64>             m_needle;
 
     prev_buffer         m_prev_generate;
@@ -118,12 +118,14 @@ void reselect_matches()
 //------------------------------------------------------------------------------
 static str_unordered_set s_deprecated_argmatchers;
 static linear_allocator s_deprecated_argmatchers_store(1024);
+static uint32 s_deprecated_argmatchers_generation = 0;
 
 //------------------------------------------------------------------------------
 void clear_deprecated_argmatchers()
 {
     s_deprecated_argmatchers.clear();
     s_deprecated_argmatchers_store.reset();
+    ++s_deprecated_argmatchers_generation;
 }
 
 //------------------------------------------------------------------------------
@@ -134,6 +136,7 @@ void mark_deprecated_argmatcher(const char* command)
         dbg_ignore_scope(snapshot, "deprecated argmatcher lookup");
         const char* store = s_deprecated_argmatchers_store.store(command);
         s_deprecated_argmatchers.insert(store);
+        ++s_deprecated_argmatchers_generation;
     }
 }
 
@@ -145,6 +148,14 @@ bool has_deprecated_argmatcher(const char* command)
     return s_deprecated_argmatchers.find(name.c_str()) != s_deprecated_argmatchers.end();
 }
 
+//------------------------------------------------------------------------------
+// Changes whenever argmatchers are marked deprecated (e.g. when scripts load
+// while idle), so cached word lists can tell they may be stale.
+uint32 get_deprecated_argmatcher_generation()
+{
+    return s_deprecated_argmatchers_generation;
+}
+
 
 
 //------------------------------------------------------------------------------
@@ -373,6 +384,17 @@ bool notify_matches_ready(std::shared_ptr<match_builder_toolkit> toolkit, int32
     return s_editor->notify_matches_ready(generation_id, matches);
 }
 
+//------------------------------------------------------------------------------
+// WARNING:  This calls Lua using the MAIN coroutine.
+bool notify_matches_partial(std::shared_ptr<match_builder_toolkit> partial, int32 generation_id)
+{
+    if (!s_editor || !partial)
+        return false;
+
+    matches* matches = partial->get_matches();
+    return s_editor->notify_matches_partial(generation_id, matches);
+}
+
 //------------------------------------------------------------------------------
 // WARNING:  This calls Lua using the MAIN coroutine.
 void override_line_state(const char* line, const char* needle, int32 point)
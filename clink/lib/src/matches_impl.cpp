@@ -430,6 +430,19 @@ std::shared_ptr<match_builder_toolkit> make_match_builder_toolkit(int32 generati
     return std::make_shared<match_builder_toolkit_impl>(generation_id, end_word_offset);
 }
 
+//------------------------------------------------------------------------------
+// Makes a toolkit that starts with a copy of the matches generated so far.
+// Its matches are volatile, since they're only a preview of matches that are
+// still being generated.
+std::shared_ptr<match_builder_toolkit> make_partial_match_builder_toolkit(const std::shared_ptr<match_builder_toolkit>& toolkit)
+{
+    const matches_impl* from = static_cast<const matches_impl*>(toolkit->get_matches());
+    auto partial = std::make_shared<match_builder_toolkit_impl>(toolkit->get_generation_id(), 0);
+    static_cast<matches_impl*>(partial->get_matches())->copy(*from);
+    partial->get_builder()->set_volatile();
+    return partial;
+}
+
 
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,344 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "path_index.h"
+
+#include <core/os.h>
+#include <core/path.h>
+#include <core/globber.h>
+#include <core/str_tokeniser.h>
+#include <core/str_transform.h>
+#include <core/debugheap.h>
+
+//------------------------------------------------------------------------------
+// Returns true if the path doesn't depend on the current directory or the
+// current drive.
+static bool is_absolute_path(const char* path)
+{
+    if (path::is_unc(path))
+        return true;
+
+    path += path::past_ssqs(path);
+    return (path[0] && path[1] == ':' && path::is_separator(path[2]));
+}
+
+
+
+//------------------------------------------------------------------------------
+// Revalidates the index against the current %PATH% and %PATHEXT% and against
+// the last modified time of each directory, and rebuilds whatever is out of
+// date.  Returns true if the index changed.
+bool path_index::refresh()
+{
+    str<> path;
+    str<> pathext;
+    os::get_env("PATH", path);
+    os::get_env("PATHEXT", pathext);
+
+    dbg_ignore_scope(snapshot, "Recognizer path index");
+
+    bool changed = !m_built;
+
+    // Names are only indexed when their extension is in %PATHEXT%, so a change
+    // to %PATHEXT% requires reloading every directory.
+    const bool pathext_changed = (!m_built || !m_pathext.equals(pathext.c_str()));
+    if (pathext_changed)
+    {
+        m_pathext = pathext.c_str();
+        parse_pathext(pathext.c_str());
+    }
+
+    if (pathext_changed || !m_path.equals(path.c_str()))
+    {
+        m_path = path.c_str();
+        parse_path(path.c_str(), !pathext_changed);
+        changed = true;
+    }
+
+    for (auto& dir : m_dirs)
+    {
+        if (update_dir(dir))
+            changed = true;
+    }
+
+    if (changed)
+        rebuild_map();
+
+    m_built = true;
+    return changed;
+}
+
+//------------------------------------------------------------------------------
+// Looks up a command word (with no path component) in the index.  Returns 1
+// and the full path name of the executable file if found, or 0 if not found,
+// or -1 if the index is unable to answer and the caller must probe the file
+// system instead.
+int32 path_index::lookup(const char* word, str_base& out) const
+{
+    if (!m_built || m_relative || m_exts.empty())
+        return -1;
+    if (!*word || strpbrk(word, "\\/:*?"))
+        return -1;
+
+    str<> lower;
+    str_transform(word, -1, lower, transform_mode::lower);
+
+    // A word with an extension that isn't in %PATHEXT% might still be
+    // executable via a file association, which the index doesn't track.
+    const char* ext = path::get_extension(lower.c_str());
+    int32 word_ext = -1;
+    if (ext)
+    {
+        word_ext = find_ext(ext);
+        if (word_ext < 0 || ext == lower.c_str())
+            return -1;
+    }
+
+    // The word itself, e.g. "foo.exe".  Within a directory this takes
+    // precedence over appending an extension, e.g. "foo.exe.bat".
+    hit best;
+    bool found = false;
+    bool self = false;
+    if (word_ext >= 0)
+    {
+        str<> stem;
+        stem.concat(lower.c_str(), int32(ext - lower.c_str()));
+        found = self = find_best(stem.c_str(), word_ext, best);
+    }
+
+    // The word with an extension appended.
+    hit appended;
+    if (find_best(lower.c_str(), -1, appended) && (!found || appended.dir < best.dir))
+    {
+        best = appended;
+        found = true;
+        self = false;
+    }
+
+    if (!found)
+        return 0;
+
+    path::join(m_dirs[best.dir].path.c_str(), word, out);
+    if (!self)
+        out.concat(m_exts[best.ext].c_str());
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+void path_index::clear()
+{
+    m_map.clear();
+    m_dirs.clear();
+    m_exts.clear();
+    m_path.free();
+    m_pathext.free();
+    m_built = false;
+    m_relative = false;
+}
+
+//------------------------------------------------------------------------------
+void path_index::parse_pathext(const char* pathext)
+{
+    m_exts.clear();
+
+    str<16> token;
+    str_tokeniser tokens(pathext, ";");
+    while (tokens.next(token))
+    {
+        token.trim();
+        if (token.length() > 1 && token.c_str()[0] == '.' && find_ext(token.c_str()) < 0)
+            m_exts.emplace_back(token.c_str());
+    }
+}
+
+//------------------------------------------------------------------------------
+void path_index::parse_path(const char* path, bool keep_loaded)
+{
+    std::vector<dir_info> old_dirs(std::move(m_dirs));
+    m_dirs.clear();
+    m_relative = false;
+
+    str<280> token;
+    str<280> full;
+    str_tokeniser tokens(path, ";");
+    while (tokens.next(token))
+    {
+        token.trim();
+        if (token.empty())
+            continue;
+
+        // Relative directories depend on the current directory, which can
+        // differ per lookup; let the caller probe the file system instead.
+        if (!is_absolute_path(token.c_str()))
+        {
+            m_relative = true;
+            continue;
+        }
+
+        // UNC paths can take up to 2 minutes to time out, and the recognizer
+        // skips remote directories in %PATH% anyway.
+        if (path::is_unc(token.c_str()))
+            continue;
+
+        if (!os::get_full_path_name(token.c_str(), full, token.length()))
+            continue;
+
+        if (m_dirs.size() >= 0xffff)
+            break;
+
+        // Reuse directories that were already loaded, e.g. when a directory
+        // is prepended to %PATH%.
+        dir_info dir;
+        if (keep_loaded)
+        {
+            for (auto& old : old_dirs)
+            {
+                if (old.loaded && old.path.iequals(full.c_str()))
+                {
+                    dir = std::move(old);
+                    old.loaded = false;
+                    break;
+                }
+            }
+        }
+
+        if (!dir.loaded)
+            dir.path = full.c_str();
+
+        m_dirs.emplace_back(std::move(dir));
+    }
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the directory's names changed.
+bool path_index::update_dir(dir_info& dir)
+{
+    // Skip drives that are unknown, invalid, or remote.
+    char drive[4];
+    drive[0] = dir.path.c_str()[path::past_ssqs(dir.path.c_str())];
+    drive[1] = ':';
+    drive[2] = '\\';
+    drive[3] = '\0';
+    if (os::get_drive_type(drive) <= os::drive_type_remote)
+    {
+        const bool had_names = !dir.names.empty();
+        dir.names.clear();
+        dir.usable = false;
+        dir.loaded = false;
+        return had_names;
+    }
+
+    dir.usable = true;
+
+    // Adding, removing, or renaming a file updates the directory's last write
+    // time.  A directory that doesn't exist has a zero time, and is loaded
+    // again if it gets created.
+    FILETIME mtime = {};
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    wstr<280> wpath(dir.path.c_str());
+    if (GetFileAttributesExW(wpath.c_str(), GetFileExInfoStandard, &data) &&
+        (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        mtime = data.ftLastWriteTime;
+
+    if (dir.loaded && CompareFileTime(&mtime, &dir.mtime) == 0)
+        return false;
+
+    // The time is captured before enumerating, so a change that happens
+    // while enumerating is picked up by the next refresh.
+    dir.mtime = mtime;
+    load_dir(dir);
+    dir.loaded = true;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void path_index::load_dir(dir_info& dir)
+{
+    dir.names.clear();
+
+    str<280> pattern;
+    path::join(dir.path.c_str(), "*", pattern);
+
+    // This runs on the recognizer thread, where settings can't be read.  And
+    // PATH directories would crowd the directories being completed out of the
+    // listing cache, so don't use it.
+    globber files(pattern.c_str(), false/*use_cache*/);
+    files.directories(false);
+    files.hidden(true);
+    files.system(true);
+
+    str<280> name;
+    str<280> lower;
+    while (files.next(name, false))
+    {
+        str_transform(name.c_str(), name.length(), lower, transform_mode::lower);
+
+        const char* ext = path::get_extension(lower.c_str());
+        if (!ext || ext == lower.c_str())
+            continue;
+
+        const int32 index = find_ext(ext);
+        if (index < 0)
+            continue;
+
+        indexed_name indexed;
+        indexed.stem.concat(lower.c_str(), int32(ext - lower.c_str()));
+        indexed.ext = index;
+        dir.names.emplace_back(std::move(indexed));
+    }
+}
+
+//------------------------------------------------------------------------------
+void path_index::rebuild_map()
+{
+    m_map.clear();
+
+    // Hits are appended in %PATH% order.  The keys point into the names owned
+    // by m_dirs, which stay put until the next rebuild.
+    for (uint32 d = 0; d < m_dirs.size(); ++d)
+    {
+        for (const auto& indexed : m_dirs[d].names)
+        {
+            hit h;
+            h.dir = uint16(d);
+            h.ext = uint16(indexed.ext);
+            m_map[indexed.stem.c_str()].emplace_back(h);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+int32 path_index::find_ext(const char* ext) const
+{
+    for (uint32 i = 0; i < m_exts.size(); ++i)
+    {
+        if (m_exts[i].iequals(ext))
+            return int32(i);
+    }
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+// Finds the first directory with a hit for the stem, and within that directory
+// the extension that comes first in %PATHEXT%.  If only_ext is not negative,
+// then only hits with that extension are considered.
+bool path_index::find_best(const char* stem, int32 only_ext, hit& best) const
+{
+    auto const iter = m_map.find(stem);
+    if (iter == m_map.end())
+        return false;
+
+    bool found = false;
+    for (const auto& h : iter->second)
+    {
+        if (only_ext >= 0 && h.ext != only_ext)
+            continue;
+        if (found && h.dir != best.dir)
+            break;
+        if (!found || h.ext < best.ext)
+            best = h;
+        found = true;
+    }
+    return found;
+}
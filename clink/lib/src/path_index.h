@@ -0,0 +1,66 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+#include <core/str_unordered_set.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Index of the executable files in the directories listed in %PATH%.  Maps the
+// lowercase stem of each file whose extension is listed in %PATHEXT% to the
+// directories and extensions where it exists, in %PATH% order.  This lets the
+// recognizer resolve a command word with a hash lookup instead of probing the
+// file system for every %PATHEXT% extension in every %PATH% directory.
+//
+// The index is not thread safe; it's owned by the recognizer thread.
+class path_index
+{
+    struct indexed_name
+    {
+        str_moveable    stem;
+        uint32          ext;
+    };
+
+    struct dir_info
+    {
+        str_moveable    path;
+        FILETIME        mtime = {};
+        bool            usable = false;
+        bool            loaded = false;
+        std::vector<indexed_name> names;
+    };
+
+    struct hit
+    {
+        uint16          dir;
+        uint16          ext;
+    };
+
+public:
+    bool            refresh();
+    int32           lookup(const char* word, str_base& out) const;
+    void            clear();
+    uint32          get_dir_count() const { return uint32(m_dirs.size()); }
+    uint32          get_name_count() const { return uint32(m_map.size()); }
+
+private:
+    void            parse_pathext(const char* pathext);
+    void            parse_path(const char* path, bool keep_loaded);
+    bool            update_dir(dir_info& dir);
+    void            load_dir(dir_info& dir);
+    void            rebuild_map();
+    int32           find_ext(const char* ext) const;
+    bool            find_best(const char* stem, int32 only_ext, hit& best) const;
+
+private:
+    str_moveable    m_path;
+    str_moveable    m_pathext;
+    std::vector<str_moveable> m_exts;
+    std::vector<dir_info> m_dirs;
+    str_unordered_map<std::vector<hit>> m_map;
+    bool            m_built = false;
+    bool            m_relative = false;
+};
@@ -3,8 +3,10 @@
 
 #include "pch.h"
 #include "intercept.h"
+#include "path_index.h"
 #include "reclassify.h"
 #include "recognizer.h"
+#include "recognizer_cache.h"
 
 #include <core/os.h>
 #include <core/path.h>
@@ -16,7 +18,9 @@
 #include <core/settings.h>
 #include <core/linear_allocator.h>
 #include <core/debugheap.h>
+#include <lib/host_callbacks.h>
 
+#include <algorithm>
 #include <memory>
 #include <thread>
 #include <mutex>
@@ -35,6 +39,16 @@ extern "C" {
 extern setting_color g_color_unrecognized;
 extern setting_color g_color_executable;
 
+static setting_bool g_recognizer_cache(
+    "clink.recognizer_cache",
+    "Share recognized commands between sessions",
+    "When enabled, the results of recognizing command words for input line\n"
+    "coloring are saved in the profile directory and shared with other sessions.\n"
+    "A new session can then color familiar commands immediately, while they're\n"
+    "checked again in the background.  Saved results are discarded after a week,\n"
+    "or when the %PATH% or %PATHEXT% environment variables are different.",
+    false);
+
 //------------------------------------------------------------------------------
 static bool is_absolute_drive(const char* path)
 {
@@ -87,6 +101,7 @@ class recognizer
         char*               m_key; // Owns lifetime of the key in m_cache or m_pending.
         str_moveable        m_file;
         time_t              m_age;
+        time_t              m_persisted;    // When saved to the persistent cache, or 0.
         recognition         m_recognition;
         bool                m_outofdate;
     };
@@ -94,11 +109,11 @@ class recognizer
     struct entry
     {
                             entry() {}
-        bool                empty() const { return m_key.empty(); }
-        void                clear();
         str_moveable        m_key;
         str_moveable        m_word;
         str_moveable        m_cwd;
+        uint32              m_priority = 0;     // Lower is sooner.
+        uint32              m_sequence = 0;
     };
 
 public:
@@ -107,28 +122,40 @@ public:
     void                    shutdown();
     void                    clear();
     int32                   find(const char* key, recognition& cached, str_base* file) const;
-    bool                    enqueue(const char* key, const char* word, const char* cwd, const recognition* cached=nullptr);
+    bool                    enqueue(const char* key, const char* word, const char* cwd, uint32 priority, const recognition* cached=nullptr);
     bool                    need_refresh();
     void                    end_line();
 
     void                    wait_while_busy();
+    void                    load_persistent();
 
 private:
     bool                    usable() const;
     bool                    busy() const;
-    bool                    store(const char* word, const char* file, recognition cached, bool pending=false);
-    bool                    dequeue(entry& entry);
+    bool                    store(const char* word, const char* file, recognition cached, bool pending=false, time_t persisted=0);
+    void                    erase_pending(const char* word);
+    void                    clear_pending();
+    bool                    dequeue(std::vector<entry>& batch);
     bool                    set_result_available(bool available);
     void                    notify_ready(bool available);
     static bool             file_exists(const char* full, str_base& out);
     static bool             search_for_extension(str_base& full, const char* word, str_base& out);
-    static recognition      search_for_executable(const entry& entry, str_base& out);
+    recognition             search_for_executable(const entry& entry, str_base& out);
+    time_t                  maybe_persist(const entry& entry, const char* file, recognition result, uint32 path_hash);
+    void                    save_persistent(bool force);
+    static bool             get_persistent_path(str_base& out);
     static void             proc(recognizer* r);
 
 private:
     str_unordered_map<cache_entry> m_cache;
     str_unordered_map<cache_entry> m_pending;
-    entry                   m_queue;
+    std::vector<entry>      m_queue;
+    uint32                  m_sequence = 0;
+    path_index              m_index;        // Only used by the thread.
+    std::vector<recognizer_cache_entry> m_persist_queue;
+    str_moveable            m_persist_path;
+    DWORD                   m_persist_tick = 0;
+    bool                    m_persist_loaded = false;
     mutable std::recursive_mutex m_mutex;
     std::unique_ptr<std::thread> m_thread;
     HANDLE                  m_event = nullptr;
@@ -144,12 +171,16 @@ HANDLE recognizer::s_ready_event = nullptr;
 static recognizer s_recognizer;
 
 //------------------------------------------------------------------------------
-void recognizer::entry::clear()
-{
-    m_key.clear();
-    m_word.clear();
-    m_cwd.clear();
-}
+// The queue holds unique keys; once full, a new word only gets in by bumping a
+// queued word that's farther from the cursor.  The thread drains it in batches
+// and notifies once per batch, so a pasted line with many commands converges
+// in a redisplay or two instead of one per command.
+static const uint32 c_max_queue = 64;
+static const uint32 c_max_batch = 16;
+
+// Results for the persistent cache are saved when the queue drains, but not
+// more often than this.
+static const DWORD c_persist_interval = 5000;
 
 //------------------------------------------------------------------------------
 recognizer::recognizer()
@@ -170,14 +201,7 @@ void recognizer::clear()
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
     m_queue.clear();
-
-    for (auto iter = m_pending.begin(); iter != m_pending.end();)
-    {
-        char* key = iter->second.m_key;
-        iter = m_pending.erase(iter);
-        free(key);
-    }
-    assert(m_pending.empty());
+    clear_pending();
 
 #ifdef DEBUG
     const time_t threshold = 60/*secinmin*/ * 1/*minutes*/;
@@ -243,7 +267,7 @@ int32 recognizer::find(const char* key, recognition& cached, str_base* file) con
 }
 
 //------------------------------------------------------------------------------
-bool recognizer::enqueue(const char* key, const char* word, const char* cwd, const recognition* cached)
+bool recognizer::enqueue(const char* key, const char* word, const char* cwd, uint32 priority, const recognition* cached)
 {
     if (!key || !*key || !word || !*word)
     {
@@ -274,9 +298,39 @@ bool recognizer::enqueue(const char* key, const char* word, const char* cwd, con
 
         {
             dbg_ignore_scope(snapshot, "Recognizer queue");
-            m_queue.m_key = key;
-            m_queue.m_word = word;
-            m_queue.m_cwd = cwd;
+
+            auto iter = std::find_if(m_queue.begin(), m_queue.end(), [key](const entry& e) {
+                return e.m_key.equals(key);
+            });
+
+            if (iter == m_queue.end() && m_queue.size() >= c_max_queue)
+            {
+                // Bump the queued word that's farthest from the cursor, if the
+                // new word is closer.
+                auto worst = std::max_element(m_queue.begin(), m_queue.end(), [](const entry& a, const entry& b) {
+                    return (a.m_priority < b.m_priority ||
+                            (a.m_priority == b.m_priority && a.m_sequence < b.m_sequence));
+                });
+                if (worst->m_priority <= priority)
+                    return false;
+                erase_pending(worst->m_key.c_str());
+                m_queue.erase(worst);
+                iter = m_queue.end();
+            }
+
+            if (iter == m_queue.end())
+            {
+                m_queue.emplace_back();
+                iter = m_queue.end() - 1;
+                iter->m_key = key;
+            }
+
+            // The word, cwd, and distance from the cursor may have changed
+            // since the key was queued.
+            iter->m_word = word;
+            iter->m_cwd = cwd;
+            iter->m_priority = priority;
+            iter->m_sequence = ++m_sequence;
         }
 
         store(key, nullptr, cached ? *cached : recognition::unrecognized, true/*pending*/);
@@ -361,7 +415,7 @@ bool recognizer::busy() const
 }
 
 //------------------------------------------------------------------------------
-bool recognizer::store(const char* word, const char* file, recognition cached, bool pending)
+bool recognizer::store(const char* word, const char* file, recognition cached, bool pending, time_t persisted)
 {
     assert(*word);
     if (!*word)
@@ -374,11 +428,17 @@ bool recognizer::store(const char* word, const char* file, recognition cached, b
 
     auto& map = pending ? m_pending : m_cache;
 
+    // A final result replaces the pending entry.  The thread notifies once
+    // per batch, so storing a final result doesn't signal on its own.
+    if (!pending)
+        erase_pending(word);
+
     dbg_ignore_scope(snapshot, "Recognizer");
 
     cache_entry entry;
     entry.m_file = file;
     entry.m_age = time(nullptr);
+    entry.m_persisted = persisted;
     entry.m_recognition = cached;
     entry.m_outofdate = false;
 
@@ -388,7 +448,8 @@ bool recognizer::store(const char* word, const char* file, recognition cached, b
         assert(iter->first == iter->second.m_key);
         entry.m_key = iter->second.m_key;
         map.insert_or_assign(iter->first, std::move(entry));
-        set_result_available(true);
+        if (pending)
+            set_result_available(true);
         return true;
     }
 
@@ -399,20 +460,61 @@ bool recognizer::store(const char* word, const char* file, recognition cached, b
     strcpy(key, word);
     entry.m_key = key;
     map.emplace(key, std::move(entry));
-    set_result_available(true);
+    if (pending)
+        set_result_available(true);
     return true;
 }
 
 //------------------------------------------------------------------------------
-bool recognizer::dequeue(entry& entry)
+void recognizer::erase_pending(const char* word)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    auto const iter = m_pending.find(word);
+    if (iter != m_pending.end())
+    {
+        char* key = iter->second.m_key;
+        m_pending.erase(iter);
+        free(key);
+    }
+}
+
+//------------------------------------------------------------------------------
+void recognizer::clear_pending()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    for (auto iter = m_pending.begin(); iter != m_pending.end();)
+    {
+        char* key = iter->second.m_key;
+        iter = m_pending.erase(iter);
+        free(key);
+    }
+    assert(m_pending.empty());
+}
+
+//------------------------------------------------------------------------------
+bool recognizer::dequeue(std::vector<entry>& batch)
 {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
+    batch.clear();
+
     if (!usable() || m_queue.empty())
         return false;
 
-    entry = std::move(m_queue);
-    assert(m_queue.empty());
+    // Words nearest the cursor first, then in the order they were queued.
+    std::sort(m_queue.begin(), m_queue.end(), [](const entry& a, const entry& b) {
+        if (a.m_priority != b.m_priority)
+            return a.m_priority < b.m_priority;
+        return a.m_sequence < b.m_sequence;
+    });
+
+    const size_t count = min<size_t>(m_queue.size(), c_max_batch);
+    batch.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        batch.emplace_back(std::move(m_queue[i]));
+    m_queue.erase(m_queue.begin(), m_queue.begin() + count);
     return true;
 }
 
@@ -475,6 +577,156 @@ void recognizer::shutdown()
 
     if (m_event)
         CloseHandle(m_event);
+
+    save_persistent(true/*force*/);
+}
+
+//------------------------------------------------------------------------------
+bool recognizer::get_persistent_path(str_base& out)
+{
+    int32 id;
+    host_context context;
+    host_get_app_context(id, context);
+    if (context.profile.empty())
+        return false;
+
+    path::join(context.profile.c_str(), "clink_recognizer_cache", out);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Seeds the cache with results saved by other sessions.  They're marked out
+// of date, so they're used for coloring right away while the thread checks
+// them again.
+void recognizer::load_persistent()
+{
+    if (m_persist_loaded || !g_recognizer_cache.get())
+        return;
+    m_persist_loaded = true;
+
+    str<> path;
+    if (!get_persistent_path(path))
+        return;
+
+    std::vector<recognizer_cache_entry> entries;
+    recognizer_cache cache(path.c_str());
+    cache.load(entries);
+
+    const uint32 path_hash = recognizer_cache::get_path_hash();
+    str<> cwd;
+    os::get_current_dir(cwd);
+    const char cwd_class = recognizer_cache::get_cwd_class(cwd.c_str());
+
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    if (!usable())
+        return;
+
+    dbg_ignore_scope(snapshot, "Recognizer");
+
+    m_persist_path = path.c_str();
+
+    const time_t now = time(nullptr);
+    for (auto& e : entries)
+    {
+        if (e.path_hash != path_hash || e.cwd_class != cwd_class)
+            continue;
+        if (e.recognition != int8(recognition::executable) && e.recognition != int8(recognition::unrecognized))
+            continue;
+        if (m_cache.find(e.word.c_str()) != m_cache.end())
+            continue;
+
+        char* key = static_cast<char*>(malloc(e.word.length() + 1));
+        if (!key)
+            break;
+        strcpy(key, e.word.c_str());
+
+        cache_entry entry;
+        entry.m_key = key;
+        entry.m_file = e.file.c_str();
+        entry.m_age = now;
+        entry.m_persisted = e.age;
+        entry.m_recognition = recognition(e.recognition);
+        entry.m_outofdate = true;
+        m_cache.emplace(key, std::move(entry));
+    }
+}
+
+//------------------------------------------------------------------------------
+// Queues a result to be saved in the persistent cache, if it doesn't depend on
+// the current directory and it differs from (or is refreshing) what's already
+// saved.  Returns when the result was saved, or 0.
+time_t recognizer::maybe_persist(const entry& entry, const char* file, recognition result, uint32 path_hash)
+{
+    if (result != recognition::executable && result != recognition::unrecognized)
+        return 0;
+
+    const char* word = entry.m_word.c_str();
+    if (rl_last_path_separator(word) || strchr(word, ':'))
+        return 0;
+
+    // A file found in the current directory only applies there.
+    if (result == recognition::executable)
+    {
+        str<> dir;
+        str<> cwd(entry.m_cwd.c_str());
+        path::get_directory(file, dir);
+        path::maybe_strip_last_separator(dir);
+        path::maybe_strip_last_separator(cwd);
+        if (dir.iequals(cwd.c_str()))
+            return 0;
+    }
+
+    const time_t now = time(nullptr);
+
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    if (m_persist_path.empty())
+        return 0;
+
+    auto const iter = m_cache.find(entry.m_key.c_str());
+    if (iter != m_cache.end() &&
+        iter->second.m_persisted &&
+        iter->second.m_recognition == result &&
+        iter->second.m_file.iequals(file) &&
+        now - iter->second.m_persisted < recognizer_cache::c_refresh_age)
+        return iter->second.m_persisted;
+
+    dbg_ignore_scope(snapshot, "Recognizer");
+
+    recognizer_cache_entry e;
+    e.word = entry.m_key.c_str();
+    e.file = file;
+    e.age = now;
+    e.path_hash = path_hash;
+    e.cwd_class = recognizer_cache::get_cwd_class(entry.m_cwd.c_str());
+    e.recognition = int8(result);
+    m_persist_queue.emplace_back(std::move(e));
+    return now;
+}
+
+//------------------------------------------------------------------------------
+void recognizer::save_persistent(bool force)
+{
+    std::vector<recognizer_cache_entry> entries;
+    str<> path;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+        if (m_persist_queue.empty() || m_persist_path.empty())
+            return;
+        if (!force && GetTickCount() - m_persist_tick < c_persist_interval)
+            return;
+
+        entries = std::move(m_persist_queue);
+        m_persist_queue.clear();
+        path = m_persist_path.c_str();
+        m_persist_tick = GetTickCount();
+    }
+
+    recognizer_cache cache(path.c_str());
+    cache.save(entries);
 }
 
 //------------------------------------------------------------------------------
@@ -566,6 +818,7 @@ recognition recognizer::search_for_executable(const entry& entry, str_base& out)
     wstr<32> word(_word);
     const bool need_cwd = !!NeedCurrentDirectoryForExePathW(word.c_str());
     const bool need_path = !rl_last_path_separator(_word);
+    bool try_index = need_path && !path::is_rooted(_word);
     recognition fallback = recognition::unrecognized;
 
     // Make list of paths to search.
@@ -599,6 +852,18 @@ recognition recognizer::search_for_executable(const entry& entry, str_base& out)
     int8 no_remote_cwd = -1;
     for (; tokens.next(token); is_cwd = false)
     {
+        // Once past the current directory, try the PATH index before probing
+        // each PATH directory for each PATHEXT extension.
+        if (try_index && !is_cwd)
+        {
+            const int32 indexed = m_index.lookup(_word, out);
+            if (indexed > 0)
+                return recognition::executable;
+            if (indexed == 0)
+                return fallback;
+            try_index = false;
+        }
+
         token.trim();
         if (token.empty())
             continue;
@@ -656,33 +921,59 @@ void recognizer::proc(recognizer* r)
             Sleep(5000);
         }
 
-        entry entry;
+        // Revalidate the PATH index once per wakeup rather than per word.
+        if (!r->m_zombie)
+            r->m_index.refresh();
+
+        std::vector<entry> batch;
+        bool available = false;
+        const uint32 path_hash = recognizer_cache::get_path_hash();
         while (true)
         {
             {
                 std::lock_guard<std::recursive_mutex> lock(r->m_mutex);
-                if (r->m_zombie || !r->dequeue(entry))
+                if (r->m_zombie || !r->dequeue(batch))
                 {
                     r->m_processing = false;
-                    r->m_pending.clear();
+                    r->clear_pending();
                     if (!r->m_zombie)
-                        r->notify_ready(false);
+                        r->notify_ready(available);
                     break;
                 }
                 r->m_processing = true;
             }
 
-            // Search for executable file.
-            str<> found;
-            recognition result = r->search_for_executable(entry, found);
+            for (const auto& entry : batch)
+            {
+                if (r->m_zombie)
+                    break;
 
-            // Store result.
-            r->store(entry.m_key.c_str(), found.c_str(), result);
-            r->notify_ready(true);
+                // Search for executable file.
+                str<> found;
+                recognition result = r->search_for_executable(entry, found);
+
+                // Store result.
+                const time_t persisted = r->maybe_persist(entry, found.c_str(), result, path_hash);
+                r->store(entry.m_key.c_str(), found.c_str(), result, false, persisted);
+            }
+
+            // Notify once per batch.  If nothing else is queued, the notify
+            // when the queue is found empty covers this batch as well.
+            available = true;
+            {
+                std::lock_guard<std::recursive_mutex> lock(r->m_mutex);
+                if (!r->m_queue.empty())
+                {
+                    r->notify_ready(true);
+                    available = false;
+                }
+            }
         }
 
         if (r->m_zombie)
             break;
+
+        r->save_persistent(false);
     }
 
     CoUninitialize();
@@ -731,7 +1022,7 @@ void shutdown_recognizer()
 }
 
 //------------------------------------------------------------------------------
-recognition recognize_command(const char* line, const char* word, bool quoted, bool& ready, str_base* file)
+recognition recognize_command(const char* line, const char* word, bool quoted, bool& ready, str_base* file, uint32 priority)
 {
     assert(word);
 
@@ -797,6 +1088,7 @@ recognition recognize_command(const char* line, const char* word, bool quoted, b
     }
 
     // Check for cached result.
+    s_recognizer.load_persistent();
     recognition cached = recognition::unrecognized;
     const int32 found = s_recognizer.find(word, cached, file);
     if (found)
@@ -847,7 +1139,7 @@ recognition recognize_command(const char* line, const char* word, bool quoted, b
     }
 
     // Queue for background thread processing.
-    if (!s_recognizer.enqueue(orig_word, word, cwd.c_str(), &cached))
+    if (!s_recognizer.enqueue(orig_word, word, cwd.c_str(), priority, &cached))
         return recognition::unknown;
 
     ready = false;
@@ -0,0 +1,302 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "recognizer_cache.h"
+
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str_hash.h>
+#include <core/str_unordered_set.h>
+
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+static const char c_header[] = "clink_recognizer_cache\t1\n";
+static const uint32 c_max_file_size = 4 * 1024 * 1024;
+
+//------------------------------------------------------------------------------
+static void* open_file(const char* path, bool if_exists)
+{
+    wstr<> wpath(path);
+
+    DWORD share_flags = FILE_SHARE_READ|FILE_SHARE_WRITE;
+    void* handle = CreateFileW(wpath.c_str(), GENERIC_READ|GENERIC_WRITE, share_flags,
+        nullptr, if_exists ? OPEN_EXISTING : OPEN_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    return (handle == INVALID_HANDLE_VALUE) ? nullptr : handle;
+}
+
+//------------------------------------------------------------------------------
+class file_lock
+{
+public:
+                    file_lock(void* handle, bool exclusive, bool wait=true);
+                    ~file_lock();
+    bool            is_locked() const { return m_locked; }
+private:
+    void*           m_handle;
+    bool            m_locked;
+};
+
+//------------------------------------------------------------------------------
+file_lock::file_lock(void* handle, bool exclusive, bool wait)
+: m_handle(handle)
+{
+    OVERLAPPED overlapped = {};
+    int32 flags = exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0;
+    if (!wait)
+        flags |= LOCKFILE_FAIL_IMMEDIATELY;
+    m_locked = !!LockFileEx(m_handle, flags, 0, ~0u, ~0u, &overlapped);
+}
+
+//------------------------------------------------------------------------------
+file_lock::~file_lock()
+{
+    if (!m_locked)
+        return;
+    OVERLAPPED overlapped = {};
+    UnlockFileEx(m_handle, 0, ~0u, ~0u, &overlapped);
+}
+
+//------------------------------------------------------------------------------
+static bool is_storable(const char* s)
+{
+    return !strpbrk(s, "\t\r\n");
+}
+
+//------------------------------------------------------------------------------
+static const char* next_field(const char*& p, const char* end)
+{
+    const char* field = p;
+    while (p < end && *p != '\t')
+        ++p;
+    if (p >= end)
+        return nullptr;
+    ++p;
+    return field;
+}
+
+//------------------------------------------------------------------------------
+static bool parse_line(const char* line, const char* end, recognizer_cache_entry& entry)
+{
+    const char* p = line;
+    const char* age = next_field(p, end);
+    const char* hash = next_field(p, end);
+    const char* cwd_class = next_field(p, end);
+    const char* recog = next_field(p, end);
+    const char* word = next_field(p, end);
+    if (!word || p - word <= 1)
+        return false;
+
+    entry.age = time_t(_strtoui64(age, nullptr, 16));
+    entry.path_hash = strtoul(hash, nullptr, 16);
+    entry.cwd_class = *cwd_class;
+    entry.recognition = int8(atoi(recog));
+    entry.word.clear();
+    entry.word.concat(word, int32(p - word - 1));
+    entry.file.clear();
+    entry.file.concat(p, int32(end - p));
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static void make_key(const recognizer_cache_entry& entry, str_base& out)
+{
+    out.format("%08x%c", entry.path_hash, entry.cwd_class ? entry.cwd_class : ' ');
+    out.concat(entry.word.c_str(), entry.word.length());
+}
+
+
+
+//------------------------------------------------------------------------------
+recognizer_cache::recognizer_cache(const char* path)
+: m_path(path)
+{
+}
+
+//------------------------------------------------------------------------------
+// Loads the entries that haven't expired.  This runs on the input thread, so
+// it doesn't wait for the lock; if another session is saving, the load is
+// skipped and the results are discovered again as usual.
+bool recognizer_cache::load(std::vector<recognizer_cache_entry>& out) const
+{
+    out.clear();
+
+    if (m_path.empty())
+        return false;
+
+    void* handle = open_file(m_path.c_str(), true/*if_exists*/);
+    if (!handle)
+        return false;
+
+    bool ok;
+    {
+        file_lock lock(handle, false, false/*wait*/);
+        ok = lock.is_locked() && read(handle, out);
+    }
+
+    CloseHandle(handle);
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+// Merges the entries into the file; for each key the newest entry wins, so
+// the file never has more than one entry per key.  Expired entries are
+// dropped, and if there are too many entries then the oldest are dropped.
+bool recognizer_cache::save(std::vector<recognizer_cache_entry>& entries) const
+{
+    if (m_path.empty())
+        return false;
+
+    void* handle = open_file(m_path.c_str(), false/*if_exists*/);
+    if (!handle)
+        return false;
+
+    bool ok = false;
+    {
+        file_lock lock(handle, true);
+
+        std::vector<recognizer_cache_entry> existing;
+        read(handle, existing);
+
+        // Index the entries by key, keeping the newest entry for each key
+        // (the file could already have duplicates, e.g. from an older
+        // version).  The keys are owned by the vector of strings, which is
+        // sized up front so they don't move.
+        std::vector<recognizer_cache_entry> merged;
+        std::vector<str_moveable> keys;
+        merged.reserve(existing.size() + entries.size());
+        keys.reserve(existing.size() + entries.size());
+        str_unordered_map<size_t> index;
+        str<> key;
+        auto merge = [&](recognizer_cache_entry& entry) {
+            make_key(entry, key);
+            auto const iter = index.find(key.c_str());
+            if (iter == index.end())
+            {
+                keys.emplace_back(key.c_str());
+                index.emplace(keys.back().c_str(), merged.size());
+                merged.emplace_back(std::move(entry));
+            }
+            else if (merged[iter->second].age <= entry.age)
+            {
+                merged[iter->second] = std::move(entry);
+            }
+        };
+
+        for (auto& entry : existing)
+            merge(entry);
+
+        for (auto& entry : entries)
+        {
+            if (is_storable(entry.word.c_str()) && is_storable(entry.file.c_str()))
+                merge(entry);
+        }
+
+        std::stable_sort(merged.begin(), merged.end(), [](const recognizer_cache_entry& a, const recognizer_cache_entry& b) {
+            return a.age > b.age;
+        });
+
+        const time_t expired = time(nullptr) - c_max_age;
+        while (!merged.empty() && (merged.size() > c_max_entries || merged.back().age < expired))
+            merged.pop_back();
+
+        str_moveable data;
+        data.concat(c_header);
+        str<> line;
+        for (const auto& entry : merged)
+        {
+            line.format("%llx\t%08x\t%c\t%d\t", (unsigned long long)entry.age, entry.path_hash,
+                        entry.cwd_class ? entry.cwd_class : ' ', int32(entry.recognition));
+            line.concat(entry.word.c_str(), entry.word.length());
+            line.concat("\t", 1);
+            line.concat(entry.file.c_str(), entry.file.length());
+            line.concat("\n", 1);
+            data.concat(line.c_str(), line.length());
+        }
+
+        DWORD written = 0;
+        SetFilePointer(handle, 0, nullptr, FILE_BEGIN);
+        ok = (WriteFile(handle, data.c_str(), data.length(), &written, nullptr) && written == data.length());
+        SetEndOfFile(handle);
+    }
+
+    CloseHandle(handle);
+    entries.clear();
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+bool recognizer_cache::read(void* handle, std::vector<recognizer_cache_entry>& out) const
+{
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || uint64(size.QuadPart) > c_max_file_size)
+        return false;
+
+    std::vector<char> data;
+    data.resize(size_t(size.QuadPart));
+
+    DWORD read = 0;
+    SetFilePointer(handle, 0, nullptr, FILE_BEGIN);
+    if (!data.empty() && (!ReadFile(handle, data.data(), DWORD(data.size()), &read, nullptr) || read != data.size()))
+        return false;
+
+    const uint32 header_len = sizeof(c_header) - 1;
+    if (data.size() < header_len || memcmp(data.data(), c_header, header_len) != 0)
+        return data.empty();
+
+    const time_t expired = time(nullptr) - c_max_age;
+    const char* p = data.data() + header_len;
+    const char* end = data.data() + data.size();
+    while (p < end)
+    {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!eol)
+            break;
+
+        recognizer_cache_entry entry;
+        if (parse_line(p, eol, entry) && entry.age >= expired)
+            out.emplace_back(std::move(entry));
+
+        p = eol + 1;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+uint32 recognizer_cache::get_path_hash()
+{
+    str<> tmp;
+    os::get_env("PATH", tmp);
+    uint32 hash = str_hash(tmp.c_str());
+    os::get_env("PATHEXT", tmp);
+    hash = (hash * 33) ^ str_hash(tmp.c_str());
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+char recognizer_cache::get_cwd_class(const char* cwd)
+{
+    if (!cwd)
+        return '?';
+
+    cwd += path::past_ssqs(cwd);
+    if (!cwd[0] || cwd[1] != ':')
+        return '?';
+
+    char drive[4];
+    drive[0] = cwd[0];
+    drive[1] = ':';
+    drive[2] = '\\';
+    drive[3] = '\0';
+    switch (os::get_drive_type(drive))
+    {
+    case os::drive_type_remote:     return 'r';
+    case os::drive_type_removable:  return 'm';
+    case os::drive_type_fixed:
+    case os::drive_type_ramdisk:    return 'f';
+    default:                        return '?';
+    }
+}
@@ -0,0 +1,43 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+struct recognizer_cache_entry
+{
+    str_moveable    word;
+    str_moveable    file;
+    time_t          age = 0;
+    uint32          path_hash = 0;      // Hash of %PATH% and %PATHEXT%.
+    char            cwd_class = 0;      // Drive type class of the cwd.
+    int8            recognition = 0;
+};
+
+//------------------------------------------------------------------------------
+// On-disk cache of recognizer results, shared by all sessions.  The file is
+// locked while it's read or written, the same way history_db locks its banks:
+// shared for reading, and exclusive for merging and rewriting.  Loading gives
+// up instead of waiting if the file is locked.
+class recognizer_cache
+{
+public:
+                    recognizer_cache(const char* path);
+    bool            load(std::vector<recognizer_cache_entry>& out) const;
+    bool            save(std::vector<recognizer_cache_entry>& entries) const;
+
+    static uint32   get_path_hash();
+    static char     get_cwd_class(const char* cwd);
+
+    static const time_t c_max_age = 60/*secinmin*/ * 60/*mininhour*/ * 24/*hoursinday*/ * 7/*days*/;
+    static const time_t c_refresh_age = 60/*secinmin*/ * 60/*mininhour*/ * 24/*hoursinday*/;
+    static const uint32 c_max_entries = 2000;
+
+private:
+    bool            read(void* handle, std::vector<recognizer_cache_entry>& out) const;
+    str_moveable    m_path;
+};
@@ -2734,6 +2734,8 @@ void terminal_file::write(const char* chars, int32 length)
 
 //------------------------------------------------------------------------------
 extern void task_manager_diagnostics();
+extern void bytecode_cache_diagnostics();
+extern void lua_startup_profile_diagnostics();
 static void do_clink_diagnostics(bool include_settings=false)
 {
     static char bold[] = "\x1b[1m";
@@ -2853,6 +2855,8 @@ static void do_clink_diagnostics(bool include_settings=false)
     host_call_lua_rl_global_function("clink._internal._diagnostics");
 
     task_manager_diagnostics();
+    bytecode_cache_diagnostics();
+    lua_startup_profile_diagnostics();
 
     // Check for known potential ambiguous character width issues.
 
@@ -18,6 +18,7 @@
 #include <core/auto_free_str.h>
 #include <core/os.h>
 #include <core/settings.h>
+#include <core/session_stats.h>
 #include <core/debugheap.h>
 
 #include <vector>
@@ -185,12 +186,70 @@ bool word_collector::is_alias_allowed(const char* buffer, uint32 offset) const
 //------------------------------------------------------------------------------
 uint32 word_collector::collect_words(const char* line_buffer, uint32 line_length, uint32 line_cursor,
                                      words& words, collect_words_mode mode,
-                                     commands* _commands) const
+                                     commands* commands) const
 {
-    words.clear();
+    // Generating matches, classifying, hinting, and suggesting each collect
+    // words for the same input line during a keystroke, so the most recent
+    // result for each mode is reused as long as the line, cursor, settings,
+    // aliases, and deprecated argmatchers are unchanged.  Aliases and
+    // argmatchers can change while idle, without a new keystroke.
+    cache_entry& cache = m_cache[uint32(mode)];
+    const uint32 generation = settings::get_generation();
+    const uint32 alias_generation = m_alias_cache ? m_alias_cache->get_generation() : 0;
+    const uint32 argmatcher_generation = m_command_tokeniser ? m_command_tokeniser->get_deprecated_argmatcher_generation() : 0;
+    session_stats* const stats = get_session_stats();
+
+    if (cache.valid &&
+        cache.cursor == line_cursor &&
+        cache.generation == generation &&
+        cache.alias_generation == alias_generation &&
+        cache.argmatcher_generation == argmatcher_generation &&
+        cache.buffer.length() == line_length &&
+        memcmp(cache.buffer.c_str(), line_buffer, line_length) == 0)
+    {
+        words = cache.collected;
+        if (commands)
+            *commands = cache.bounds;
+        if (stats)
+            ++stats->wordcollect_reused;
+        return cache.command_offset;
+    }
 
-    commands tmp;
-    commands& commands = _commands ? *_commands : tmp;
+    if (stats)
+        ++stats->wordcollect_tokenised;
+
+    cache.valid = false;
+    cache.command_offset = tokenise(line_buffer, line_length, line_cursor, cache.collected, mode, cache.bounds);
+    cache.buffer.clear();
+    cache.buffer.concat(line_buffer, line_length);
+    cache.cursor = line_cursor;
+    cache.generation = generation;
+    // Tokenising may have validated the alias snapshot.
+    cache.alias_generation = m_alias_cache ? m_alias_cache->get_generation() : 0;
+    cache.argmatcher_generation = argmatcher_generation;
+    cache.valid = true;
+
+    words = cache.collected;
+    if (commands)
+        *commands = cache.bounds;
+    return cache.command_offset;
+}
+
+//------------------------------------------------------------------------------
+void word_collector::clear_cache()
+{
+    for (auto& cache : m_cache)
+        cache.valid = false;
+    if (m_alias_cache)
+        m_alias_cache->clear();
+}
+
+//------------------------------------------------------------------------------
+uint32 word_collector::tokenise(const char* line_buffer, uint32 line_length, uint32 line_cursor,
+                                words& words, collect_words_mode mode,
+                                commands& commands) const
+{
+    words.clear();
 
     commands.reserve(5);
     const bool stop_at_cursor = (mode == collect_words_mode::stop_at_cursor);
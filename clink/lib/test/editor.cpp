@@ -10,6 +10,7 @@
 #include "word_collector.h"
 
 #include <core/array.h>
+#include <core/session_stats.h>
 
 //------------------------------------------------------------------------------
 struct delim_module
@@ -89,3 +90,26 @@ TEST_CASE("editor")
         REQUIRE(module.delim == '=');
     }
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("editor latency")
+{
+    session_stats* stats = get_session_stats();
+    REQUIRE(stats);
+
+    const uint32 input = stats->latency[uint32(latency_stage::input)].total;
+    const uint32 dispatch = stats->latency[uint32(latency_stage::dispatch)].total;
+    const uint32 update = stats->latency[uint32(latency_stage::update_internal)].total;
+
+    line_editor_tester tester;
+    tester.set_input("abc");
+    tester.run(true);
+
+    // Keys are measured from when the terminal returned them until the line
+    // editor finished updating.
+    REQUIRE(stats->latency[uint32(latency_stage::input)].total > input);
+    REQUIRE(stats->latency[uint32(latency_stage::input)].total - input <= 3);
+    REQUIRE(stats->latency[uint32(latency_stage::dispatch)].total - dispatch >= 3);
+    REQUIRE(stats->latency[uint32(latency_stage::update_internal)].total > update);
+    REQUIRE(get_latency_max(stats->latency[uint32(latency_stage::input)]) > 0);
+}
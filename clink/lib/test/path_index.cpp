@@ -0,0 +1,140 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "env_fixture.h"
+#include "fs_fixture.h"
+
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+
+#include "path_index.h"
+
+//------------------------------------------------------------------------------
+static bool lookup_file(const path_index& index, const char* word, const char* root, const char* expected)
+{
+    str<> out;
+    if (index.lookup(word, out) <= 0)
+        return false;
+
+    str<> full;
+    path::join(root, expected, full);
+    return full.iequals(out.c_str());
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Path index")
+{
+    static const char* path_fs[] = {
+        "bin1/foo.exe",
+        "bin1/bar.cmd",
+        "bin1/notes.txt",
+        "bin2/foo.bat",
+        "bin2/baz.exe",
+        "bin2/qux.exe.bat",
+        "bin2/qux.exe",
+        "bin2/sub.exe/x",
+        nullptr,
+    };
+
+    fs_fixture fs(path_fs);
+    const char* root = fs.get_root();
+
+    str<> bin1;
+    str<> bin2;
+    path::join(root, "bin1", bin1);
+    path::join(root, "bin2", bin2);
+
+    str<> path;
+    path.format("%s;%s", bin1.c_str(), bin2.c_str());
+
+    const char* env_desc[] = {
+        "PATH",     path.c_str(),
+        "PATHEXT",  ".COM;.EXE;.BAT;.CMD",
+        nullptr
+    };
+
+    env_fixture env(env_desc);
+
+    path_index index;
+    str<> out;
+
+    SECTION("Not built")
+    {
+        REQUIRE(index.lookup("foo", out) < 0);
+    }
+
+    SECTION("Lookup")
+    {
+        REQUIRE(index.refresh());
+        REQUIRE(index.get_dir_count() == 2);
+
+        REQUIRE(lookup_file(index, "foo", root, "bin1\\foo.EXE"));
+        REQUIRE(lookup_file(index, "FOO", root, "bin1\\FOO.EXE"));
+        REQUIRE(lookup_file(index, "bar", root, "bin1\\bar.CMD"));
+        REQUIRE(lookup_file(index, "baz", root, "bin2\\baz.EXE"));
+        REQUIRE(lookup_file(index, "foo.bat", root, "bin2\\foo.bat"));
+        REQUIRE(lookup_file(index, "qux.exe", root, "bin2\\qux.exe"));
+
+        REQUIRE(index.lookup("notes", out) == 0);
+        REQUIRE(index.lookup("sub", out) == 0);
+        REQUIRE(index.lookup("nope", out) == 0);
+
+        // Not answerable from the index.
+        REQUIRE(index.lookup("notes.txt", out) < 0);
+        REQUIRE(index.lookup("bin1\\foo", out) < 0);
+
+        // Nothing changed.
+        REQUIRE(!index.refresh());
+    }
+
+    SECTION("PATH changed")
+    {
+        REQUIRE(index.refresh());
+        REQUIRE(lookup_file(index, "foo", root, "bin1\\foo.EXE"));
+
+        path.format("%s;%s", bin2.c_str(), bin1.c_str());
+        REQUIRE(os::set_env("PATH", path.c_str()));
+        REQUIRE(index.refresh());
+        REQUIRE(lookup_file(index, "foo", root, "bin2\\foo.BAT"));
+        REQUIRE(lookup_file(index, "bar", root, "bin1\\bar.CMD"));
+
+        path.format("%s;bin1", bin2.c_str());
+        REQUIRE(os::set_env("PATH", path.c_str()));
+        REQUIRE(index.refresh());
+        REQUIRE(index.lookup("bar", out) < 0);
+    }
+
+    SECTION("PATHEXT changed")
+    {
+        REQUIRE(index.refresh());
+        REQUIRE(lookup_file(index, "foo", root, "bin1\\foo.EXE"));
+
+        REQUIRE(os::set_env("PATHEXT", ".BAT;.CMD"));
+        REQUIRE(index.refresh());
+        REQUIRE(lookup_file(index, "foo", root, "bin2\\foo.BAT"));
+        REQUIRE(index.lookup("baz", out) == 0);
+    }
+
+    SECTION("Directory changed")
+    {
+        REQUIRE(index.refresh());
+        REQUIRE(lookup_file(index, "baz", root, "bin2\\baz.EXE"));
+
+        str<> file;
+        path::join(bin1.c_str(), "baz.com", file);
+        FILE* f = fopen(file.c_str(), "wt");
+        REQUIRE(f);
+        fclose(f);
+
+        REQUIRE(index.refresh());
+        REQUIRE(lookup_file(index, "baz", root, "bin1\\baz.COM"));
+
+        REQUIRE(os::unlink(file.c_str()));
+        REQUIRE(index.refresh());
+        REQUIRE(lookup_file(index, "baz", root, "bin2\\baz.EXE"));
+    }
+}
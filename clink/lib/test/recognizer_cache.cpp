@@ -0,0 +1,163 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "fs_fixture.h"
+
+#include <core/path.h>
+#include <core/str.h>
+
+#include "recognizer_cache.h"
+
+//------------------------------------------------------------------------------
+static void add_entry(std::vector<recognizer_cache_entry>& entries, const char* word, const char* file, time_t age, int8 recognition=1)
+{
+    recognizer_cache_entry entry;
+    entry.word = word;
+    entry.file = file;
+    entry.age = age;
+    entry.path_hash = 0x1234abcd;
+    entry.cwd_class = 'f';
+    entry.recognition = recognition;
+    entries.emplace_back(std::move(entry));
+}
+
+//------------------------------------------------------------------------------
+static const recognizer_cache_entry* find_entry(const std::vector<recognizer_cache_entry>& entries, const char* word)
+{
+    for (const auto& entry : entries)
+    {
+        if (entry.word.equals(word))
+            return &entry;
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Recognizer cache")
+{
+    static const char* empty_fs[] = { nullptr };
+    fs_fixture fs(empty_fs);
+
+    str<> file;
+    path::join(fs.get_root(), "clink_recognizer_cache", file);
+
+    recognizer_cache cache(file.c_str());
+    std::vector<recognizer_cache_entry> entries;
+    const time_t now = time(nullptr);
+
+    SECTION("Missing file")
+    {
+        REQUIRE(!cache.load(entries));
+        REQUIRE(entries.empty());
+    }
+
+    SECTION("Round trip")
+    {
+        add_entry(entries, "git", "c:\\tools\\git.EXE", now);
+        add_entry(entries, "nope", "", now, -1);
+        REQUIRE(cache.save(entries));
+        REQUIRE(entries.empty());
+
+        REQUIRE(cache.load(entries));
+        REQUIRE(entries.size() == 2);
+
+        const auto* git = find_entry(entries, "git");
+        REQUIRE(git);
+        REQUIRE(git->file.equals("c:\\tools\\git.EXE"));
+        REQUIRE(git->age == now);
+        REQUIRE(git->path_hash == 0x1234abcd);
+        REQUIRE(git->cwd_class == 'f');
+        REQUIRE(git->recognition == 1);
+
+        const auto* nope = find_entry(entries, "nope");
+        REQUIRE(nope);
+        REQUIRE(nope->file.empty());
+        REQUIRE(nope->recognition == -1);
+    }
+
+    SECTION("Newest wins")
+    {
+        add_entry(entries, "npm", "c:\\old\\npm.CMD", now - 10);
+        REQUIRE(cache.save(entries));
+
+        // Another session saves a newer result, then a stale one.
+        add_entry(entries, "npm", "c:\\new\\npm.CMD", now);
+        REQUIRE(cache.save(entries));
+        add_entry(entries, "npm", "c:\\older\\npm.CMD", now - 20);
+        REQUIRE(cache.save(entries));
+
+        REQUIRE(cache.load(entries));
+        REQUIRE(entries.size() == 1);
+        REQUIRE(entries[0].file.equals("c:\\new\\npm.CMD"));
+    }
+
+    SECTION("Duplicate keys")
+    {
+        // A file with more than one entry for a key is deduped on save.
+        str<> line;
+        FILE* f = fopen(file.c_str(), "wb");
+        REQUIRE(f);
+        fputs("clink_recognizer_cache\t1\n", f);
+        line.format("%llx\t1234abcd\tf\t1\tnode\tc:\\old\\node.EXE\n", (unsigned long long)(now - 10));
+        fputs(line.c_str(), f);
+        line.format("%llx\t1234abcd\tf\t1\tnode\tc:\\new\\node.EXE\n", (unsigned long long)now);
+        fputs(line.c_str(), f);
+        fclose(f);
+
+        add_entry(entries, "other", "c:\\other.EXE", now);
+        REQUIRE(cache.save(entries));
+
+        REQUIRE(cache.load(entries));
+        REQUIRE(entries.size() == 2);
+        const auto* node = find_entry(entries, "node");
+        REQUIRE(node);
+        REQUIRE(node->file.equals("c:\\new\\node.EXE"));
+    }
+
+    SECTION("Contended")
+    {
+        add_entry(entries, "git", "c:\\tools\\git.EXE", now);
+        REQUIRE(cache.save(entries));
+
+        // Loading doesn't wait while another session holds the lock.
+        wstr<> wfile(file.c_str());
+        HANDLE h = CreateFileW(wfile.c_str(), GENERIC_READ|GENERIC_WRITE, FILE_SHARE_READ|FILE_SHARE_WRITE,
+                               nullptr, OPEN_EXISTING, 0, nullptr);
+        REQUIRE(h != INVALID_HANDLE_VALUE);
+        OVERLAPPED overlapped = {};
+        REQUIRE(LockFileEx(h, LOCKFILE_EXCLUSIVE_LOCK, 0, ~0u, ~0u, &overlapped));
+
+        REQUIRE(!cache.load(entries));
+        REQUIRE(entries.empty());
+
+        overlapped = {};
+        UnlockFileEx(h, 0, ~0u, ~0u, &overlapped);
+        CloseHandle(h);
+
+        REQUIRE(cache.load(entries));
+        REQUIRE(entries.size() == 1);
+    }
+
+    SECTION("Expired")
+    {
+        add_entry(entries, "old", "c:\\old.EXE", now - recognizer_cache::c_max_age - 60);
+        add_entry(entries, "new", "c:\\new.EXE", now);
+        REQUIRE(cache.save(entries));
+
+        REQUIRE(cache.load(entries));
+        REQUIRE(entries.size() == 1);
+        REQUIRE(find_entry(entries, "new"));
+    }
+
+    SECTION("Not storable")
+    {
+        add_entry(entries, "tab\tword", "c:\\x.EXE", now);
+        REQUIRE(cache.save(entries));
+
+        REQUIRE(cache.load(entries));
+        REQUIRE(entries.empty());
+    }
+}
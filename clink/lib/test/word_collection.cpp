@@ -11,7 +11,9 @@
 #include <core/str.h>
 #include <core/str_compare.h>
 #include <core/settings.h>
+#include <core/session_stats.h>
 #include <lib/cmd_tokenisers.h>
+#include <lib/line_editor_integration.h>
 #include <lua/lua_match_generator.h>
 #include <lua/lua_script_loader.h>
 #include <lua/lua_state.h>
@@ -71,4 +73,70 @@ TEST_CASE("Word collection")
     tester.set_input("abc \"hi^\" x calc\" ");
     tester.set_expected_words("abc", "hi^", "x", "");
     tester.run();
+
+    // Long runs of text and quoted text are consumed in bulk.
+    tester.set_input("abcdefghijkl \"quoted words here\" mnopqrstuvw 123456 ");
+    tester.set_expected_words("abcdefghijkl", "quoted words here", "mnopqrstuvw", "123456", "");
+    tester.run();
+
+    tester.set_input("abcdefghijkl & \"quoted & stuff\" x ");
+    tester.set_expected_words("quoted & stuff", "x", "");
+    tester.run();
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Word collection cache")
+{
+    cmd_command_tokeniser command_tokeniser;
+    cmd_word_tokeniser word_tokeniser;
+    word_collector collector(&command_tokeniser, &word_tokeniser);
+
+    session_stats* stats = get_session_stats();
+    REQUIRE(stats);
+    const uint32 tokenised = stats->wordcollect_tokenised;
+    const uint32 reused = stats->wordcollect_reused;
+
+    const char* line = "abc def & ghi \"jkl mno\"";
+    const uint32 len = uint32(strlen(line));
+
+    // Collecting the same line again reuses the words.
+    words words1;
+    words words2;
+    commands commands1;
+    commands commands2;
+    const uint32 offset1 = collector.collect_words(line, len, len, words1, collect_words_mode::stop_at_cursor, &commands1);
+    const uint32 offset2 = collector.collect_words(line, len, len, words2, collect_words_mode::stop_at_cursor, &commands2);
+    REQUIRE(stats->wordcollect_tokenised - tokenised == 1);
+    REQUIRE(stats->wordcollect_reused - reused == 1);
+    REQUIRE(offset1 == offset2);
+    REQUIRE(commands1.size() == commands2.size());
+    REQUIRE(words1.size() == words2.size());
+    for (size_t i = 0; i < words1.size(); ++i)
+    {
+        REQUIRE(words1[i].offset == words2[i].offset);
+        REQUIRE(words1[i].length == words2[i].length);
+        REQUIRE(words1[i].quoted == words2[i].quoted);
+    }
+
+    // A different mode, cursor, or line collects the words again.
+    collector.collect_words(line, len, len, words2, collect_words_mode::whole_command, nullptr);
+    REQUIRE(stats->wordcollect_tokenised - tokenised == 2);
+    collector.collect_words(line, len, 3, words2, collect_words_mode::stop_at_cursor, nullptr);
+    REQUIRE(stats->wordcollect_tokenised - tokenised == 3);
+    collector.collect_words(line, len - 1, len - 1, words2, collect_words_mode::stop_at_cursor, nullptr);
+    REQUIRE(stats->wordcollect_tokenised - tokenised == 4);
+
+    // So does clearing the cache.
+    collector.collect_words(line, len - 1, len - 1, words2, collect_words_mode::stop_at_cursor, nullptr);
+    REQUIRE(stats->wordcollect_tokenised - tokenised == 4);
+    collector.clear_cache();
+    collector.collect_words(line, len - 1, len - 1, words2, collect_words_mode::stop_at_cursor, nullptr);
+    REQUIRE(stats->wordcollect_tokenised - tokenised == 5);
+    REQUIRE(stats->wordcollect_reused - reused == 2);
+
+    // So does marking an argmatcher deprecated, which can happen while idle.
+    mark_deprecated_argmatcher("word_collection_cache");
+    collector.collect_words(line, len - 1, len - 1, words2, collect_words_mode::stop_at_cursor, nullptr);
+    REQUIRE(stats->wordcollect_tokenised - tokenised == 6);
+    clear_deprecated_argmatchers();
 }
@@ -0,0 +1,193 @@
+-- Copyright (c) 2026 Christopher Antos
+-- License: http://opensource.org/licenses/MIT
+
+--------------------------------------------------------------------------------
+-- Measures how long it takes to parse "git status --branch --porcelain=v2"
+-- output line by line in Lua (how git.getstatus() used to work) versus with
+-- the native streaming parser.  It needs Clink's internal functions, so run it
+-- with Clink's Lua interpreter:
+--
+--      clink lua clink\lua\bench\git_status.lua [options]
+--
+-- Options:
+--      --lines=N           Number of status lines to generate (default 100000).
+--      --iterations=N      Number of timed iterations (default 10).
+--      --keep              Don't delete the generated status file.
+--
+-- The synthetic status file is a mix of modified, staged, renamed, conflicted,
+-- and untracked entries.  Timings are the median of the iterations, so
+-- repeated runs are reproducible.
+
+local internal = import_internal -- luacheck: no global
+
+local num_lines = 100000
+local iterations = 10
+local keep
+
+for _, a in ipairs(arg or {}) do
+    local l = a:match("^%-%-lines=(%d+)$")
+    local n = a:match("^%-%-iterations=(%d+)$")
+    if l then
+        num_lines = math.max(1, tonumber(l))
+    elseif n then
+        iterations = math.max(1, tonumber(n))
+    elseif a == "--keep" then
+        keep = true
+    else
+        print("usage: clink lua git_status.lua [--lines=N] [--iterations=N] [--keep]")
+        os.exit(1)
+    end
+end
+
+--------------------------------------------------------------------------------
+local function generate(name)
+    local kinds = {
+        "1 .M N... 100644 100644 100644 %s %s src/dir%d/modified%d.cpp",
+        "1 M. N... 100644 100644 100644 %s %s src/dir%d/staged%d.cpp",
+        "1 A. N... 000000 100644 100644 %s %s src/dir%d/added%d.cpp",
+        "1 .D N... 100644 100644 000000 %s %s src/dir%d/deleted%d.cpp",
+        "2 R. N... 100644 100644 100644 %s %s R100 src/dir%d/new%d.cpp\told.cpp",
+        "u UU N... 100644 100644 100644 100644 %s %s 0000 src/dir%d/conflict%d.cpp",
+        "? src/dir%d/untracked%d.txt",
+        "? src/dir%d/untracked%d.obj",
+    }
+    local oid = string.rep("a", 40)
+
+    local f = io.open(name, "wb")
+    f:write("# branch.oid "..oid.."\n")
+    f:write("# branch.head main\n")
+    f:write("# branch.upstream origin/main\n")
+    f:write("# branch.ab +1 -2\n")
+    for i = 1, num_lines do
+        local kind = kinds[(i % #kinds) + 1]
+        if kind:find("^%?") then
+            f:write(string.format(kind, i % 100, i), "\n")
+        else
+            f:write(string.format(kind, oid, oid, i % 100, i), "\n")
+        end
+    end
+    f:close()
+end
+
+--------------------------------------------------------------------------------
+-- The per-line parsing loop from git.getstatus() before the native parser.
+local function parse_lua(name)
+    local file = io.open(name, "rb")
+    local w_add, w_mod, w_del, w_con, w_unt = 0, 0, 0, 0, 0
+    local s_add, s_mod, s_del, s_ren = 0, 0, 0, 0
+    local t_add, t_mod, t_del = 0, 0, 0
+    local onlystaged = 0
+    local header = {}
+    for line in file:lines() do
+        if line:find("^# ") then
+            local k, v = line:match("^#%sbranch%.([^%s]+)%s(.*)$")
+            if k then
+                header[k] = v
+            end
+        else
+            local mode = string.match(line, "^([uU12?]) ")
+            if mode == "?" then
+                w_unt = w_unt + 1
+            elseif mode == "u" or mode == "U" then
+                w_con = w_con + 1
+            elseif mode == "1" or mode == "2" then
+                local kindStaged, kind = string.match(line, "^(.)(.) ", 3)
+                local added, modified, deleted
+                local w = true
+                if kind == "A" or kind == "C" then
+                    w_add = w_add + 1
+                    added = true
+                elseif kind == "M" or kind == "T" or kind == "R" then
+                    w_mod = w_mod + 1
+                    modified = true
+                elseif kind == "D" then
+                    w_del = w_del + 1
+                    deleted = true
+                else
+                    w = false
+                end
+                if kindStaged == "A" or kindStaged == "C" then
+                    s_add = s_add + 1
+                    if not w then added = true end
+                elseif kindStaged == "M" or kindStaged == "T" then
+                    s_mod = s_mod + 1
+                    if not w then modified = true end
+                elseif kindStaged == "D" then
+                    s_del = s_del + 1
+                    if not w then deleted = true end
+                elseif kindStaged == "R" then
+                    s_ren = s_ren + 1
+                    if not w then modified = true end
+                end
+                if added then
+                    t_add = t_add + 1
+                elseif deleted then
+                    t_del = t_del + 1
+                elseif modified then
+                    t_mod = t_mod + 1
+                end
+                if kindStaged ~= "." and kind == "." then
+                    onlystaged = onlystaged + 1
+                end
+            end
+        end
+    end
+    file:close()
+    return {
+        w_add=w_add, w_modify=w_mod, w_delete=w_del, w_conflict=w_con, w_untracked=w_unt,
+        s_add=s_add, s_modify=s_mod, s_delete=s_del, s_rename=s_ren,
+        t_add=t_add, t_modify=t_mod, t_delete=t_del, onlystaged=onlystaged,
+        head=header.head,
+    }
+end
+
+--------------------------------------------------------------------------------
+local function parse_native(name)
+    local file = io.open(name, "rb")
+    local parser = internal._make_git_status_parser()
+    parser:read(file)
+    file:close()
+    return parser:getcounts()
+end
+
+--------------------------------------------------------------------------------
+local function measure(func, name)
+    local times = {}
+    local result
+    for i = 1, iterations do
+        local clock = os.clock()
+        result = func(name)
+        times[i] = os.clock() - clock
+    end
+    table.sort(times)
+    return times[math.floor((#times + 1) / 2)], result
+end
+
+--------------------------------------------------------------------------------
+local name = path.join(os.gettemppath(), "clink_bench_git_status.txt")
+generate(name)
+
+local lua_time, lua_result = measure(parse_lua, name)
+local native_time, native_result = measure(parse_native, name)
+
+local fields = {
+    "w_add", "w_modify", "w_delete", "w_conflict", "w_untracked",
+    "s_add", "s_modify", "s_delete", "s_rename",
+    "t_add", "t_modify", "t_delete", "onlystaged", "head",
+}
+for _, f in ipairs(fields) do
+    if lua_result[f] ~= native_result[f] then
+        print(string.format("mismatch in %s:  lua %s, native %s", f, tostring(lua_result[f]), tostring(native_result[f])))
+        os.exit(1)
+    end
+end
+
+print(string.format("lines       %d", num_lines))
+print(string.format("iterations  %d", iterations))
+print(string.format("lua         %8.2f ms  (%8.0f lines/sec)", lua_time * 1000, num_lines / math.max(lua_time, 1e-6)))
+print(string.format("native      %8.2f ms  (%8.0f lines/sec)", native_time * 1000, num_lines / math.max(native_time, 1e-6)))
+print(string.format("speedup     %8.1fx", lua_time / math.max(native_time, 1e-6)))
+
+if not keep then
+    os.remove(name)
+end
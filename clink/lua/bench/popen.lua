@@ -0,0 +1,134 @@
+-- Copyright (c) 2026 Christopher Antos
+-- License: http://opensource.org/licenses/MIT
+
+--------------------------------------------------------------------------------
+-- Measures how fast a large amount of command output can be read, using
+-- io.popen() with file:lines() versus io.linereader(), and how long
+-- io.popenyield_internal() takes to collect the same output in the background.
+-- Run it with Clink's Lua interpreter:
+--
+--      clink lua clink\lua\bench\popen.lua [options]
+--
+-- Options:
+--      --mb=N              Megabytes of output to generate (default 20).
+--      --iterations=N      Number of timed iterations (default 5).
+--      --keep              Don't delete the generated payload file.
+--
+-- The child process is "type" on a generated file, so the payload is the same
+-- every run.  Timings are the median of the iterations, so repeated runs are
+-- reproducible.
+
+local megabytes = 20
+local iterations = 5
+local keep
+
+for _, a in ipairs(arg or {}) do
+    local m = a:match("^%-%-mb=(%d+)$")
+    local n = a:match("^%-%-iterations=(%d+)$")
+    if m then
+        megabytes = math.max(1, tonumber(m))
+    elseif n then
+        iterations = math.max(1, tonumber(n))
+    elseif a == "--keep" then
+        keep = true
+    else
+        print("usage: clink lua popen.lua [--mb=N] [--iterations=N] [--keep]")
+        os.exit(1)
+    end
+end
+
+--------------------------------------------------------------------------------
+local function generate(name)
+    -- Lines of varying length, similar to "dir /s /b" output.
+    local lines = {}
+    for i = 1, 64 do
+        lines[i] = "c:\\src\\project\\"..string.rep("sub\\", i % 8).."file"..i..string.rep("x", i).."\n"
+    end
+    local block = table.concat(lines)
+
+    local f = io.open(name, "wb")
+    local total = 0
+    local count = 0
+    while total < megabytes * 1024 * 1024 do
+        f:write(block)
+        total = total + #block
+        count = count + #lines
+    end
+    f:close()
+    return total, count
+end
+
+--------------------------------------------------------------------------------
+local function read_lines(command)
+    local file = io.popen(command, "rb")
+    local n = 0
+    for _ in file:lines() do
+        n = n + 1
+    end
+    file:close()
+    return n
+end
+
+--------------------------------------------------------------------------------
+local function read_linereader(command)
+    local file = io.popen(command, "rb")
+    local n = 0
+    for _ in io.linereader(file):lines() do
+        n = n + 1
+    end
+    file:close()
+    return n
+end
+
+--------------------------------------------------------------------------------
+local function read_popenyield(command)
+    local file, yieldguard = io.popenyield_internal(command, "rb")
+    while not yieldguard:ready() do
+        yieldguard:wait(0.05)
+    end
+    local n = 0
+    for _ in io.linereader(file):lines() do
+        n = n + 1
+    end
+    file:close()
+    return n
+end
+
+--------------------------------------------------------------------------------
+local function measure(func, command)
+    local times = {}
+    local result
+    for i = 1, iterations do
+        local clock = os.clock()
+        result = func(command)
+        times[i] = os.clock() - clock
+    end
+    table.sort(times)
+    return times[math.floor((#times + 1) / 2)], result
+end
+
+--------------------------------------------------------------------------------
+local name = path.join(os.gettemppath(), "clink_bench_popen.txt")
+local bytes, count = generate(name)
+local command = "2>nul type \""..name.."\""
+
+print(string.format("payload     %d bytes, %d lines", bytes, count))
+print(string.format("iterations  %d", iterations))
+
+local mb = bytes / (1024 * 1024)
+for _, b in ipairs({
+    { "lines", read_lines },
+    { "linereader", read_linereader },
+    { "popenyield", read_popenyield },
+}) do
+    local t, n = measure(b[2], command)
+    if n ~= count then
+        print(string.format("%s read %d lines; expected %d", b[1], n, count))
+        os.exit(1)
+    end
+    print(string.format("%-11s %8.2f ms  (%7.1f MB/sec)", b[1], t * 1000, mb / math.max(t, 1e-6)))
+end
+
+if not keep then
+    os.remove(name)
+end
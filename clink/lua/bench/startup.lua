@@ -0,0 +1,152 @@
+-- Copyright (c) 2026 Christopher Antos
+-- License: http://opensource.org/licenses/MIT
+
+--------------------------------------------------------------------------------
+-- Measures how long it takes to compile Lua scripts from source versus loading
+-- precompiled bytecode, which is the cost the lua.bytecode_cache setting saves
+-- during startup.  Run it with the standalone lua52 target:
+--
+--      lua52 clink\lua\bench\startup.lua [options] <file_or_dir> ...
+--
+-- Options:
+--      --iterations=N      Number of timed iterations per file (default 20).
+--      --luac=PATH         Compile with the luac target instead of string.dump.
+--      --verbose           Show timings per file.
+--
+-- Directories are searched recursively for *.lua files.  Timings are the
+-- median of the iterations, so repeated runs are reproducible.
+
+local iterations = 20
+local luac
+local verbose
+local inputs = {}
+
+for _, a in ipairs(arg) do
+    local n = a:match("^%-%-iterations=(%d+)$")
+    local l = a:match("^%-%-luac=(.+)$")
+    if n then
+        iterations = math.max(1, tonumber(n))
+    elseif l then
+        luac = l
+    elseif a == "--verbose" then
+        verbose = true
+    else
+        table.insert(inputs, a)
+    end
+end
+
+if #inputs == 0 then
+    print("usage: lua52 startup.lua [--iterations=N] [--luac=PATH] [--verbose] <file_or_dir> ...")
+    os.exit(1)
+end
+
+--------------------------------------------------------------------------------
+local function collect_files(input, out)
+    local f = io.open(input, "rb")
+    if f and f:read(0) then
+        f:close()
+        table.insert(out, input)
+        return
+    end
+    if f then
+        f:close()
+    end
+    local sep = package.config:sub(1, 1)
+    local cmd
+    if sep == "\\" then
+        cmd = 'dir /b /s /a-d "'..input..'\\*.lua" 2>nul'
+    else
+        cmd = 'find "'..input..'" -type f -name "*.lua" 2>/dev/null'
+    end
+    local p = io.popen(cmd)
+    if p then
+        local found = {}
+        for line in p:lines() do
+            table.insert(found, line)
+        end
+        p:close()
+        table.sort(found)
+        for _, file in ipairs(found) do
+            table.insert(out, file)
+        end
+    end
+end
+
+--------------------------------------------------------------------------------
+local function read_file(name)
+    local f = io.open(name, "rb")
+    if not f then
+        return
+    end
+    local s = f:read("*a")
+    f:close()
+    return s
+end
+
+--------------------------------------------------------------------------------
+local function compile(file, source)
+    if not luac then
+        local func = load(source, "@"..file, "t")
+        return func and string.dump(func)
+    end
+
+    local tmp = os.tmpname()
+    local ok = os.execute('"'..luac..'" -o "'..tmp..'" "'..file..'"')
+    local bytecode = ok and read_file(tmp)
+    os.remove(tmp)
+    return bytecode
+end
+
+--------------------------------------------------------------------------------
+local function median_time(func)
+    local samples = {}
+    for i = 1, iterations do
+        local start = os.clock()
+        func()
+        samples[i] = os.clock() - start
+    end
+    table.sort(samples)
+    return samples[math.floor((#samples + 1) / 2)]
+end
+
+--------------------------------------------------------------------------------
+local files = {}
+for _, input in ipairs(inputs) do
+    collect_files(input, files)
+end
+
+local total_source = 0
+local total_bytecode = 0
+local total_bytes = 0
+local count = 0
+
+for _, file in ipairs(files) do
+    local source = read_file(file)
+    local bytecode = source and compile(file, source)
+    if not bytecode then
+        io.stderr:write("skipping '"..file.."'; unable to compile.\n")
+    else
+        local chunkname = "@"..file
+        local t_source = median_time(function () assert(load(source, chunkname, "t")) end)
+        local t_bytecode = median_time(function () assert(load(bytecode, chunkname, "b")) end)
+        total_source = total_source + t_source
+        total_bytecode = total_bytecode + t_bytecode
+        total_bytes = total_bytes + #source
+        count = count + 1
+        if verbose then
+            print(string.format("%9.3f ms %9.3f ms  %s", t_source * 1000, t_bytecode * 1000, file))
+        end
+    end
+end
+
+if verbose and count > 0 then
+    print("")
+end
+
+print(string.format("scripts:          %d (%d bytes)", count, total_bytes))
+print(string.format("iterations:       %d", iterations))
+print(string.format("compile source:   %.3f ms", total_source * 1000))
+print(string.format("load bytecode:    %.3f ms", total_bytecode * 1000))
+if total_bytecode > 0 then
+    print(string.format("speedup:          %.1fx", total_source / total_bytecode))
+end
@@ -0,0 +1,25 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/os.h>
+
+//------------------------------------------------------------------------------
+// Records how long each step of Lua initialization takes:  each API namespace
+// initializer, each embedded script, and each user script.
+void clear_lua_startup_profile();
+void add_lua_startup_timing(const char* name, double elapsed);
+double get_lua_startup_total();
+void log_lua_startup_profile();
+
+//------------------------------------------------------------------------------
+class lua_startup_timer
+{
+public:
+                    lua_startup_timer(const char* name) : m_name(name) {}
+                    ~lua_startup_timer() { add_lua_startup_timing(m_name, m_clock.elapsed()); }
+private:
+    const char*     m_name;
+    os::high_resolution_clock m_clock;
+};
@@ -74,6 +74,7 @@ public:
     lua_State*      get_state() const;
 
     static bool     push_named_function(lua_State* L, const char* func_name, str_base* error=nullptr);
+    static void     register_lazy_module(lua_State* L, const char* name, int32 (*open)(lua_State*));
 
     static int32    pcall(lua_State* L, int32 nargs, int32 nresults, str_base* error=nullptr);
     static int32    pcall_silent(lua_State* L, int32 nargs, int32 nresults);
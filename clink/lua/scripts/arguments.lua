@@ -36,6 +36,12 @@ local _clear_delayinit_coroutine = {}
 local _argmatcher_loaders = {}
 local _argmatcher_loaders_unsorted = false
 
+--------------------------------------------------------------------------------
+settings.add("argmatcher.preload", true, "Preload argmatchers for recent commands",
+[[When enabled, completion scripts for commands used recently in history are
+loaded while waiting for input, so the first completion for a command doesn't
+need to wait for its completion script to load.]])
+
 --------------------------------------------------------------------------------
 settings.add("match.file_sizes", false, "Show file size in match description",
 [[Show file size in match description for file matches.]])
@@ -273,7 +279,7 @@ local function get_word_arginfo(word, arg, matcher)
 end
 
 --------------------------------------------------------------------------------
-local function get_classify_color(code)
+local function lookup_classify_color(code)
     if code:find("^m") then
         return settings.get("color.argmatcher")
     end
@@ -303,6 +309,27 @@ local function get_classify_color(code)
     return ""
 end
 
+--------------------------------------------------------------------------------
+-- Classification looks up colors for every word on every keystroke, so the
+-- colors are cached until any setting changes.
+local _classify_colors = {}
+local _classify_colors_generation
+
+local function get_classify_color(code)
+    local generation = settings.getgeneration()
+    if _classify_colors_generation ~= generation then
+        _classify_colors = {}
+        _classify_colors_generation = generation
+    end
+
+    local color = _classify_colors[code]
+    if not color then
+        color = lookup_classify_color(code)
+        _classify_colors[code] = color
+    end
+    return color
+end
+
 --------------------------------------------------------------------------------
 local function parse_chaincommand_modes(modes)
     local mode = "cmd"
@@ -2471,6 +2498,53 @@ function clink.argmatcher(...)
     return matcher
 end
 
+--------------------------------------------------------------------------------
+-- Returns an onbatch function for internal._globstreaming that adds each
+-- globbed entry via add(), and periodically shows the matches so far while the
+-- enumeration continues.  Returns nil in the main coroutine, where matches
+-- can't be shown until generating is finished anyway.
+local partial_interval = 0.1
+local function make_onbatch(ismain, matches, add)
+    if ismain then
+        return
+    end
+
+    local builder = internal.co_state._current_builder
+    local lastclock = os.clock()
+    local shown = 0
+    local onbatch = {}
+    onbatch.added = 0
+
+    -- Showing the matches calls into the line editor, which may run Lua, so
+    -- it must happen on the main coroutine.  The same function is used each
+    -- time, so runonmain() only queues it once until it runs.
+    local function notify()
+        builder:_notify_partial()
+    end
+
+    onbatch.func = function(t)
+        for index = onbatch.added + 1, #t do
+            add(t[index])
+        end
+        onbatch.added = #t
+        if builder then
+            local now = os.clock()
+            if now - lastclock >= partial_interval then
+                lastclock = now
+                -- Only pass the matches added since the last time.
+                local batch = {}
+                for index = shown + 1, #matches do
+                    table.insert(batch, matches[index])
+                end
+                shown = #matches
+                builder:_matches_partial(batch)
+                clink.runonmain(notify)
+            end
+        end
+    end
+    return onbatch
+end
+
 --------------------------------------------------------------------------------
 local function dir_matches_impl(match_word, exact)
     local word, expanded = rl.expandtilde(match_word or "")
@@ -2498,10 +2572,15 @@ local function dir_matches_impl(match_word, exact)
     }
 
     local matches = {}
-    for _, i in ipairs(os.globdirs(word..(exact and "" or "*"), true, flags)) do
-        local m = path.join(root, i.name)
-        table.insert(matches, { match = m, type = i.type })
-        if not ismain and _ % 250 == 0 then
+    local function add(i)
+        table.insert(matches, { match = path.join(root, i.name), type = i.type })
+    end
+
+    local onbatch = make_onbatch(ismain, matches, add)
+    local dirs = internal._globstreaming(true, word..(exact and "" or "*"), true, flags, onbatch and onbatch.func)
+    for index = (onbatch and onbatch.added or 0) + 1, #dirs do
+        add(dirs[index])
+        if not ismain and index % 250 == 0 then
             coroutine.yield()
         end
     end
@@ -2588,13 +2667,19 @@ local function file_matches_impl(match_word, exact)
 
     local matches = {}
     local show_sizes = settings.get("match.file_sizes")
-    for _, i in ipairs(os.globfiles(word..(exact and "" or "*"), 2, flags)) do
+    local function add(i)
         local m = { match = path.join(root, i.name), type = i.type }
         if show_sizes and i.type:find("file") then
             m.description = format_file_size(i.size)
         end
         table.insert(matches, m)
-        if not ismain and _ % 100 == 0 then
+    end
+
+    local onbatch = make_onbatch(ismain, matches, add)
+    local files = internal._globstreaming(false, word..(exact and "" or "*"), 2, flags, onbatch and onbatch.func)
+    for index = (onbatch and onbatch.added or 0) + 1, #files do
+        add(files[index])
+        if not ismain and index % 100 == 0 then
             coroutine.yield()
         end
     end
@@ -2813,43 +2898,113 @@ local function get_completion_dirs()
 end
 
 --------------------------------------------------------------------------------
-local function load_from_completions_directory(command_word, quoted, no_cmd)
-    -- Where to look.
+-- Index of the Lua scripts in the completions directories, so that looking up
+-- a command doesn't need to probe each directory.  Maps a lowercase script
+-- name to a table of { [dir index] = full file name }.  It's rebuilt when the
+-- list of directories changes, or when the last write time of any directory
+-- changes (which happens when files are added, removed, or renamed).  The
+-- directories are only checked once per input line.
+local _completion_index
+local _completion_index_dirs
+local _completion_index_stamps = {}
+local _completion_index_verified
+local _completion_index_builds = 0
+
+--------------------------------------------------------------------------------
+local function is_completion_index_current(dirs)
+    if not _completion_index or _completion_index_dirs ~= dirs then
+        return false
+    end
+    if _completion_index_verified then
+        return true
+    end
+    for i, d in ipairs(dirs) do
+        if _completion_index_stamps[i] ~= (internal._get_file_stamp(d) or "") then
+            return false
+        end
+    end
+    _completion_index_verified = true
+    return true
+end
+
+--------------------------------------------------------------------------------
+local function get_completion_index()
     local dirs = get_completion_dirs()
+    if is_completion_index_current(dirs) then
+        return _completion_index
+    end
+
+    local index = {}
+    local stamps = {}
+    local flags = { hidden=true, system=true }
+    for i, d in ipairs(dirs) do
+        -- Stamp before enumerating, so a change during enumeration is caught
+        -- next time.
+        stamps[i] = internal._get_file_stamp(d) or ""
+        if d ~= "" then
+            for _, name in ipairs(internal._globfiles(path.join(d, "*.lua"), nil, flags)) do
+                local key = clink.lower(name)
+                local files = index[key]
+                if not files then
+                    files = {}
+                    index[key] = files
+                end
+                files[i] = path.join(d, name)
+            end
+        end
+    end
+
+    _completion_index = index
+    _completion_index_dirs = dirs
+    _completion_index_stamps = stamps
+    _completion_index_verified = true
+    _completion_index_builds = _completion_index_builds + 1
+    return index
+end
+
+--------------------------------------------------------------------------------
+local function find_completion_scripts(command_word)
+    local index = get_completion_index()
 
     -- What to look for.
-    local primary = path.getname(command_word)..".lua"
+    local primary = index[clink.lower(path.getname(command_word))..".lua"]
     local secondary
     if path.isexecext(command_word) then
         secondary = path.getbasename(command_word)
-        if secondary == "" then
-            secondary = nil
+        if secondary ~= "" then
+            secondary = index[clink.lower(secondary)..".lua"]
         else
-            secondary = secondary..".lua"
+            secondary = nil
         end
     end
 
+    if primary or secondary then
+        return primary, secondary
+    end
+end
+
+--------------------------------------------------------------------------------
+local function load_from_completions_directory(command_word, quoted, no_cmd)
+    -- Where to look.
+    local dirs = get_completion_dirs()
+
+    -- What to look for.
+    local primary, secondary = find_completion_scripts(command_word)
+    if not primary and not secondary then
+        return
+    end
+
     -- Look for file.
     local loaded = {}
-    for _,d in ipairs(dirs) do
+    for i,d in ipairs(dirs) do
         if d ~= "" then
-            local file = path.join(d, primary)
-            if not os.isfile(file) then
-                if not secondary then
-                    file = nil
-                else
-                    file = path.join(d, secondary)
-                    if not os.isfile(file) then
-                        file = nil
-                    end
-                end
-            end
+            local file = primary and primary[i] or secondary and secondary[i]
             if file and not loaded[file] then
                 loaded[file] = true
                 loaded_argmatchers[command_word] = 2 -- Attempted and Loaded.
                 -- Load the file.
                 local impl = function ()
-                    local func, message = loadfile(file)
+                    local func, message = internal._loadfile(file)
                     if not func then
                         error(message)
                     end
@@ -2986,6 +3141,100 @@ local function _has_argmatcher(command_word, quoted, no_cmd)
     return argmatcher
 end
 
+--------------------------------------------------------------------------------
+local c_preload_history = 50
+local _preloaded = 0
+
+--------------------------------------------------------------------------------
+local function get_history_command_word(line)
+    local word = line:match('^%s*@?"([^"]+)"') or line:match("^%s*@?([^%s&|<>()]+)")
+    if word then
+        return clink.lower(word:gsub("/", "\\"))
+    end
+end
+
+--------------------------------------------------------------------------------
+-- Resolves a command word the same way _has_argmatcher() does, so that
+-- loaded_argmatchers uses the same keys.  Yields while the recognizer is
+-- working on it.  Returns nil if the word isn't a recognized executable, since
+-- _has_argmatcher() doesn't load scripts for those either, or if the
+-- recognizer doesn't answer in a reasonable number of tries.
+local function resolve_preload_command_word(word)
+    -- Pass true because argmatcher lookups always treat ^ literally.
+    local _, ready, file = clink.recognizecommand(word, true)
+    for _ = 1, 50 do
+        if ready then
+            break
+        end
+        coroutine.yield()
+        _, ready, file = clink.recognizecommand(word, true)
+    end
+    if ready and file then
+        return clink.lower(file)
+    end
+end
+
+--------------------------------------------------------------------------------
+-- Loads completion scripts for the commands in recent history, newest first.
+-- This runs in a background coroutine while waiting for input, and yields
+-- after each script.
+local function preload_argmatchers()
+    local count = rl.gethistorycount()
+    if count <= 0 then
+        return
+    end
+
+    local items = rl.gethistoryitems(math.max(1, count - c_preload_history + 1), count)
+    if not items then
+        return
+    end
+
+    local seen = {}
+    for i = #items, 1, -1 do
+        local word = get_history_command_word(items[i].line)
+        if word and not seen[word] then
+            seen[word] = true
+            -- Only ask the recognizer about words that have a completion
+            -- script, then key by the resolved file like _has_argmatcher().
+            local file = not path.isdevice(word) and find_completion_scripts(word) and resolve_preload_command_word(word)
+            if file and
+                    not loaded_argmatchers[file] and
+                    not _is_argmatcher_loaded(file) and
+                    find_completion_scripts(file) then
+                loaded_argmatchers[file] = 1 -- Attempted.
+                load_from_completions_directory(file)
+                _preloaded = _preloaded + 1
+                coroutine.yield()
+            end
+        end
+    end
+end
+
+--------------------------------------------------------------------------------
+clink.onbeginedit(function ()
+    -- Check the completions directories again during the new input line.
+    _completion_index_verified = nil
+
+    if not settings.get("argmatcher.preload") then
+        return
+    end
+
+    -- Build the index now, so it's ready before any input arrives.
+    get_completion_index()
+
+    local c = coroutine.create(preload_argmatchers)
+    clink.setcoroutinename(c, "preload argmatchers")
+end)
+
+--------------------------------------------------------------------------------
+-- For tests.
+function clink._internal._get_completion_index_state()
+    return is_completion_index_current(get_completion_dirs()), _completion_index_builds
+end
+clink._internal._get_completion_index = get_completion_index
+clink._internal._resolve_preload_command_word = resolve_preload_command_word
+clink._internal._preload_argmatchers = preload_argmatchers
+
 --------------------------------------------------------------------------------
 -- Finds an argmatcher for the first word.
 --
@@ -3352,8 +3601,8 @@ end
 
 --------------------------------------------------------------------------------
 function argmatcher_classifier:classify(commands) -- luacheck: no self
-    local unrecognized_color = settings.get("color.unrecognized") ~= ""
-    local executable_color = settings.get("color.executable") ~= ""
+    local unrecognized_color = get_classify_color("u") ~= ""
+    local executable_color = get_classify_color("x") ~= ""
     for _,command in ipairs(commands) do
         local line_state = command.line_state
         local word_classifier = command.classifications
@@ -3394,7 +3643,15 @@ function argmatcher_classifier:classify(commands) -- luacheck: no self
                 elseif unrecognized_color or executable_color then
                     local cl
                     local line = line_state:getline()
-                    local recognized = internal._recognize_command(line, cw, info.quoted)
+                    -- Words nearer the cursor get recognized sooner.
+                    local cursor = line_state:getcursor()
+                    local distance = 0
+                    if cursor < info.offset then
+                        distance = info.offset - cursor
+                    elseif cursor > info.offset + info.length then
+                        distance = cursor - (info.offset + info.length)
+                    end
+                    local recognized = internal._recognize_command(line, cw, info.quoted, distance)
                     if recognized < 0 then
                         cl = unrecognized_color and "u" or "o"      --unrecognized
                     elseif recognized > 0 then
@@ -3809,6 +4066,14 @@ function clink._internal._diag_completions_dirs(arg)
     clink.print("", "commands searched:", attempted)
     clink.print("", "Lua scripts loaded:", loaded)
     clink.print("", "argmatchers loaded:", found)
+    clink.print("", "preloaded commands:", _preloaded)
+
+    local scripts = 0
+    for _ in pairs(get_completion_index()) do
+        scripts = scripts + 1
+    end
+    clink.print("", "indexed scripts:", scripts)
+    clink.print("", "index builds:", _completion_index_builds)
 end
 
 
@@ -65,6 +65,10 @@ local function log_cost(tick, classifier)
         cost.peak = elapsed
     end
 
+    if internal._trace_enabled() then
+        internal._trace_callback(tick, classifier, classifier.classify, "classifier")
+    end
+
     elapsed_this_pass = elapsed_this_pass + elapsed
 end
 
@@ -162,61 +162,73 @@ end
 
 
 --------------------------------------------------------------------------------
-function os.globdirs(pattern, extrainfo, flags)
-    if flags == nil and type(extrainfo) == "table" then
-        flags = extrainfo
-        extrainfo = nil
+-- Globs from a coroutine.  The directory is enumerated by a background task,
+-- and the coroutine yields until more entries are available, so a slow drive
+-- or network share doesn't block input.  If onbatch is provided, it's called
+-- with the table each time more entries arrive.
+local function glob_in_coroutine(c, make, pattern, extrainfo, flags, onbatch)
+    local t = {}
+    local g, asyncyield = make(pattern, extrainfo, flags)
+    while true do
+        local count = #t
+        local more, wait = g:next(t)
+        if onbatch and #t > count then
+            onbatch(t)
+        end
+        if not more then
+            break
+        end
+        if wait and asyncyield then
+            clink._internal._set_coroutine_asyncyield(asyncyield)
+            coroutine.yield()
+            clink._internal._set_coroutine_asyncyield(nil)
+        else
+            coroutine.yield()
+        end
+        if internal._is_coroutine_canceled(c) then
+            t = {}
+            break
+        end
     end
+    g:close()
+    return t
+end
 
+--------------------------------------------------------------------------------
+-- Like os.globdirs or os.globfiles, but calls onbatch(t) each time more
+-- entries arrive when used in a coroutine.
+function internal._globstreaming(dirs, pattern, extrainfo, flags, onbatch)
     local c, ismain = coroutine.running()
     if ismain then
         -- Use a fully native implementation for higher performance.
-        return internal._globdirs(pattern, extrainfo, flags)
+        local glob = dirs and internal._globdirs or internal._globfiles
+        return glob(pattern, extrainfo, flags)
     elseif internal._is_coroutine_canceled(c) then
         return {}
     else
-        -- Yield periodically.
-        local t = {}
-        local g = internal._makedirglobber(pattern, extrainfo, flags)
-        while g:next(t) do
-            coroutine.yield()
-            if internal._is_coroutine_canceled(c) then
-                t = {}
-                break
-            end
-        end
-        g:close()
-        return t
+        local make = dirs and internal._makeasyncdirglobber or internal._makeasyncfileglobber
+        return glob_in_coroutine(c, make, pattern, extrainfo, flags, onbatch)
     end
 end
 
 --------------------------------------------------------------------------------
-function os.globfiles(pattern, extrainfo, flags)
+function os.globdirs(pattern, extrainfo, flags)
     if flags == nil and type(extrainfo) == "table" then
         flags = extrainfo
         extrainfo = nil
     end
 
-    local c, ismain = coroutine.running()
-    if ismain then
-        -- Use a fully native implementation for higher performance.
-        return internal._globfiles(pattern, extrainfo, flags)
-    elseif internal._is_coroutine_canceled(c) then
-        return {}
-    else
-        -- Yield periodically.
-        local t = {}
-        local g = internal._makefileglobber(pattern, extrainfo, flags)
-        while g:next(t) do
-            coroutine.yield()
-            if internal._is_coroutine_canceled(c) then
-                t = {}
-                break
-            end
-        end
-        g:close()
-        return t
+    return internal._globstreaming(true, pattern, extrainfo, flags)
+end
+
+--------------------------------------------------------------------------------
+function os.globfiles(pattern, extrainfo, flags)
+    if flags == nil and type(extrainfo) == "table" then
+        flags = extrainfo
+        extrainfo = nil
     end
+
+    return internal._globstreaming(false, pattern, extrainfo, flags)
 end
 
 --------------------------------------------------------------------------------
@@ -816,3 +828,59 @@ function clink.addpackagepath(dir, literal)
     end
     package.path = pattern .. package_path
 end
+
+--------------------------------------------------------------------------------
+-- Trace span names, keyed weakly by owner so that owners (which can be tables
+-- that belong to scripts) aren't modified and can still be collected.
+local _trace_names = setmetatable({}, { __mode="k" })
+
+--------------------------------------------------------------------------------
+-- Records a trace span for a Lua callback, named after the kind of callback
+-- and where its function is defined.  The name is computed once per owner.
+function internal._trace_callback(tick, owner, func, kind)
+    local name = _trace_names[owner]
+    if not name then
+        local info = debug.getinfo(func, "S")
+        name = kind.." "..(info and (info.short_src..":"..info.linedefined) or "?")
+        _trace_names[owner] = name
+    end
+    internal._trace_record(name, tick)
+end
+
+--------------------------------------------------------------------------------
+local function end_trace(name, tick, ...)
+    internal._trace_record(name, tick)
+    return ...
+end
+
+--------------------------------------------------------------------------------
+--- -name:  clink.trace
+--- -ver:   1.9.33
+--- -arg:   name:string
+--- -arg:   func:function
+--- -arg:   ...
+--- -ret:   ...
+--- Calls <span class="arg">func</span> with the remaining arguments, and
+--- returns whatever it returns.
+---
+--- When tracing is enabled by the
+--- <code><a href="#debug_trace_file">debug.trace_file</a></code> setting or
+--- the <code>%CLINK_TRACE_FILE%</code> environment variable, the time the call
+--- takes is recorded in the trace file as a span named
+--- <span class="arg">name</span>.  The trace file can be loaded in
+--- <code>chrome://tracing</code> or <a href="https://ui.perfetto.dev">Perfetto</a>
+--- to see how long each part of handling a keystroke took.
+---
+--- When tracing is disabled, this just calls the function.
+--- -show:  local function get_branch_info(dir)
+--- -show:  &nbsp;   -- ...
+--- -show:  end
+--- -show:
+--- -show:  local info = clink.trace("my prompt: branch info", get_branch_info, os.getcwd())
+function clink.trace(name, func, ...)
+    if not internal._trace_enabled() then
+        return func(...)
+    end
+    local tick = os.clock()
+    return end_trace(name, tick, func(...))
+end
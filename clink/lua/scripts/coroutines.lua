@@ -18,6 +18,30 @@ local _dead = nil                       -- List of dead coroutines (only when "l
 local _trimmed = 0                      -- Number of coroutines discarded from the dead list (overflow).
 local _pending_on_main = nil            -- Funcs to run when control returns to the main coroutine.
 local _throttle_interval = nil          -- Whether to throttle long-running coroutines.
+local _coroutine_sequence = 0           -- Creation order, for FIFO ordering within a priority class.
+
+-- Priority classes.  Lower numbers are resumed first.  Generators produce
+-- matches/suggestions for the input line, so they're input-critical; prompt
+-- coroutines come next; everything else (e.g. argmatcher loaders or scripts'
+-- own coroutines) runs in the background.
+local _priority_input = 1
+local _priority_prompt = 2
+local _priority_background = 3
+local _priority_names = { "input", "prompt", "background" }
+
+-- Time slices per priority class, in seconds.  Once a resume pass has spent
+-- this long in a class, remaining coroutines in the class are deferred to the
+-- next pass so that control returns to the input loop.  Each class's slice
+-- starts when the pass reaches that class, and each class always gets at least
+-- one resume per pass, so lower classes can't be starved by higher ones.
+-- Input-critical coroutines are never deferred.  Lua coroutines can't be preempted, so a slice can only be
+-- enforced between resumes; waiting on a yieldguard doesn't count against it.
+local _time_slices = {
+    [_priority_prompt] = 0.050,
+    [_priority_background] = 0.020,
+}
+
+local _class_stats = {}                 -- CPU accounting per priority class.
 
 local _main_perthread_state = {}
 internal.co_state = _main_perthread_state
@@ -40,6 +64,8 @@ local print = clink.print
 --      state:          Global state context for the coroutine (contains variables that are swapped).
 --      co_state:       Global state context for the coroutine (the table itself is swapped).
 --      src:            The source code file and line for the coroutine function.
+--      priority:       The priority class (_priority_input, etc).
+--      sequence:       Creation order, for breaking ties between deadlines.
 --
 --  Updated by the coroutine management system:
 --      resumed:        Number of times the coroutine has been resumed.
@@ -47,6 +73,9 @@ local print = clink.print
 --      throttleclock:  The os.clock() from the end of the most recent yieldguard or asyncyield.
 --      lastclock:      The os.clock() from the end of the last resume.
 --      runtime:        Sum of execution time used by the coroutine.
+--      maxslice:       Longest execution time of a single resume.
+--      deferred:       Number of times it was due but deferred by a time slice.
+--      deadline:       The target clock when it was last found due.
 --      queued:         Use INFINITE wait for this coroutine; it's queued inside popenyield.
 --      yieldguard:     Yielding due to io.popen, os.execute, etc.
 --      asyncyield:     Yielding due to an async_lua_task.
@@ -81,6 +110,11 @@ local function clear_coroutines()
         _throttle_interval = nil
     end
 
+    _class_stats = {}
+    for priority = _priority_input, _priority_background do
+        _class_stats[priority] = { resumed=0, runtime=0, maxslice=0, deferred=0 }
+    end
+
     for _, entry in ipairs(preserve) do
         _coroutines[entry.coroutine] = entry
         _coroutines_resumable = true
@@ -227,6 +261,44 @@ local function is_entry_ready(entry, now)
     end
 end
 
+--------------------------------------------------------------------------------
+local function is_entry_due(entry, now)
+    if entry.yieldguard and not entry.yieldguard:ready() then
+        -- It would only yield again, so don't spend any time resuming it.
+        return false
+    end
+    return next_entry_target(entry, now) <= now and is_entry_ready(entry, now)
+end
+
+--------------------------------------------------------------------------------
+local function compare_due_entries(a, b)
+    if a.priority ~= b.priority then
+        return a.priority < b.priority
+    elseif a.deadline ~= b.deadline then
+        return a.deadline < b.deadline
+    else
+        return a.sequence < b.sequence
+    end
+end
+
+--------------------------------------------------------------------------------
+local function add_class_stats(entry, elapsed, deferred)
+    local stats = _class_stats[entry.priority]
+    if not stats then
+        stats = { resumed=0, runtime=0, maxslice=0, deferred=0 }
+        _class_stats[entry.priority] = stats
+    end
+    if deferred then
+        stats.deferred = stats.deferred + 1
+    else
+        stats.resumed = stats.resumed + 1
+        stats.runtime = stats.runtime + elapsed
+        if stats.maxslice < elapsed then
+            stats.maxslice = elapsed
+        end
+    end
+end
+
 --------------------------------------------------------------------------------
 function internal._after_coroutines(func)
     if type(func) ~= "function" then
@@ -301,6 +373,9 @@ function clink._internal._resume_coroutines()
             table.insert(remove, c)
         elseif not check_generation(c) and (not entry.yieldguard or entry.yieldguard:ready()) then
             entry.canceled = true
+            if entry.asyncyield then
+                entry.asyncyield:cancel()
+            end
             table.insert(remove, c)
         end
     end
@@ -312,39 +387,73 @@ function clink._internal._resume_coroutines()
     local co
     remove = {}
     local impl = function()
-        for c,entry in pairs(_coroutines) do
-            co = c
+        -- Collect the coroutines that are due, and order them by priority
+        -- class and then by deadline, so that input-critical coroutines run
+        -- first and the most overdue coroutine in each class runs next.
+        local due = {}
+        local now = os.clock()
+        for _,entry in pairs(_coroutines) do
             _coroutines_resumable = true
-            local now = os.clock()
-            if next_entry_target(entry, now) <= now and is_entry_ready(entry, now) then
-                if not entry.firstclock then
-                    entry.firstclock = now
-                end
-                if entry.asyncyield then
-                    entry.throttleclock = now
+            if is_entry_due(entry, now) then
+                entry.deadline = next_entry_target(entry, now)
+                table.insert(due, entry)
+            end
+        end
+        table.sort(due, compare_due_entries)
+
+        local classclock = {}
+        for _,entry in ipairs(due) do
+            local c = entry.coroutine
+            co = c
+            -- Skip coroutines that were removed by an earlier resume.
+            if _coroutines[c] == entry then
+                now = os.clock()
+                local slice = _time_slices[entry.priority]
+                local started = classclock[entry.priority]
+                if not started then
+                    classclock[entry.priority] = now
                 end
-                entry.resumed = entry.resumed + 1
-                internal._set_coroutine_context(entry.context)
-                local ok, ret
-                if entry.isprompt or entry.isgenerator then
-                    ok, ret = coroutine.resume(c, true--[[async]])
+                if slice and started and now - started >= slice then
+                    -- Still due, so the next pass picks it up after the input
+                    -- loop has had a chance to run.
+                    entry.deferred = entry.deferred + 1
+                    add_class_stats(entry, 0, true--[[deferred]])
                 else
-                    ok, ret = coroutine.resume(c)
-                end
-                if ok then
+                    if not entry.firstclock then
+                        entry.firstclock = now
+                    end
+                    if entry.asyncyield then
+                        entry.throttleclock = now
+                    end
+                    entry.resumed = entry.resumed + 1
+                    internal._set_coroutine_context(entry.context)
+                    local ok, ret
+                    if entry.isprompt or entry.isgenerator then
+                        ok, ret = coroutine.resume(c, true--[[async]])
+                    else
+                        ok, ret = coroutine.resume(c)
+                    end
                     -- Use live clock so the interval excludes the execution
                     -- time of the coroutine.
-                    entry.lastclock = os.clock()
-                else
-                    if not entry.canceled then
-                        print("")
-                        print("coroutine failed:")
-                        _co_error_handler(c, ret)
-                        entry.error = ret
+                    local endclock = os.clock()
+                    local elapsed = endclock - now
+                    if entry.maxslice < elapsed then
+                        entry.maxslice = elapsed
+                    end
+                    add_class_stats(entry, elapsed)
+                    if ok then
+                        entry.lastclock = endclock
+                    else
+                        if not entry.canceled then
+                            print("")
+                            print("coroutine failed:")
+                            _co_error_handler(c, ret)
+                            entry.error = ret
+                        end
+                    end
+                    if coroutine.status(c) == "dead" then
+                        table.insert(remove, c)
                     end
-                end
-                if coroutine.status(c) == "dead" then
-                    table.insert(remove, c)
                 end
             end
         end
@@ -422,6 +531,10 @@ function internal._cancel_coroutine(c)
     if entry then
         -- Causes all globbers in the coroutine to short circuit.
         entry.canceled = true
+        -- Stops any background task the coroutine is waiting on.
+        if entry.asyncyield then
+            entry.asyncyield:cancel()
+        end
     end
 end
 
@@ -513,6 +626,7 @@ function clink._internal._diag_coroutines()
     local max_resumed_len = 0
     local max_freq_len = 0
     local max_runtime_len = 0
+    local max_class_len = 0
 
     local function collect_diag(list, threads)
         for _,entry in pairs(list) do
@@ -520,6 +634,11 @@ function clink._internal._diag_coroutines()
             local status = entry.status or coroutine.status(entry.coroutine)
             local freq = tostring(entry.interval)
             local runtime = string.format("%.4f", entry.runtime)
+            local class = _priority_names[entry.priority] or "?"
+            local maxslice = string.format("%.4f", entry.maxslice or 0)
+            if max_class_len < #class then
+                max_class_len = #class
+            end
             if max_resumed_len < #resumed then
                 max_resumed_len = #resumed
             end
@@ -535,7 +654,7 @@ function clink._internal._diag_coroutines()
                 end
                 show_gen = true
             end
-            table.insert(threads, { entry=entry, status=status, resumed=resumed, freq=freq, runtime=runtime })
+            table.insert(threads, { entry=entry, status=status, resumed=resumed, freq=freq, runtime=runtime, class=class, maxslice=maxslice })
         end
     end
 
@@ -561,12 +680,17 @@ function clink._internal._diag_coroutines()
             else -- luacheck: ignore 542
                 -- TODO: Show when throttled.
             end
+            if t.entry.deferred and t.entry.deferred > 0 then
+                status = status..yellow.."deferred "..t.entry.deferred..plain.."  "
+            end
+            local class = str_rpad(t.class, max_class_len)
             local res = "resumed "..str_rpad(t.resumed, max_resumed_len)
             local freq = "freq "..str_rpad(t.freq, max_freq_len)
             local runtime = "time "..str_rpad(t.runtime, max_runtime_len)
+            local maxslice = "max "..t.maxslice
             -- TODO: Show next wakeup time.
             local src = tostring(t.entry.src)
-            print(plain.."  "..key.."  "..gen..status..res.."  "..freq.."  "..runtime.."  "..src..norm)
+            print(plain.."  "..key.."  "..gen..status..class.."  "..res.."  "..freq.."  "..runtime.."  "..maxslice.."  "..src..norm)
             if t.entry.error then
                 print(plain.."  "..str_rpad("", #key + 2)..red..t.entry.error..norm)
             end
@@ -590,6 +714,14 @@ function clink._internal._diag_coroutines()
         end
         print("  resumable", _coroutines_resumable)
         print("  wait_duration", clink._internal._wait_duration())
+        for priority = _priority_input, _priority_background do
+            local stats = _class_stats[priority]
+            if stats and (stats.resumed > 0 or stats.deferred > 0) then
+                local name = str_rpad(_priority_names[priority], 10)
+                print(string.format("  %s  resumed %d  time %.4f  max %.4f  deferred %d",
+                                    name, stats.resumed, stats.runtime, stats.maxslice, stats.deferred))
+            end
+        end
         for category, cyg in spairs(_coroutine_yieldguard) do
             local yg = cyg.yieldguard
             print("  "..category)
@@ -1005,6 +1137,122 @@ io.popen = function (command, mode)
     return old_io_popen(command, mode)
 end
 
+--------------------------------------------------------------------------------
+-- Maps a cache key to the coroutine that is running the command.  A key is
+-- only pending while that coroutine is alive and still registered; a
+-- coroutine that's removed or abandoned won't resume to clear its key.
+local _popencached_pending = {}
+
+local function is_popencached_pending(key)
+    local owner = _popencached_pending[key]
+    if owner and (coroutine.status(owner) == "dead" or not _coroutines[owner]) then
+        _popencached_pending[key] = nil
+        owner = nil
+    end
+    return owner and true or false
+end
+
+--------------------------------------------------------------------------------
+--- -name:  io.popencached
+--- -ver:   1.9.33
+--- -arg:   command:string
+--- -arg:   [options:table]
+--- -ret:   file
+--- This is like <code>io.popen(command, "r")</code>, except that the command's
+--- output is cached for the rest of the Clink session.  Later calls with the
+--- same command reuse the output instead of running the command again, even
+--- from other coroutines or after <code>clink-reload</code>.  This is useful
+--- for argmatchers and prompt filters that run the same command over and over,
+--- for example to list subcommands.
+---
+--- Cached output is only reused when the current directory is the same as when
+--- the command ran.  The optional <span class="arg">options</span> table can
+--- control the cache further:
+--- <table>
+--- <tr><th>Field</th><th>Description</th></tr>
+--- <tr><td><code>ttl</code></td><td>Number of seconds the output stays valid.  When omitted, it stays valid for the rest of the session.</td></tr>
+--- <tr><td><code>env</code></td><td>Table of environment variable names whose values are part of the cache key.</td></tr>
+--- <tr><td><code>files</code></td><td>Table of file names; if any of the files change (or are created or deleted), the cached output is discarded.</td></tr>
+--- <tr><td><code>mode</code></td><td>"t" for text mode (the default) or "b" for binary mode.</td></tr>
+--- </table>
+---
+--- The returned file handle only supports reading, and it should be closed
+--- when done with it.  The exit status is not available.  Output from a
+--- command that fails (exits with a nonzero status) is not cached.
+---
+--- Hit rates for the cache are shown by <code>clink info</code>.
+--- -show:  local file = io.popencached("npm help", { ttl=600, env={"PATH"} })
+--- -show:  for line in file:lines() do
+--- -show:  &nbsp;   add_subcommand(line)
+--- -show:  end
+--- -show:  file:close()
+function io.popencached(command, options)
+    options = options or {}
+    local binary = options.mode and options.mode:find("b") and true or false
+
+    local key = command.."\n"..(os.getcwd() or "")
+    if options.env then
+        for _, name in ipairs(options.env) do
+            key = key.."\n"..name.."="..(os.getenv(name) or "")
+        end
+    end
+
+    -- If another coroutine is already running the command, wait for it.
+    local c, ismain = coroutine.running()
+    if not ismain then
+        while is_popencached_pending(key) do
+            coroutine.yield()
+        end
+    end
+
+    local file = internal._cmdcache_open(key, binary)
+    if file then
+        return file
+    end
+
+    _popencached_pending[key] = c
+    local ok, data, err, code, succeeded = pcall(function ()
+        -- In a coroutine this is io.popenyield, which returns a function to
+        -- close the file and get the exit status.
+        local f, pclose, code = io.popen(command, "rb") -- luacheck: ignore 421
+        if not f then
+            return f, pclose, code
+        end
+        local data = f:read("*a") or "" -- luacheck: ignore 421
+        local status
+        if type(pclose) == "function" then
+            status = pclose()
+        else
+            status = f:close()
+        end
+        return data, nil, nil, status and true or false
+    end)
+    if _popencached_pending[key] == c then
+        _popencached_pending[key] = nil
+    end
+    if not ok then
+        error(data, 0)
+    elseif not data then
+        return nil, err, code
+    end
+
+    -- Don't cache the output if the command failed, or if the coroutine was
+    -- canceled (the output is then empty because the command never ran).
+    local canceled = not ismain and (internal._is_coroutine_canceled(c) or not check_generation(c))
+    if succeeded and not canceled then
+        internal._cmdcache_store(key, data, options.ttl, options.files)
+        file = internal._cmdcache_open(key, binary)
+    end
+    if not file then
+        -- Not cached (or too large to cache); return it in a temporary file
+        -- instead.
+        file = io.tmpfile()
+        file:write(binary and data or (data:gsub("\r\n", "\n")))
+        file:seek("set", 0)
+    end
+    return file
+end
+
 --------------------------------------------------------------------------------
 -- MAGIC:  Redirect os.execute to os.executeyield when used in a coroutine.
 local old_os_execute = os.execute
@@ -1089,10 +1337,24 @@ function coroutine.create(func) -- luacheck: ignore 122
     override_coroutine_isprompt = nil
     override_coroutine_isgenerator = nil
 
+    local priority
+    if isgenerator then
+        priority = _priority_input
+    elseif isprompt then
+        priority = _priority_prompt
+    else
+        priority = _priority_background
+    end
+    _coroutine_sequence = _coroutine_sequence + 1
+
     local entry = {
         interval=0,
         resumed=0,
         runtime=0,
+        maxslice=0,
+        deferred=0,
+        priority=priority,
+        sequence=_coroutine_sequence,
         func=func,
         context=_coroutine_context,
         generation=_coroutine_generation,
@@ -28,6 +28,10 @@ local function log_cost(tick, c)
     if cost.peak < elapsed then
         cost.peak = elapsed
     end
+
+    if internal._trace_enabled() then
+        internal._trace_callback(tick, c, c.func, "event")
+    end
 end
 
 --------------------------------------------------------------------------------
@@ -47,6 +47,10 @@ local function log_cost(tick, hinter)
         cost.peak = elapsed
     end
 
+    if internal._trace_enabled() then
+        internal._trace_callback(tick, hinter, hinter.gethint, "hinter")
+    end
+
     elapsed_this_pass = elapsed_this_pass + elapsed
 end
 
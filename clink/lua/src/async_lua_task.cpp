@@ -8,6 +8,7 @@
 #include "async_lua_task.h"
 
 #include <core/os.h>
+#include <core/task_pool.h>
 #include <core/str_unordered_set.h>
 #include <core/debugheap.h>
 #include <terminal/printer.h>
@@ -147,10 +148,54 @@ void task_manager::end_line()
         SetEvent(s_event);
 }
 
+//------------------------------------------------------------------------------
+static void task_pool_diagnostics()
+{
+    task_pool_stats stats;
+    task_pool::get().get_stats(stats);
+    if (!stats.submitted)
+        return;
+
+    static char bold[] = "\x1b[1m";
+    static char norm[] = "\x1b[m";
+
+    str<> s;
+    s.format("%stask pool:%s\n", bold, norm);
+    g_printer->print(s.c_str(), s.length());
+
+    s.format("  %-16s  %u (%u busy, %u blocked, %u peak, %u max)\n", "workers",
+             stats.workers, stats.busy_workers, stats.blocked_workers, stats.peak_workers, task_pool::get().max_workers());
+    g_printer->print(s.c_str(), s.length());
+    s.format("  %-16s  %u (%u peak)\n", "queued", stats.queued, stats.peak_queued);
+    g_printer->print(s.c_str(), s.length());
+    s.format("  %-16s  %llu submitted, %llu completed, %llu stolen\n", "tasks",
+             stats.submitted, stats.completed, stats.stolen);
+    g_printer->print(s.c_str(), s.length());
+
+    const double started = double(stats.completed + stats.busy_workers);
+    if (started > 0)
+    {
+        s.format("  %-16s  %.2f ms avg, %.2f ms max\n", "queue latency",
+                 stats.total_latency * 1000 / started, stats.max_latency * 1000);
+        g_printer->print(s.c_str(), s.length());
+    }
+    if (stats.completed)
+    {
+        s.format("  %-16s  %.2f ms avg, %.2f ms max\n", "run time",
+                 stats.total_runtime * 1000 / double(stats.completed), stats.max_runtime * 1000);
+        g_printer->print(s.c_str(), s.length());
+    }
+}
+
 //------------------------------------------------------------------------------
 void task_manager::diagnostics()
 {
-    if (m_map.empty() || !rl_explicit_arg)
+    if (!rl_explicit_arg)
+        return;
+
+    task_pool_diagnostics();
+
+    if (m_map.empty())
         return;
 
     static char bold[] = "\x1b[1m";
@@ -300,24 +345,32 @@ void async_lua_task::wake_asyncyield() const
 void async_lua_task::start()
 {
     auto task = shared_from_this();
-    m_thread = std::make_unique<std::thread>(&proc, std::move(task));
+    if (!task_pool::get().submit([task]() { proc(task); }, is_blocking()))
+    {
+        // The pool is unusable; complete the task as canceled so that anything
+        // waiting on it doesn't hang.
+        cancel();
+        proc(task);
+    }
 }
 
 //------------------------------------------------------------------------------
 void async_lua_task::detach()
 {
+    // The pool holds a strong ref until the work finishes, so detaching only
+    // needs to tell the work to stop.
     cancel();
-    if (m_thread)
-    {
-        m_thread->detach();
-        m_thread.reset();
-    }
 }
 
 //------------------------------------------------------------------------------
 void async_lua_task::proc(std::shared_ptr<async_lua_task> task)
 {
-    task->do_work();
+    // Skip the work if the task was canceled while it was queued, but still
+    // wake any coroutine waiting on it so it can see the cancellation.
+    if (!task->is_canceled())
+        task->do_work();
+    else
+        task->wake_asyncyield();
     task->m_is_complete = true;
     task->detach();
     SetEvent(task->m_event);
@@ -363,6 +416,16 @@ int32 async_yield_lua::ready(lua_State* state)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+// Cancels the task the coroutine is waiting on, if any.  This lets canceling a
+// coroutine stop background work that nothing will consume anymore.
+int32 async_yield_lua::cancel(lua_State* state)
+{
+    if (auto task = m_task.lock())
+        task->cancel();
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 bool async_yield_lua::is_expired() const
 {
@@ -375,6 +438,7 @@ const async_yield_lua::method async_yield_lua::c_methods[] = {
     { "getname",            &get_name },
     { "getexpiration",      &get_expiration },
     { "ready",              &ready },
+    { "cancel",             &cancel },
     {}
 };
 
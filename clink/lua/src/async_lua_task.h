@@ -6,9 +6,9 @@
 #include <core/str.h>
 
 #include <memory>
-#include <thread>
 
 class lua_state;
+class async_lua_task;
 
 //------------------------------------------------------------------------------
 struct callback_ref
@@ -28,14 +28,17 @@ public:
     bool                    is_expired() const;
     void                    set_ready() { m_ready = true; }
     void                    clear_ready() { m_ready = false; }
+    void                    set_task(const std::shared_ptr<async_lua_task>& task) { m_task = task; }
 
 protected:
     int32                   get_name(lua_State* state);
     int32                   get_expiration(lua_State* state);
     int32                   ready(lua_State* state);
+    int32                   cancel(lua_State* state);
 
 private:
     str_moveable            m_name;
+    std::weak_ptr<async_lua_task> m_task;
     double                  m_expiration = 0.0;
     bool                    m_ready = false;
 
@@ -67,6 +70,7 @@ public:
 
 protected:
     virtual void            do_work() = 0;
+    virtual bool            is_blocking() const { return false; }
 
     void                    wake_asyncyield() const;
 
@@ -78,7 +82,6 @@ private:
 
 private:
     HANDLE                  m_event;
-    std::unique_ptr<std::thread> m_thread;
     str_moveable            m_key;
     str_moveable            m_src;
     async_yield_lua*        m_asyncyield = nullptr;
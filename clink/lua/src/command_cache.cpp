@@ -0,0 +1,188 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "command_cache.h"
+#include "sessionstream.h"
+
+#include <core/debugheap.h>
+
+//------------------------------------------------------------------------------
+command_cache& command_cache::get()
+{
+    static command_cache s_cache;
+    return s_cache;
+}
+
+//------------------------------------------------------------------------------
+command_cache::~command_cache()
+{
+    clear();
+}
+
+//------------------------------------------------------------------------------
+// Returns the name of the session stream holding the cached output for key, or
+// nullptr if there's no usable entry.
+const char* command_cache::find(const char* key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+    {
+        ++m_stats.cmdcache_misses;
+        update_stats();
+        return nullptr;
+    }
+
+    entry* e = it->second.get();
+    const uint64 now = GetTickCount64();
+
+    bool current = true;
+    if (e->ttl_ms && now - e->stored_tick >= e->ttl_ms)
+    {
+        ++m_stats.cmdcache_expired;
+        current = false;
+    }
+    else
+    {
+        for (const auto& file : e->files)
+        {
+            if (!os::is_file_stamp_current(file.path.c_str(), file))
+            {
+                ++m_stats.cmdcache_invalidated;
+                current = false;
+                break;
+            }
+        }
+    }
+
+    // The stream can be missing if something discarded it.
+    if (current && !find_session_stream(e->stream.c_str(), false))
+        current = false;
+
+    if (!current)
+    {
+        remove(key);
+        ++m_stats.cmdcache_misses;
+        update_stats();
+        return nullptr;
+    }
+
+    e->used_tick = now;
+    ++m_stats.cmdcache_hits;
+    update_stats();
+    return e->stream.c_str();
+}
+
+//------------------------------------------------------------------------------
+// Stores output for key, replacing any previous entry.  The dependency files
+// are stamped now, so a change made while the command was running is caught
+// only if it lands after this.  Returns the name of the session stream, or
+// nullptr if the output is too large to cache.
+const char* command_cache::store(const char* key, const char* data, uint32 len, uint32 ttl_ms, const std::vector<str_moveable>& files)
+{
+    remove(key);
+
+    if (len > c_max_bytes / 4)
+        return nullptr;
+
+    evict(len);
+
+    dbg_ignore_scope(snapshot, "command_cache");
+
+    auto e = std::make_unique<entry>();
+    e->key = key;
+    e->stream.format("clink.cmdcache.%u", ++m_next_id);
+    e->stored_tick = e->used_tick = GetTickCount64();
+    e->ttl_ms = ttl_ms;
+    e->bytes = len;
+
+    e->files.reserve(files.size());
+    for (const auto& name : files)
+    {
+        file_stamp stamp;
+        stamp.path = name.c_str();
+        os::get_file_stamp(stamp.path.c_str(), stamp);
+        e->files.emplace_back(std::move(stamp));
+    }
+
+    auto stream = find_session_stream(e->stream.c_str(), true);
+    stream_position_t offset = 0;
+    if (stream->write(offset, data, len) != len)
+    {
+        discard_session_stream(e->stream.c_str());
+        update_stats();
+        return nullptr;
+    }
+
+    const char* name = e->stream.c_str();
+    m_stats.cmdcache_bytes += len;
+    m_entries.emplace(e->key.c_str(), std::move(e));
+    update_stats();
+    return name;
+}
+
+//------------------------------------------------------------------------------
+void command_cache::clear()
+{
+    for (const auto& it : m_entries)
+        discard_session_stream(it.second->stream.c_str());
+    m_entries.clear();
+    m_stats.cmdcache_bytes = 0;
+    update_stats();
+}
+
+//------------------------------------------------------------------------------
+void command_cache::get_stats(session_stats& stats) const
+{
+    stats = m_stats;
+    stats.cmdcache_entries = uint32(m_entries.size());
+}
+
+//------------------------------------------------------------------------------
+void command_cache::remove(const char* key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+        return;
+
+    discard_session_stream(it->second->stream.c_str());
+    m_stats.cmdcache_bytes -= it->second->bytes;
+    m_entries.erase(it);
+}
+
+//------------------------------------------------------------------------------
+// Evicts least recently used entries until there's room for another entry of
+// need_bytes.
+void command_cache::evict(uint32 need_bytes)
+{
+    while (!m_entries.empty() &&
+           (m_entries.size() >= c_max_entries || m_stats.cmdcache_bytes + need_bytes > c_max_bytes))
+    {
+        auto oldest = m_entries.begin();
+        for (auto it = oldest; it != m_entries.end(); ++it)
+        {
+            if (it->second->used_tick < oldest->second->used_tick)
+                oldest = it;
+        }
+
+        discard_session_stream(oldest->second->stream.c_str());
+        m_stats.cmdcache_bytes -= oldest->second->bytes;
+        m_entries.erase(oldest);
+        ++m_stats.cmdcache_evicted;
+    }
+}
+
+//------------------------------------------------------------------------------
+void command_cache::update_stats() const
+{
+    if (session_stats* shared = get_session_stats())
+    {
+        shared->cmdcache_entries = uint32(m_entries.size());
+        shared->cmdcache_bytes = m_stats.cmdcache_bytes;
+        shared->cmdcache_hits = m_stats.cmdcache_hits;
+        shared->cmdcache_misses = m_stats.cmdcache_misses;
+        shared->cmdcache_expired = m_stats.cmdcache_expired;
+        shared->cmdcache_invalidated = m_stats.cmdcache_invalidated;
+        shared->cmdcache_evicted = m_stats.cmdcache_evicted;
+    }
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/os.h>
+#include <core/str.h>
+#include <core/str_unordered_set.h>
+#include <core/session_stats.h>
+
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Cache of command output for io.popencached().  Each entry's output lives in
+// a session stream, so it survives Lua VM reboots and any coroutine can read
+// it.  An entry is reused until its TTL elapses or one of its dependency files
+// changes (including being created or deleted).  Hit rates are published in
+// session_stats for `clink info`.
+class command_cache
+{
+public:
+                    ~command_cache();
+    const char*     find(const char* key);
+    const char*     store(const char* key, const char* data, uint32 len, uint32 ttl_ms, const std::vector<str_moveable>& files);
+    void            clear();
+    void            get_stats(session_stats& stats) const;
+
+    static command_cache& get();
+
+    static const uint32 c_max_entries = 64;
+    static const uint32 c_max_bytes = 16 * 1024 * 1024;
+
+private:
+    struct file_stamp : public os::file_stamp
+    {
+        wstr_moveable   path;
+    };
+
+    struct entry
+    {
+        str_moveable    key;
+        str_moveable    stream;         // Name of the session stream.
+        uint64          stored_tick;
+        uint64          used_tick;
+        uint32          ttl_ms;         // 0 means no expiration.
+        uint32          bytes;
+        std::vector<file_stamp> files;
+    };
+
+    void            remove(const char* key);
+    void            evict(uint32 need_bytes);
+    void            update_stats() const;
+
+    str_unordered_map<std::unique_ptr<entry>> m_entries;
+    session_stats   m_stats = { sizeof(session_stats) };
+    uint32          m_next_id = 0;
+};
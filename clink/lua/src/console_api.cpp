@@ -1489,14 +1489,15 @@ static int32 use_direct_io(lua_State* state)
 }
 
 //------------------------------------------------------------------------------
-void console_lua_initialise(lua_state& lua, bool lua_interpreter)
-{
-    struct method_def {
-        const char* name;
-        int32       (*method)(lua_State*);
-    };
+struct console_method_def {
+    const char* name;
+    int32       (*method)(lua_State*);
+};
 
-    static const method_def methods[] = {
+//------------------------------------------------------------------------------
+static int32 open_console(lua_State* state)
+{
+    static const console_method_def methods[] = {
         { "scroll",                 &scroll },
         { "cellcount",              &get_cell_count },
         { "plaintext",              &get_plain_text },
@@ -1524,8 +1525,6 @@ void console_lua_initialise(lua_state& lua, bool lua_interpreter)
         { "__set_width",            &set_width },
     };
 
-    lua_State* state = lua.get_state();
-
     lua_createtable(state, 0, sizeof_array(methods));
 
     for (const auto& method : methods)
@@ -1535,9 +1534,25 @@ void console_lua_initialise(lua_state& lua, bool lua_interpreter)
         lua_rawset(state, -3);
     }
 
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+void console_lua_initialise(lua_state& lua, bool lua_interpreter, bool deferred)
+{
+    lua_State* state = lua.get_state();
+
+    if (deferred && !lua_interpreter)
+    {
+        lua_state::register_lazy_module(state, "console", &open_console);
+        return;
+    }
+
+    open_console(state);
+
     if (lua_interpreter)
     {
-        static const method_def methods_standalone[] = {
+        static const console_method_def methods_standalone[] = {
             { "usedirectio",        &use_direct_io },
         };
 
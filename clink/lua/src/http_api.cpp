@@ -393,6 +393,7 @@ public:
 
 protected:
     void do_work() override;
+    bool is_blocking() const override { return true; }
 
 private:
     const str_moveable m_method;
@@ -810,7 +811,7 @@ static int32 http_request(lua_State* state)
 
 
 //------------------------------------------------------------------------------
-void http_lua_initialise(lua_state& lua)
+static int32 open_http(lua_State* state)
 {
     static const struct {
         const char* name;
@@ -819,8 +820,6 @@ void http_lua_initialise(lua_state& lua)
         { "request",                &http_request },
     };
 
-    lua_State* state = lua.get_state();
-
     lua_createtable(state, 0, sizeof_array(methods));
 
     for (const auto& method : methods)
@@ -830,5 +829,20 @@ void http_lua_initialise(lua_state& lua)
         lua_rawset(state, -3);
     }
 
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+void http_lua_initialise(lua_state& lua, bool deferred)
+{
+    lua_State* state = lua.get_state();
+
+    if (deferred)
+    {
+        lua_state::register_lazy_module(state, "http", &open_http);
+        return;
+    }
+
+    open_http(state);
     lua_setglobal(state, "http");
 }
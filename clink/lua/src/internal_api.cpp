@@ -9,12 +9,16 @@
 #include "prompt.h"
 #include "async_lua_task.h"
 #include "command_link_dialog.h"
+#include "lua_bytecode_cache.h"
 #include "sessionstream.h"
+#include "command_cache.h"
 #include "../../app/src/version.h" // Ugh.
 
 #include <core/base.h>
 #include <core/os.h>
 #include <core/cwd_restorer.h>
+#include <core/git_repo.h>
+#include <core/git_status.h>
 #include <core/str_compare.h>
 #include <core/str_transform.h>
 #include <core/str_unordered_set.h>
@@ -22,6 +26,7 @@
 #include <core/linear_allocator.h>
 #include <core/callstack.h>
 #include <core/debugheap.h>
+#include <core/trace.h>
 #include <lib/popup.h>
 #include <lib/cmd_tokenisers.h>
 #include <lib/reclassify.h>
@@ -47,6 +52,7 @@ extern "C" {
 #include <readline/history.h>
 }
 
+#include <io.h>
 #include <share.h>
 #include <mutex>
 
@@ -70,6 +76,7 @@ static const char c_uninstall_key[] = "SOFTWARE\\Microsoft\\Windows\\CurrentVers
 extern int32 api_glob_dirs(lua_State* state);
 extern int32 api_glob_files(lua_State* state);
 extern int32 globber_impl(lua_State* state, bool dirs_only, bool back_compat=false);
+extern int32 async_globber_impl(lua_State* state, bool dirs_only);
 
 //------------------------------------------------------------------------------
 #pragma region Updater Helpers
@@ -1290,13 +1297,16 @@ static int32 recognize_command(lua_State* state)
     const char* line = checkstring(state, 1);
     const char* word = checkstring(state, 2);
     const bool quoted = lua_toboolean(state, 3);
+    const auto _priority = optinteger(state, 4, 0);
     if (!line || !word)
         return 0;
     if (!*line || !*word)
         return 0;
 
+    const uint32 priority = (_priority.isnum() && _priority.get() > 0) ? uint32(_priority.get()) : 0;
+
     bool ready;
-    const recognition recognized = recognize_command(line, word, quoted, ready, nullptr/*file*/);
+    const recognition recognized = recognize_command(line, word, quoted, ready, nullptr/*file*/, priority);
     lua_pushinteger(state, int32(recognized));
     return 1;
 }
@@ -1537,6 +1547,340 @@ static int32 get_scripts_path(lua_State* state)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+static int32 loadfile_cached(lua_State* state)
+{
+    const char* path = checkstring(state, 1);
+    if (!path)
+        return 0;
+
+    if (load_file_cached(state, path) == LUA_OK)
+        return 1;
+
+    lua_pushnil(state);
+    lua_insert(state, -2);
+    return 2;
+}
+
+//------------------------------------------------------------------------------
+// Returns a string that changes whenever the size or last write time of the
+// file changes, or nil if the file doesn't exist.
+static int32 get_file_stamp(lua_State* state)
+{
+    const char* path = checkstring(state, 1);
+    if (!path)
+        return 0;
+
+    wstr<280> wpath(path);
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(wpath.c_str(), GetFileExInfoStandard, &fad))
+        return 0;
+
+    str<64> stamp;
+    stamp.format("%x:%x%08x:%x%08x", fad.dwFileAttributes,
+                 fad.nFileSizeHigh, fad.nFileSizeLow,
+                 fad.ftLastWriteTime.dwHighDateTime, fad.ftLastWriteTime.dwLowDateTime);
+    lua_pushlstring(state, stamp.c_str(), stamp.length());
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static void set_field(lua_State* state, const char* name, const str_base& value)
+{
+    if (value.empty())
+        return;
+    lua_pushlstring(state, value.c_str(), value.length());
+    lua_setfield(state, -2, name);
+}
+
+//------------------------------------------------------------------------------
+static void set_field(lua_State* state, const char* name, uint32 value)
+{
+    if (!value)
+        return;
+    lua_pushinteger(state, value);
+    lua_setfield(state, -2, name);
+}
+
+//------------------------------------------------------------------------------
+static int32 get_git_state(lua_State* state)
+{
+    const char* git_dir = checkstring(state, 1);
+    if (!git_dir)
+        return 0;
+
+    const auto repo = git_repo_cache::get().get_state(git_dir);
+    if (!repo)
+        return 0;
+
+    lua_createtable(state, 0, 12);
+
+    set_field(state, "branch", repo->branch);
+    set_field(state, "HEAD", repo->head);
+    set_field(state, "upstream", repo->upstream);
+    set_field(state, "upstream_head", repo->upstream_head);
+    set_field(state, "action", repo->action);
+    set_field(state, "step", repo->step);
+    set_field(state, "total", repo->total);
+
+    lua_pushinteger(state, repo->stashes);
+    lua_setfield(state, -2, "stashes");
+
+    if (repo->detached)
+    {
+        lua_pushboolean(state, true);
+        lua_setfield(state, -2, "detached");
+    }
+
+    if (repo->reftable)
+    {
+        lua_pushboolean(state, true);
+        lua_setfield(state, -2, "reftable");
+    }
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// This is separate from get_git_state because it reads the whole index.
+static int32 get_git_conflicts(lua_State* state)
+{
+    const char* git_dir = checkstring(state, 1);
+    if (!git_dir)
+        return 0;
+
+    const int32 conflicts = git_repo_cache::get().get_conflicts(git_dir);
+    if (conflicts < 0)
+        return 0;
+
+    lua_pushinteger(state, conflicts);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+class git_status_lua
+    : public lua_bindable<git_status_lua>
+{
+public:
+                        git_status_lua() = default;
+                        ~git_status_lua() = default;
+
+protected:
+    int32               read(lua_State* state);
+    int32               get_counts(lua_State* state);
+
+private:
+    git_status_parser   m_parser;
+    bool                m_done = false;
+
+    friend class lua_bindable<git_status_lua>;
+    static const char* const c_name;
+    static const method c_methods[];
+};
+
+//------------------------------------------------------------------------------
+const char* const git_status_lua::c_name = "git_status_lua";
+const git_status_lua::method git_status_lua::c_methods[] = {
+    { "read",                   &read },
+    { "getcounts",              &get_counts },
+    {}
+};
+
+//------------------------------------------------------------------------------
+// Arg is a file opened for reading, which must not have been read from yet,
+// and an optional time slice in seconds.  Reads and parses the output in large
+// chunks straight from the file's handle, without making Lua strings.  Returns
+// true when the end of the file is reached, or false when the time slice has
+// elapsed first (so a coroutine can yield and then read more).
+int32 git_status_lua::read(lua_State* state)
+{
+    luaL_Stream* p = (luaL_Stream*)luaL_checkudata(state, LUA_SELF + 1, LUA_FILEHANDLE);
+    if (!p || !p->closef)
+        return luaL_argerror(state, LUA_SELF + 1, "attempt to use a closed file");
+    const double slice = optnumber(state, LUA_SELF + 2, 0);
+
+    if (!m_done)
+    {
+        HANDLE h = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(p->f)));
+        if (h == INVALID_HANDLE_VALUE)
+            return luaL_fileresult(state, false, nullptr);
+
+        const double start = os::clock();
+        char buffer[64 * 1024];
+        while (true)
+        {
+            // A pipe returns whatever output is available, up to the buffer
+            // size.  The end is reached when the pipe is broken or when a
+            // file has no more data.
+            DWORD bytes = 0;
+            if (!ReadFile(h, buffer, sizeof(buffer), &bytes, nullptr) || !bytes)
+            {
+                m_parser.finish();
+                m_done = true;
+                break;
+            }
+
+            m_parser.feed(buffer, bytes);
+
+            if (slice > 0 && os::clock() - start > slice)
+                break;
+        }
+    }
+
+    lua_pushboolean(state, m_done);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static void set_count(lua_State* state, const char* name, uint32 value)
+{
+    lua_pushinteger(state, value);
+    lua_setfield(state, -2, name);
+}
+
+//------------------------------------------------------------------------------
+int32 git_status_lua::get_counts(lua_State* state)
+{
+    const git_status_counts& counts = m_parser.get_counts();
+
+    lua_createtable(state, 0, 24);
+
+    if (counts.has_header)
+    {
+        lua_pushboolean(state, true);
+        lua_setfield(state, -2, "hasheader");
+    }
+
+    set_field(state, "oid", counts.oid);
+    set_field(state, "head", counts.head);
+    set_field(state, "upstream", counts.upstream);
+
+    set_count(state, "ahead", counts.ahead);
+    set_count(state, "behind", counts.behind);
+    set_count(state, "w_add", counts.w_add);
+    set_count(state, "w_modify", counts.w_modify);
+    set_count(state, "w_delete", counts.w_delete);
+    set_count(state, "w_conflict", counts.w_conflict);
+    set_count(state, "w_untracked", counts.w_untracked);
+    set_count(state, "s_add", counts.s_add);
+    set_count(state, "s_modify", counts.s_modify);
+    set_count(state, "s_delete", counts.s_delete);
+    set_count(state, "s_rename", counts.s_rename);
+    set_count(state, "t_add", counts.t_add);
+    set_count(state, "t_modify", counts.t_modify);
+    set_count(state, "t_delete", counts.t_delete);
+    set_count(state, "onlystaged", counts.only_staged);
+    set_count(state, "lines", counts.lines);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static int32 make_git_status_parser(lua_State* state)
+{
+    return git_status_lua::make_new(state) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// Opens the cached output for key as a session stream, or returns nil if
+// there's no current entry.
+static int32 cmdcache_open(lua_State* state)
+{
+    const char* key = checkstring(state, 1);
+    const bool binary = lua_toboolean(state, 2);
+    if (!key)
+        return 0;
+
+    const char* name = command_cache::get().find(key);
+    if (!name)
+        return 0;
+
+    auto flags = luaL_SessionStream::OpenFlags::READ;
+    if (binary)
+        flags |= luaL_SessionStream::OpenFlags::BINARY;
+    return luaL_SessionStream::make_new(state, name, flags, false/*clear*/) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// Stores output for key.  The optional ttl is in seconds, and the optional
+// files table lists files whose changes invalidate the output.
+static int32 cmdcache_store(lua_State* state)
+{
+    const char* key = checkstring(state, 1);
+    size_t len = 0;
+    const char* data = luaL_checklstring(state, 2, &len);
+    const auto ttl = optnumber(state, 3, 0);
+    if (!key || !ttl.isnum())
+        return 0;
+
+    std::vector<str_moveable> files;
+    if (lua_istable(state, 4))
+    {
+        const int32 num = int32(lua_rawlen(state, 4));
+        for (int32 i = 1; i <= num; ++i)
+        {
+            lua_rawgeti(state, 4, i);
+            if (const char* file = lua_tostring(state, -1))
+            {
+                str_moveable full;
+                if (!os::get_full_path_name(file, full))
+                    full = file;
+                files.emplace_back(std::move(full));
+            }
+            lua_pop(state, 1);
+        }
+    }
+
+    const uint32 ttl_ms = (ttl > 0) ? uint32(min<lua_Number>(ttl.get() * 1000, 0xffffffff)) : 0;
+    const bool stored = !!command_cache::get().store(key, data, uint32(min<size_t>(len, 0xffffffff)), ttl_ms, files);
+    lua_pushboolean(state, stored);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static int32 cmdcache_stats(lua_State* state)
+{
+    session_stats stats;
+    command_cache::get().get_stats(stats);
+
+    lua_createtable(state, 0, 8);
+    set_count(state, "entries", stats.cmdcache_entries);
+    set_count(state, "bytes", stats.cmdcache_bytes);
+    set_count(state, "hits", stats.cmdcache_hits);
+    set_count(state, "misses", stats.cmdcache_misses);
+    set_count(state, "expired", stats.cmdcache_expired);
+    set_count(state, "invalidated", stats.cmdcache_invalidated);
+    set_count(state, "evicted", stats.cmdcache_evicted);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static int32 cmdcache_clear(lua_State* state)
+{
+    command_cache::get().clear();
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static int32 trace_enabled(lua_State* state)
+{
+    lua_pushboolean(state, trace::is_enabled());
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// Records a span that began at os.clock() time `begin` and ends now.
+static int32 trace_record(lua_State* state)
+{
+    const char* name = checkstring(state, 1);
+    const auto begin = checknumber(state, 2);
+    if (!name || !begin.isnum())
+        return 0;
+
+    if (trace::is_enabled())
+        trace::record(trace::intern(name), begin, os::clock());
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 static int32 is_break_on_error(lua_State* state)
 {
@@ -1559,6 +1903,18 @@ int32 make_file_globber(lua_State* state)
     return globber_impl(state, false);
 }
 
+//------------------------------------------------------------------------------
+int32 make_async_dir_globber(lua_State* state)
+{
+    return async_globber_impl(state, true);
+}
+
+//------------------------------------------------------------------------------
+int32 make_async_file_globber(lua_State* state)
+{
+    return async_globber_impl(state, false);
+}
+
 //------------------------------------------------------------------------------
 int32 has_file_association(lua_State* state)
 {
@@ -1673,6 +2029,17 @@ void internal_lua_initialise(lua_state& lua, bool lua_interpreter)
         { 0,    "_expand_prompt_codes",     &expand_prompt_codes },
         { 0,    "_make_ftsc",               &_make_ftsc },
         { 0,    "_get_scripts_path",        &get_scripts_path },
+        { 0,    "_loadfile",                &loadfile_cached },
+        { 0,    "_get_file_stamp",          &get_file_stamp },
+        { 1,    "_get_git_state",           &get_git_state },
+        { 1,    "_get_git_conflicts",       &get_git_conflicts },
+        { 1,    "_make_git_status_parser",  &make_git_status_parser },
+        { 1,    "_cmdcache_open",           &cmdcache_open },
+        { 1,    "_cmdcache_store",          &cmdcache_store },
+        { 1,    "_cmdcache_stats",          &cmdcache_stats },
+        { 1,    "_cmdcache_clear",          &cmdcache_clear },
+        { 1,    "_trace_enabled",           &trace_enabled },
+        { 1,    "_trace_record",            &trace_record },
         { 1,    "_is_break_on_error",       &is_break_on_error },
 
         // Formerly from the "os." namespace ---------------------------------
@@ -1681,6 +2048,8 @@ void internal_lua_initialise(lua_state& lua, bool lua_interpreter)
         { 1,    "_globfiles",               &api_glob_files }, // Public os.globfiles method is in core.lua.
         { 1,    "_makedirglobber",          &make_dir_globber },
         { 1,    "_makefileglobber",         &make_file_globber },
+        { 1,    "_makeasyncdirglobber",     &make_async_dir_globber },
+        { 1,    "_makeasyncfileglobber",    &make_async_file_globber },
         { 1,    "_hasfileassociation",      &has_file_association },
         { 1,    "_win_verify_trust",        &win_verify_trust },
         { 1,    "_verify_from_catalog",     &verify_from_catalog },
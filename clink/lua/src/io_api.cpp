@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "lua_state.h"
+#include "lua_bindable.h"
 #include "yield.h"
 #include "sessionstream.h"
 
@@ -19,8 +20,15 @@
 #include <share.h>
 #include <list>
 #include <memory>
+#include <vector>
 #include <assert.h>
 
+//------------------------------------------------------------------------------
+// Output from commands is read in large chunks; generators can read megabytes
+// of output per completion.  This is used for both the stdout pipe's buffer
+// (previously 1KB) and the drain thread's buffer (previously 4KB).
+static const uint32 c_chunk_size = 64 * 1024;
+
 //------------------------------------------------------------------------------
 struct popenrw_info;
 static popenrw_info* s_head = nullptr;
@@ -173,14 +181,14 @@ struct pipe_pair
         if (local)  fclose(local);
     }
 
-    bool init(bool write, bool binary)
+    bool init(bool write, bool binary, uint32 size=1024)
     {
         int32 handles[2] = { -1, -1 };
         int32 index_local = write ? 1 : 0;
         int32 index_remote = 1 - index_local;
 
         int32 pipe_mode = _O_NOINHERIT | (binary ? _O_BINARY : _O_TEXT);
-        if (_pipe(handles, 1024, pipe_mode) != -1)
+        if (_pipe(handles, size, pipe_mode) != -1)
         {
             static const wchar_t* const c_mode[2][2] =
             {
@@ -229,6 +237,7 @@ struct popen_buffering : public yield_thread
     popen_buffering(FILE* r, HANDLE w)
     : m_read(r)
     , m_write(w)
+    , m_buffer(c_chunk_size)
     {
         assert(r != nullptr);
         assert(w != nullptr);
@@ -287,14 +296,16 @@ private:
         HANDLE rh = reinterpret_cast<HANDLE>(_get_osfhandle(fileno(m_read)));
         HANDLE wh = m_write;
 
+        // The pipe's buffer provides backpressure:  the command blocks when
+        // it's full, and each read drains up to a whole chunk at once.
         while (!is_canceled())
         {
             DWORD len;
-            if (!ReadFile(rh, m_buffer, sizeof_array(m_buffer), &len, nullptr))
+            if (!ReadFile(rh, m_buffer.data(), DWORD(m_buffer.size()), &len, nullptr))
                 break;
 
             DWORD written;
-            if (!WriteFile(wh, m_buffer, len, &written, nullptr))
+            if (!WriteFile(wh, m_buffer.data(), len, &written, nullptr))
                 break;
             if (written != len)
                 break;
@@ -329,7 +340,7 @@ private:
     errno_t         m_errno = 0;
     volatile long   m_need_completion = false;
 
-    BYTE            m_buffer[4096];
+    std::vector<BYTE> m_buffer;
 };
 
 
@@ -495,7 +506,7 @@ private:
         // Must provide pipe_stdin to the spawned process, or some processes may
         // error out due to missing stdin handle (e.g. FC and XCOPY).
         if (!pipe_stdin.init(true/*write*/, true/*binary*/) ||
-            !pipe_stdout.init(false/*write*/, true/*binary*/))
+            !pipe_stdout.init(false/*write*/, true/*binary*/, c_chunk_size))
             break;
 
         buffering = std::make_shared<popen_buffering>(pipe_stdout.local, temp_write);
@@ -535,6 +546,8 @@ private:
         if (temp_write)
             CloseHandle(temp_write);
         delete info;
+        if (failed && buffering)
+            buffering->cancel(); // Releases the pending work's strong ref.
         buffering = nullptr;
 
         if (failed)
@@ -546,6 +559,230 @@ private:
     return (failed) ? luaL_fileresult(state, 0, command) : 2;
 }
 
+//------------------------------------------------------------------------------
+class line_reader
+    : public lua_bindable<line_reader>
+{
+public:
+                        line_reader(lua_State* state, int32 file_index, uint32 chunk_size);
+                        ~line_reader();
+
+protected:
+    int32               lines(lua_State* state);
+    int32               read(lua_State* state);
+
+private:
+    static int32        lines_iter(lua_State* state);
+    FILE*               get_file(lua_State* state) const;
+    bool                fill(lua_State* state);
+    bool                push_line(lua_State* state);
+
+    lua_State*          m_state;
+    int32               m_file_ref;
+    std::vector<char>   m_buffer;
+    uint32              m_start = 0;        // Start of unread data.
+    uint32              m_end = 0;          // End of unread data.
+    uint32              m_scan = 0;         // Where to resume looking for a newline.
+    bool                m_eof = false;
+
+    friend class lua_bindable<line_reader>;
+    static const char* const c_name;
+    static const method c_methods[];
+};
+
+//------------------------------------------------------------------------------
+const char* const line_reader::c_name = "line_reader";
+const line_reader::method line_reader::c_methods[] = {
+    { "lines",                  &lines },
+    { "read",                   &read },
+    {}
+};
+
+//------------------------------------------------------------------------------
+line_reader::line_reader(lua_State* state, int32 file_index, uint32 chunk_size)
+: m_buffer(chunk_size)
+{
+    // The reader may outlive the coroutine that created it, so the ref is
+    // released through the main thread.
+    lua_rawgeti(state, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+    m_state = lua_tothread(state, -1);
+    lua_pop(state, 1);
+
+    // Keep the file alive as long as the reader.
+    lua_pushvalue(state, file_index);
+    m_file_ref = luaL_ref(state, LUA_REGISTRYINDEX);
+}
+
+//------------------------------------------------------------------------------
+line_reader::~line_reader()
+{
+    luaL_unref(m_state, LUA_REGISTRYINDEX, m_file_ref);
+}
+
+//------------------------------------------------------------------------------
+FILE* line_reader::get_file(lua_State* state) const
+{
+    lua_rawgeti(state, LUA_REGISTRYINDEX, m_file_ref);
+    luaL_Stream* p = (luaL_Stream*)luaL_testudata(state, -1, LUA_FILEHANDLE);
+    lua_pop(state, 1);
+    return (p && p->closef) ? p->f : nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Reads another chunk into the buffer.  Unread data is moved to the front of
+// the buffer first, so the buffer is reused as a ring rather than reallocated;
+// it only grows when a single line is longer than the whole buffer.  Returns
+// false at the end of the file.
+bool line_reader::fill(lua_State* state)
+{
+    if (m_eof)
+        return false;
+
+    FILE* file = get_file(state);
+    if (!file)
+    {
+        m_eof = true;
+        return false;
+    }
+
+    if (m_start)
+    {
+        const uint32 len = m_end - m_start;
+        memmove(m_buffer.data(), m_buffer.data() + m_start, len);
+        m_scan -= m_start;
+        m_end = len;
+        m_start = 0;
+    }
+
+    if (m_end == m_buffer.size())
+        m_buffer.resize(m_buffer.size() * 2);
+
+    const size_t bytes = fread(m_buffer.data() + m_end, 1, m_buffer.size() - m_end, file);
+    m_end += uint32(bytes);
+    if (!bytes)
+        m_eof = true;
+    return bytes > 0;
+}
+
+//------------------------------------------------------------------------------
+// Pushes the next line (without its newline), or returns false at the end of
+// the file.  Like file:lines(), a final line without a newline is returned,
+// and a carriage return is only removed when the file is in text mode.
+bool line_reader::push_line(lua_State* state)
+{
+    while (true)
+    {
+        const char* const base = m_buffer.data();
+        const char* eol = static_cast<const char*>(memchr(base + m_scan, '\n', m_end - m_scan));
+        if (eol)
+        {
+            lua_pushlstring(state, base + m_start, eol - (base + m_start));
+            m_start = m_scan = uint32(eol - base) + 1;
+            return true;
+        }
+
+        m_scan = m_end;
+        if (!fill(state))
+        {
+            if (m_start == m_end)
+                return false;
+            lua_pushlstring(state, m_buffer.data() + m_start, m_end - m_start);
+            m_start = m_scan = m_end;
+            return true;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+int32 line_reader::lines_iter(lua_State* state)
+{
+    line_reader* reader = line_reader::check(state, lua_upvalueindex(1));
+    if (!reader || !reader->push_line(state))
+        return 0;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  line_reader:lines
+/// -ver:   1.9.33
+/// -ret:   iterator
+/// Returns an iterator function that, each time it is called, returns the next
+/// line from the file (without its newline), or nil at the end of the file.
+/// This is like <code>file:lines()</code>, but reads the file in large chunks
+/// and splits the lines inside the reader's buffer.
+/// -show:  local file = io.popen("dir /s /b")
+/// -show:  for line in io.linereader(file):lines() do
+/// -show:  &nbsp;   print(line)
+/// -show:  end
+/// -show:  file:close()
+int32 line_reader::lines(lua_State* state)
+{
+    lua_pushvalue(state, LUA_SELF);
+    lua_pushcclosure(state, &lines_iter, 1);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  line_reader:read
+/// -ver:   1.9.33
+/// -arg:   [max:integer]
+/// -ret:   string | nil
+/// Returns the next chunk of data from the file, up to
+/// <span class="arg">max</span> bytes, or nil at the end of the file.  When
+/// <span class="arg">max</span> is omitted, it returns up to the reader's
+/// chunk size.  Chunks are not split at line boundaries.
+int32 line_reader::read(lua_State* state)
+{
+    const auto _limit = optinteger(state, LUA_SELF + 1, 0);
+    if (!_limit.isnum())
+        return 0;
+    const uint32 limit = (_limit > 0) ? uint32(_limit.get()) : uint32(m_buffer.size());
+
+    if (m_start == m_end && !fill(state))
+        return 0;
+
+    const uint32 len = min(limit, m_end - m_start);
+    lua_pushlstring(state, m_buffer.data() + m_start, len);
+    m_start += len;
+    if (m_scan < m_start)
+        m_scan = m_start;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  io.linereader
+/// -ver:   1.9.33
+/// -arg:   file:file
+/// -arg:   [chunk_size:integer]
+/// -ret:   line_reader
+/// Returns a reader object for reading <span class="arg">file</span> in large
+/// chunks.  This is useful for reading a lot of output from a command, for
+/// example in a match generator that runs <code>npm ls</code> or
+/// <code>dir /s /b</code>.
+///
+/// The optional <span class="arg">chunk_size</span> is how many bytes to read
+/// at a time (the default is 65536).
+///
+/// The reader keeps a reference to the file.  Closing the file ends the
+/// reader.  Avoid mixing reads from the reader and from the file, since the
+/// reader buffers data that it has read from the file.
+/// -show:  local file = io.popen("npm ls --parseable")
+/// -show:  local reader = io.linereader(file)
+/// -show:  for line in reader:lines() do
+/// -show:  &nbsp;   add_package(line)
+/// -show:  end
+/// -show:  file:close()
+static int32 io_linereader(lua_State* state)
+{
+    luaL_checkudata(state, 1, LUA_FILEHANDLE);
+    const auto chunk_size = optinteger(state, 2, c_chunk_size);
+    if (!chunk_size.isnum())
+        return 0;
+
+    const uint32 size = uint32(max<int32>(chunk_size.get(), 256));
+    return line_reader::make_new(state, state, 1, size) ? 1 : 0;
+}
+
 //------------------------------------------------------------------------------
 /// -name:  io.open
 /// -ver:   0.0.1
@@ -717,6 +954,7 @@ void io_lua_initialise(lua_state& lua)
         int32       (*method)(lua_State*);
     } methods[] = {
         { "popenrw",                    &io_popenrw },
+        { "linereader",                 &io_linereader },
         { "popenyield_internal",        &io_popenyield },
         { "sopen",                      &io_sopen },
         { "truncate",                   &io_truncate },
@@ -0,0 +1,319 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_state.h"
+#include "lua_bytecode_cache.h"
+
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <core/str_hash.h>
+#include <core/str_transform.h>
+#include <core/settings.h>
+#include <core/log.h>
+#include <lib/host_callbacks.h>
+#include <terminal/printer.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+static setting_bool g_lua_bytecode_cache(
+    "lua.bytecode_cache",
+    "Cache compiled Lua scripts",
+    "When enabled, Lua scripts loaded from the script paths and completions\n"
+    "directories are compiled once and cached in a 'luacache' subdirectory in\n"
+    "the profile directory.  This speeds up starting new sessions and reloading\n"
+    "Lua.  A cached script is recompiled whenever the size or last write time of\n"
+    "its source file changes.  It's safe to delete the cache directory.",
+    true);
+
+
+
+//------------------------------------------------------------------------------
+static const char c_cache_magic[4] = { 'C', 'L', 'B', 'C' };
+static const uint32 c_cache_format = 1;
+static const uint64 c_max_cache_file_size = 16 * 1024 * 1024;
+
+//------------------------------------------------------------------------------
+struct bytecode_header
+{
+    char            magic[4];
+    uint32          format;
+    uint32          lua_version;
+    uint32          pointer_size;
+    uint64          source_size;
+    uint64          source_time;
+    uint32          compile_usec;   // How long the source took to compile.
+    uint32          path_len;       // Followed by the lowercase full path.
+    uint32          bytecode_len;   // Followed by the compiled chunk.
+};
+
+//------------------------------------------------------------------------------
+struct source_stamp
+{
+    uint64          size = 0;
+    uint64          time = 0;
+};
+
+//------------------------------------------------------------------------------
+static bytecode_cache_stats s_stats;
+
+
+
+//------------------------------------------------------------------------------
+static bool get_source_stamp(const char* path, source_stamp& stamp)
+{
+    wstr<280> wpath(path);
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(wpath.c_str(), GetFileExInfoStandard, &fad))
+        return false;
+    if (fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        return false;
+
+    stamp.size = (uint64(fad.nFileSizeHigh) << 32) | fad.nFileSizeLow;
+    stamp.time = (uint64(fad.ftLastWriteTime.dwHighDateTime) << 32) | fad.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static bool read_cache_file(const char* cache_file, std::vector<char>& data)
+{
+    wstr<280> wfile(cache_file);
+    HANDLE h = CreateFileW(wfile.c_str(), GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool ok = false;
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(h, &size) &&
+        uint64(size.QuadPart) >= sizeof(bytecode_header) &&
+        uint64(size.QuadPart) <= c_max_cache_file_size)
+    {
+        DWORD read = 0;
+        data.resize(size_t(size.QuadPart));
+        ok = (ReadFile(h, data.data(), DWORD(data.size()), &read, nullptr) && read == data.size());
+    }
+
+    CloseHandle(h);
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+static const char* validate_cache_data(const std::vector<char>& data, const char* key, const source_stamp& stamp, uint32& len, uint32& compile_usec)
+{
+    bytecode_header header;
+    if (data.size() < sizeof(header))
+        return nullptr;
+
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, c_cache_magic, sizeof(header.magic)) != 0 ||
+        header.format != c_cache_format ||
+        header.lua_version != LUA_VERSION_NUM ||
+        header.pointer_size != sizeof(void*) ||
+        header.source_size != stamp.size ||
+        header.source_time != stamp.time)
+        return nullptr;
+
+    const size_t expected = sizeof(header) + size_t(header.path_len) + size_t(header.bytecode_len);
+    if (data.size() != expected)
+        return nullptr;
+
+    // Guard against hash collisions between different paths.
+    const char* cached_key = data.data() + sizeof(header);
+    if (header.path_len != strlen(key) || memcmp(cached_key, key, header.path_len) != 0)
+        return nullptr;
+
+    len = header.bytecode_len;
+    compile_usec = header.compile_usec;
+    return cached_key + header.path_len;
+}
+
+//------------------------------------------------------------------------------
+static int32 dump_writer(lua_State* state, const void* p, size_t size, void* ud)
+{
+    auto* out = static_cast<std::vector<char>*>(ud);
+    const char* bytes = static_cast<const char*>(p);
+    out->insert(out->end(), bytes, bytes + size);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static bool write_cache_file(lua_State* state, const char* cache_dir, const char* cache_file, const char* key, const source_stamp& stamp, double compile_time)
+{
+    // Dump the compiled chunk on top of the stack (it remains on the stack).
+    std::vector<char> data;
+    data.resize(sizeof(bytecode_header));
+    data.insert(data.end(), key, key + strlen(key));
+    const size_t bytecode_offset = data.size();
+    if (lua_dump(state, dump_writer, &data) != 0)
+        return false;
+
+    bytecode_header header = {};
+    memcpy(header.magic, c_cache_magic, sizeof(header.magic));
+    header.format = c_cache_format;
+    header.lua_version = LUA_VERSION_NUM;
+    header.pointer_size = sizeof(void*);
+    header.source_size = stamp.size;
+    header.source_time = stamp.time;
+    header.compile_usec = uint32(compile_time * 1000000);
+    header.path_len = uint32(bytecode_offset - sizeof(header));
+    header.bytecode_len = uint32(data.size() - bytecode_offset);
+    memcpy(data.data(), &header, sizeof(header));
+
+    if (!os::make_dir(cache_dir))
+        return false;
+
+    // Write to a temporary file and then rename it, so that concurrent
+    // sessions never observe a partially written cache file.
+    str<280> tmp;
+    tmp.format("%s.%x.tmp", cache_file, GetCurrentProcessId());
+
+    wstr<280> wtmp(tmp.c_str());
+    HANDLE h = CreateFileW(wtmp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    DWORD written = 0;
+    const bool ok = (WriteFile(h, data.data(), DWORD(data.size()), &written, nullptr) && written == data.size());
+    CloseHandle(h);
+
+    wstr<280> wfile(cache_file);
+    if (!ok || !MoveFileExW(wtmp.c_str(), wfile.c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFileW(wtmp.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+
+
+//------------------------------------------------------------------------------
+bool get_bytecode_cache_dir(str_base& out)
+{
+    out.clear();
+
+    if (lua_state::is_interpreter() || !g_lua_bytecode_cache.get())
+        return false;
+
+    int32 id = 0;
+    host_context context;
+    host_get_app_context(id, context);
+    if (context.profile.empty())
+        return false;
+
+    out = context.profile.c_str();
+    path::append(out, "luacache");
+    return true;
+}
+
+//------------------------------------------------------------------------------
+int32 load_file_cached(lua_State* L, const char* path)
+{
+    str<280> cache_dir;
+    if (!get_bytecode_cache_dir(cache_dir))
+        return luaL_loadfile(L, path);
+
+    os::high_resolution_clock clock;
+
+    str<280> full;
+    source_stamp stamp;
+    if (!os::get_full_path_name(path, full) || !get_source_stamp(full.c_str(), stamp))
+        return luaL_loadfile(L, path);  // Let Lua report the error.
+
+    str<280> key;
+    str_transform(full.c_str(), full.length(), key, transform_mode::lower);
+
+    str<32> name;
+    str<280> cache_file;
+    name.format("%08x_" AS_STR(ARCHITECTURE_NAME) ".luac", str_hash(key.c_str()));
+    path::join(cache_dir.c_str(), name.c_str(), cache_file);
+
+    // Same chunk name luaL_loadfile uses, so error messages and the loaded
+    // scripts list are identical whether or not the cache is used.
+    str<280> chunkname;
+    chunkname << "@" << path;
+
+    std::vector<char> data;
+    if (read_cache_file(cache_file.c_str(), data))
+    {
+        uint32 len;
+        uint32 compile_usec;
+        const char* bytecode = validate_cache_data(data, key.c_str(), stamp, len, compile_usec);
+        if (bytecode)
+        {
+            if (luaL_loadbufferx(L, bytecode, len, chunkname.c_str(), "b") == LUA_OK)
+            {
+                const double elapsed = clock.elapsed();
+                const double compile_time = double(compile_usec) / 1000000;
+                ++s_stats.hits;
+                s_stats.load_time += elapsed;
+                if (compile_time > elapsed)
+                    s_stats.saved_time += compile_time - elapsed;
+                return LUA_OK;
+            }
+
+            // The cached chunk is unusable; discard the error and recompile.
+            lua_pop(L, 1);
+            ++s_stats.failures;
+        }
+    }
+
+    os::high_resolution_clock compile_clock;
+    const int32 err = luaL_loadfile(L, path);
+    const double compile_time = compile_clock.elapsed();
+
+    ++s_stats.misses;
+    if (err == LUA_OK)
+    {
+        if (write_cache_file(L, cache_dir.c_str(), cache_file.c_str(), key.c_str(), stamp, compile_time))
+            ++s_stats.writes;
+        else
+            LOG("Unable to write Lua bytecode cache file '%s'.", cache_file.c_str());
+    }
+
+    s_stats.load_time += clock.elapsed();
+    return err;
+}
+
+//------------------------------------------------------------------------------
+void get_bytecode_cache_stats(bytecode_cache_stats& stats)
+{
+    stats = s_stats;
+}
+
+//------------------------------------------------------------------------------
+void bytecode_cache_diagnostics()
+{
+    if (!s_stats.hits && !s_stats.misses)
+        return;
+
+    static char bold[] = "\x1b[1m";
+    static char norm[] = "\x1b[m";
+
+    str<> s;
+    str<280> dir;
+    get_bytecode_cache_dir(dir);
+
+    s.format("%slua bytecode cache:%s\n", bold, norm);
+    g_printer->print(s.c_str(), s.length());
+
+    s.format("  %-16s  %s\n", "directory", dir.c_str());
+    g_printer->print(s.c_str(), s.length());
+    s.format("  %-16s  %u\n", "hits", s_stats.hits);
+    g_printer->print(s.c_str(), s.length());
+    s.format("  %-16s  %u (%u written)\n", "misses", s_stats.misses, s_stats.writes);
+    g_printer->print(s.c_str(), s.length());
+    if (s_stats.failures)
+    {
+        s.format("  %-16s  %u\n", "invalid", s_stats.failures);
+        g_printer->print(s.c_str(), s.length());
+    }
+    s.format("  %-16s  %u ms\n", "load time", unsigned(s_stats.load_time * 1000));
+    g_printer->print(s.c_str(), s.length());
+    s.format("  %-16s  %u ms\n", "time saved", unsigned(s_stats.saved_time * 1000));
+    g_printer->print(s.c_str(), s.length());
+}
@@ -0,0 +1,25 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+struct lua_State;
+class str_base;
+
+//------------------------------------------------------------------------------
+struct bytecode_cache_stats
+{
+    uint32          hits = 0;
+    uint32          misses = 0;
+    uint32          writes = 0;
+    uint32          failures = 0;
+    double          load_time = 0;      // Seconds spent loading scripts.
+    double          saved_time = 0;     // Estimated seconds saved by hits.
+};
+
+//------------------------------------------------------------------------------
+// Behaves like luaL_loadfile(), but uses a per-user cache of compiled chunks
+// keyed by the full path, size, and last write time of the script file.
+int32 load_file_cached(lua_State* L, const char* path);
+void get_bytecode_cache_stats(bytecode_cache_stats& stats);
+bool get_bytecode_cache_dir(str_base& out);
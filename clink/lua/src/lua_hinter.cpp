@@ -7,6 +7,7 @@
 #include <core/base.h>
 #include <core/cwd_restorer.h>
 #include <core/settings.h>
+#include <core/trace.h>
 #include <lib/line_state.h>
 #include <lib/display_readline.h>
 #include "lua_state.h"
@@ -110,6 +111,8 @@ lua_hinter::lua_hinter(lua_state& lua)
 //------------------------------------------------------------------------------
 void lua_hinter::get_hint(const line_state& line, input_hint& out)
 {
+    TRACE_SCOPE("get_hint");
+
     if (!line.get_length())
     {
 nohint:
@@ -14,6 +14,8 @@
 #include <core/str_unordered_set.h>
 #include <core/str_compare.h>
 #include <core/cwd_restorer.h>
+#include <core/session_stats.h>
+#include <core/trace.h>
 #include <lib/line_state.h>
 #include <lib/matches.h>
 #include <lib/matches_lookaside.h>
@@ -55,6 +57,9 @@ lua_match_generator::~lua_match_generator()
 //------------------------------------------------------------------------------
 bool lua_match_generator::generate(const line_states& lines, match_builder& builder, bool old_filtering)
 {
+    TRACE_SCOPE("generate");
+    LATENCY_SCOPE(generate);
+
     lua_State* state = get_state();
     save_stack_top ss(state);
 
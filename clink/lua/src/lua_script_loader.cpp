@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "lua_state.h"
+#include "lua_startup_profile.h"
 #include <core/embedded_scripts.h>
 
 #if defined(CLINK_USE_EMBEDDED_SCRIPTS)
@@ -13,7 +14,10 @@ void lua_load_script_impl(lua_state& state, const char* name, const char* script
     assert(!state.is_internal());
     state.set_internal(true);
 
-    state.do_string(script, length, nullptr, name);
+    {
+        lua_startup_timer timer(name);
+        state.do_string(script, length, nullptr, name);
+    }
 
     state.set_internal(false);
 }
@@ -26,7 +30,10 @@ void lua_load_script_impl(lua_state& state, const char* path, int32 length)
     assert(!state.is_internal());
     state.set_internal(true);
 
-    state.do_file(path);
+    {
+        lua_startup_timer timer(path);
+        state.do_file(path);
+    }
 
     state.set_internal(false);
 }
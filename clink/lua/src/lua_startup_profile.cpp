@@ -0,0 +1,103 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_startup_profile.h"
+
+#include <core/str.h>
+#include <core/log.h>
+#include <terminal/printer.h>
+
+#include <readline/readline.h>
+
+#include <algorithm>
+#include <vector>
+
+//------------------------------------------------------------------------------
+struct startup_timing
+{
+    str_moveable    name;
+    double          elapsed;
+};
+
+//------------------------------------------------------------------------------
+static std::vector<startup_timing> s_timings;
+static double s_total = 0;
+
+
+
+//------------------------------------------------------------------------------
+void clear_lua_startup_profile()
+{
+    s_timings.clear();
+    s_total = 0;
+}
+
+//------------------------------------------------------------------------------
+void add_lua_startup_timing(const char* name, double elapsed)
+{
+    startup_timing timing;
+    timing.name = name;
+    timing.elapsed = elapsed;
+    s_timings.emplace_back(std::move(timing));
+    s_total += elapsed;
+}
+
+//------------------------------------------------------------------------------
+double get_lua_startup_total()
+{
+    return s_total;
+}
+
+//------------------------------------------------------------------------------
+static void get_sorted_timings(std::vector<const startup_timing*>& sorted)
+{
+    sorted.clear();
+    sorted.reserve(s_timings.size());
+    for (const auto& timing : s_timings)
+        sorted.emplace_back(&timing);
+
+    std::stable_sort(sorted.begin(), sorted.end(), [](const startup_timing* a, const startup_timing* b) {
+        return a->elapsed > b->elapsed;
+    });
+}
+
+//------------------------------------------------------------------------------
+void log_lua_startup_profile()
+{
+    if (s_timings.empty())
+        return;
+
+    std::vector<const startup_timing*> sorted;
+    get_sorted_timings(sorted);
+
+    LOG("Lua startup took %u ms in %u steps; slowest steps:", unsigned(s_total * 1000), unsigned(sorted.size()));
+    for (size_t i = 0; i < sorted.size() && i < 5; ++i)
+        LOG("    %.2f ms  %s", sorted[i]->elapsed * 1000, sorted[i]->name.c_str());
+}
+
+//------------------------------------------------------------------------------
+void lua_startup_profile_diagnostics()
+{
+    if (s_timings.empty() || !rl_explicit_arg)
+        return;
+
+    static char bold[] = "\x1b[1m";
+    static char norm[] = "\x1b[m";
+
+    std::vector<const startup_timing*> sorted;
+    get_sorted_timings(sorted);
+
+    str<> s;
+    s.format("%slua startup:%s\n", bold, norm);
+    g_printer->print(s.c_str(), s.length());
+
+    s.format("  %-16s  %.2f ms\n", "total", s_total * 1000);
+    g_printer->print(s.c_str(), s.length());
+
+    for (const auto* timing : sorted)
+    {
+        s.format("  %8.2f ms        %s\n", timing->elapsed * 1000, timing->name.c_str());
+        g_printer->print(s.c_str(), s.length());
+    }
+}
@@ -3,7 +3,9 @@
 
 #include "pch.h"
 #include "lua_state.h"
+#include "lua_bytecode_cache.h"
 #include "lua_script_loader.h"
+#include "lua_startup_profile.h"
 #include "lua_task_manager.h"
 #include "rl_buffer_lua.h"
 #include "line_state_lua.h"
@@ -93,6 +95,14 @@ static setting_int g_lua_throttle_coroutines(
     "default value was 5 seconds, but now it's 0 (no throttling).",
     0);
 
+static setting_bool g_lua_deferred_init(
+    "lua.deferred_init",
+    "Defers initializing some Lua APIs",
+    "When enabled, the 'console' and 'http' Lua APIs aren't initialized until\n"
+    "the first time a script uses them.  This reduces the time needed to start\n"
+    "new sessions and to reload Lua.",
+    true);
+
 extern setting_bool g_debug_log_terminal;
 #ifdef _MSC_VER
 extern setting_bool g_debug_log_output_callstacks;
@@ -106,13 +116,13 @@ void internal_lua_revoke(lua_state&);
 void clink_lua_initialise(lua_state&, bool lua_interpreter=false);
 void os_lua_initialise(lua_state&);
 void io_lua_initialise(lua_state&);
-void console_lua_initialise(lua_state&, bool lua_interpreter=false);
+void console_lua_initialise(lua_state&, bool lua_interpreter=false, bool deferred=false);
 void path_lua_initialise(lua_state&);
 void rl_lua_initialise(lua_state&, bool lua_interpreter=false);
 void settings_lua_initialise(lua_state&);
 void string_lua_initialise(lua_state&);
 void unicode_lua_initialise(lua_state&);
-void http_lua_initialise(lua_state&);
+void http_lua_initialise(lua_state&, bool deferred=false);
 void log_lua_initialise(lua_state&);
 
 
@@ -230,9 +240,12 @@ void lua_state::initialise(lua_state_flags flags)
 
     const bool interpreter = !!int32(flags & lua_state_flags::interpreter);
     const bool no_env = !!int32(flags & lua_state_flags::no_env);
+    const bool deferred = !interpreter && g_lua_deferred_init.get();
 
     s_interpreter = interpreter;
 
+    clear_lua_startup_profile();
+
     // Create a new Lua state.
     m_state = luaL_newstate();
 
@@ -247,7 +260,10 @@ void lua_state::initialise(lua_state_flags flags)
     }
 
     // Open the standard Lua libraries.
-    luaL_openlibs(m_state);
+    {
+        lua_startup_timer timer("luaL_openlibs");
+        luaL_openlibs(m_state);
+    }
 
     // Set up the package.path value for require() statements.
     str<280> path;
@@ -274,18 +290,21 @@ void lua_state::initialise(lua_state_flags flags)
     lua_state& self = *this;
 
     // Initialize API namespaces.
-    internal_lua_initialise(self, interpreter);
-    clink_lua_initialise(self, interpreter);
-    os_lua_initialise(self);
-    io_lua_initialise(self);
-    console_lua_initialise(self, interpreter);
-    path_lua_initialise(self);
-    rl_lua_initialise(self, interpreter);
-    settings_lua_initialise(self);
-    string_lua_initialise(self);
-    unicode_lua_initialise(self);
-    http_lua_initialise(self);
-    log_lua_initialise(self);
+#define TIMED_INITIALISE(x, ...) \
+    do { lua_startup_timer timer(#x); x(self, ##__VA_ARGS__); } while (false)
+    TIMED_INITIALISE(internal_lua_initialise, interpreter);
+    TIMED_INITIALISE(clink_lua_initialise, interpreter);
+    TIMED_INITIALISE(os_lua_initialise);
+    TIMED_INITIALISE(io_lua_initialise);
+    TIMED_INITIALISE(console_lua_initialise, interpreter, deferred);
+    TIMED_INITIALISE(path_lua_initialise);
+    TIMED_INITIALISE(rl_lua_initialise, interpreter);
+    TIMED_INITIALISE(settings_lua_initialise);
+    TIMED_INITIALISE(string_lua_initialise);
+    TIMED_INITIALISE(unicode_lua_initialise);
+    TIMED_INITIALISE(http_lua_initialise, deferred);
+    TIMED_INITIALISE(log_lua_initialise);
+#undef TIMED_INITIALISE
 
     // Load the debugger.
     if (g_force_load_debugger || g_lua_debug.get())
@@ -376,7 +395,7 @@ bool lua_state::do_file(const char* path)
 
     save_stack_top ss(L);
 
-    int32 err = luaL_loadfile(L, path);
+    int32 err = load_file_cached(L, path);
     if (err)
     {
         if (g_lua_debug.get())
@@ -470,6 +489,114 @@ report_error:
     return true;
 }
 
+//------------------------------------------------------------------------------
+// A lazy module is a proxy table with a metatable that opens the real module
+// the first time the proxy is indexed or enumerated.  The real module's fields
+// are copied into the proxy and the metatable is removed, so afterwards the
+// proxy is an ordinary table with no further overhead.
+static void ensure_lazy_module(lua_State* L, int32 proxy)
+{
+    if (!lua_getmetatable(L, proxy))
+        return;
+
+    lua_getfield(L, -1, "__lazyopen");
+    lua_remove(L, -2);
+    if (!lua_isfunction(L, -1))
+    {
+        lua_pop(L, 1);
+        return;
+    }
+
+    // Remove the metatable first, so that opening can't recurse.
+    lua_pushnil(L);
+    lua_setmetatable(L, proxy);
+
+    lua_call(L, 0, 1);
+    if (lua_istable(L, -1))
+    {
+        lua_pushnil(L);
+        while (lua_next(L, -2))
+        {
+            // Fields assigned before the module was opened take precedence
+            // (e.g. console.lua adds functions to the console table).
+            lua_pushvalue(L, -2);
+            lua_rawget(L, proxy);
+            const bool exists = !lua_isnil(L, -1);
+            lua_pop(L, 1);
+            if (exists)
+            {
+                lua_pop(L, 1);
+            }
+            else
+            {
+                lua_pushvalue(L, -2);
+                lua_insert(L, -2);
+                lua_rawset(L, proxy);
+            }
+        }
+    }
+    lua_pop(L, 1);
+}
+
+//------------------------------------------------------------------------------
+static int32 lazy_module_index(lua_State* L)
+{
+    ensure_lazy_module(L, 1);
+    lua_settop(L, 2);
+    lua_rawget(L, 1);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static int32 lazy_module_pairs(lua_State* L)
+{
+    ensure_lazy_module(L, 1);
+    lua_getglobal(L, "next");
+    lua_pushvalue(L, 1);
+    lua_pushnil(L);
+    return 3;
+}
+
+//------------------------------------------------------------------------------
+static int32 lazy_module_require(lua_State* L)
+{
+    lua_pushvalue(L, lua_upvalueindex(1));
+    ensure_lazy_module(L, lua_gettop(L));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+void lua_state::register_lazy_module(lua_State* L, const char* name, int32 (*open)(lua_State*))
+{
+    save_stack_top ss(L);
+
+    lua_newtable(L);
+    const int32 proxy = lua_gettop(L);
+
+    lua_createtable(L, 0, 3);
+    lua_pushcfunction(L, open);
+    lua_setfield(L, -2, "__lazyopen");
+    lua_pushcfunction(L, lazy_module_index);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, lazy_module_pairs);
+    lua_setfield(L, -2, "__pairs");
+    lua_setmetatable(L, proxy);
+
+    // require(name) opens the module and returns the same table.
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "preload");
+    if (lua_istable(L, -1))
+    {
+        lua_pushvalue(L, proxy);
+        lua_pushcclosure(L, lazy_module_require, 1);
+        lua_setfield(L, -2, name);
+    }
+    lua_pop(L, 2);
+
+    lua_pushvalue(L, proxy);
+    lua_setglobal(L, name);
+}
+
 //------------------------------------------------------------------------------
 int32 lua_state::pcall_silent(lua_State* L, int32 nargs, int32 nresults)
 {
@@ -8,6 +8,8 @@
 
 #include <core/base.h>
 #include <core/cwd_restorer.h>
+#include <core/session_stats.h>
+#include <core/trace.h>
 #include <lib/line_state.h>
 #include <lib/word_classifications.h>
 
@@ -57,6 +59,9 @@ lua_word_classifier::lua_word_classifier(lua_state& state)
 //------------------------------------------------------------------------------
 void lua_word_classifier::classify(const line_states& commands, word_classifications& classifications, bool word_classes)
 {
+    TRACE_SCOPE("classify");
+    LATENCY_SCOPE(classify);
+
     lua_State* state = m_state.get_state();
     save_stack_top ss(state);
 
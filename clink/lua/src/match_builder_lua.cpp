@@ -9,6 +9,8 @@
 #include <core/str.h>
 #include <lib/matches.h>
 
+#include <assert.h>
+
 //------------------------------------------------------------------------------
 const char* const match_builder_lua::c_name = "match_builder_lua";
 const match_builder_lua::method match_builder_lua::c_methods[] = {
@@ -29,6 +31,8 @@ const match_builder_lua::method match_builder_lua::c_methods[] = {
     { "_clear_toolkit",     &clear_toolkit },
     { "_set_input_line",    &set_input_line },
     { "_matches_ready",     &matches_ready },
+    { "_matches_partial",   &matches_partial },
+    { "_notify_partial",    &notify_partial },
     { "_get_generation_id", &get_generation_id },
     { "_log_matches",       &log_matches },
     {}
@@ -346,6 +350,7 @@ int32 match_builder_lua::clear_toolkit(lua_State* state)
 {
     if (m_toolkit)
         m_toolkit->clear();
+    m_partial.reset();
     return 0;
 }
 
@@ -379,6 +384,52 @@ int32 match_builder_lua::matches_ready(lua_State* state)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Adds a batch of matches to the preview of matches that a generator is still
+// producing.  The preview starts with the matches generated so far, and each
+// call only adds the new batch.
+int32 match_builder_lua::matches_partial(lua_State* state)
+{
+    if (!m_toolkit || !lua_istable(state, LUA_SELF + 1))
+        return 0;
+
+    if (!m_partial)
+        m_partial = make_partial_match_builder_toolkit(m_toolkit);
+
+    rollback<match_builder*> rb(m_builder, m_partial->get_builder());
+    const int32 total = int32(lua_rawlen(state, LUA_SELF + 1));
+    for (int32 i = 1; i <= total; ++i)
+    {
+        lua_rawgeti(state, LUA_SELF + 1, i);
+        add_match_impl(state, -1, match_type::none);
+        lua_pop(state, 1);
+    }
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Shows the preview of matches.  This calls into the line editor, which may
+// call Lua, so it must be called from the main coroutine (clink.runonmain).
+int32 match_builder_lua::notify_partial(lua_State* state)
+{
+    if (!m_toolkit || !m_partial)
+        return 0;
+
+    if (!lua_pushthread(state))
+    {
+        assert(false);
+        lua_pop(state, 1);
+        return 0;
+    }
+    lua_pop(state, 1);
+
+    lua_pushboolean(state, notify_matches_partial(m_partial, m_toolkit->get_generation_id()));
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 // UNDOCUMENTED; internal use only.
 int32 match_builder_lua::get_generation_id(lua_State* state)
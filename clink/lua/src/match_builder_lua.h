@@ -40,6 +40,8 @@ protected:
     int32           clear_toolkit(lua_State* state);
     int32           set_input_line(lua_State* state);
     int32           matches_ready(lua_State* state);
+    int32           matches_partial(lua_State* state);
+    int32           notify_partial(lua_State* state);
     int32           get_generation_id(lua_State* state);
     int32           log_matches(lua_State* state);
 
@@ -47,6 +49,7 @@ private:
     bool            add_match_impl(lua_State* state, int32 stack_index, match_type type);
     match_builder*  m_builder;
     std::shared_ptr<match_builder_toolkit> m_toolkit;
+    std::shared_ptr<match_builder_toolkit> m_partial;
 
     friend class lua_bindable<match_builder_lua>;
     static const char* const c_name;
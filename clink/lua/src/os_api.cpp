@@ -7,6 +7,7 @@
 #include "yield.h"
 
 #include <core/base.h>
+#include <core/dir_cache.h>
 #include <core/globber.h>
 #include <core/os.h>
 #include <core/path.h>
@@ -14,6 +15,7 @@
 #include <core/str.h>
 #include <core/str_iter.h>
 #include <lib/doskey.h>
+#include <lib/alias_cache.h>
 #include <lib/clink_ctrlevent.h>
 #include <terminal/terminal_helpers.h>
 #include <terminal/printer.h>
@@ -32,6 +34,7 @@ extern int _rl_match_hidden_files;
 //#define USE_WNETOPENENUM
 //#define DEBUG_TRAVERSE_GLOBAL_NET
 #include "async_lua_task.h"
+#include "lua_input_idle.h"
 #include <core/debugheap.h>
 #include <mutex>
 #include <lmcons.h>
@@ -760,73 +763,85 @@ static void add_type_tag(str_base& out, const char* tag)
 }
 
 //------------------------------------------------------------------------------
-static bool glob_next(lua_State* state, globber& globber, str_base& parent, int32* index, int32 extrainfo)
+static void get_glob_type(const globber::extrainfo& info, const char* file, str_base& parent, str_base& type)
 {
-    str<288> file;
-    globber::extrainfo info;
-    globber::extrainfo* info_ptr = extrainfo ? &info : nullptr;
-    if (!globber.next(file, false, info_ptr))
-        return false;
+    type.clear();
+    add_type_tag(type, (info.attr & FILE_ATTRIBUTE_DIRECTORY) ? "dir" : "file");
+#ifdef S_ISLNK
+    if (S_ISLNK(info.st_mode))
+    {
+        uint32 len = parent.length();
+        path::append(parent, file);
+
+        add_type_tag(type, "link");
+        wstr<288> wfile(parent.c_str());
+        struct _stat64 st;
+        if (_wstat64(wfile.c_str(), &st) < 0)
+            add_type_tag(type, "orphaned");
+
+        parent.truncate(len);
+    }
+#endif
+    if (info.attr & FILE_ATTRIBUTE_HIDDEN)
+        add_type_tag(type, "hidden");
+    if (info.attr & FILE_ATTRIBUTE_SYSTEM)
+        add_type_tag(type, "system");
+    if (info.attr & FILE_ATTRIBUTE_READONLY)
+        add_type_tag(type, "readonly");
+}
 
+//------------------------------------------------------------------------------
+static void push_glob_result(lua_State* state, const char* file, uint32 len, const char* type, const globber::extrainfo& info, int32 extrainfo)
+{
     if (!extrainfo)
     {
-        lua_pushlstring(state, file.c_str(), file.length());
+        lua_pushlstring(state, file, len);
+        return;
     }
-    else
-    {
-        lua_createtable(state, 0, 2);
 
-        lua_pushliteral(state, "name");
-        lua_pushlstring(state, file.c_str(), file.length());
-        lua_rawset(state, -3);
+    lua_createtable(state, 0, 2);
 
-        str<32> type;
-        add_type_tag(type, (info.attr & FILE_ATTRIBUTE_DIRECTORY) ? "dir" : "file");
-#ifdef S_ISLNK
-        if (S_ISLNK(info.st_mode))
-        {
-            uint32 len = parent.length();
-            path::append(parent, file.c_str());
+    lua_pushliteral(state, "name");
+    lua_pushlstring(state, file, len);
+    lua_rawset(state, -3);
 
-            add_type_tag(type, "link");
-            wstr<288> wfile(parent.c_str());
-            struct _stat64 st;
-            if (_wstat64(wfile.c_str(), &st) < 0)
-                add_type_tag(type, "orphaned");
+    lua_pushliteral(state, "type");
+    lua_pushstring(state, type);
+    lua_rawset(state, -3);
 
-            parent.truncate(len);
-        }
-#endif
-        if (info.attr & FILE_ATTRIBUTE_HIDDEN)
-            add_type_tag(type, "hidden");
-        if (info.attr & FILE_ATTRIBUTE_SYSTEM)
-            add_type_tag(type, "system");
-        if (info.attr & FILE_ATTRIBUTE_READONLY)
-            add_type_tag(type, "readonly");
-
-        lua_pushliteral(state, "type");
-        lua_pushlstring(state, type.c_str(), type.length());
+    if (extrainfo >= 2)
+    {
+        lua_pushliteral(state, "atime");
+        lua_pushnumber(state, lua_Number(os::filetime_to_time_t(info.accessed)));
         lua_rawset(state, -3);
 
-        if (extrainfo >= 2)
-        {
-            lua_pushliteral(state, "atime");
-            lua_pushnumber(state, lua_Number(os::filetime_to_time_t(info.accessed)));
-            lua_rawset(state, -3);
-
-            lua_pushliteral(state, "mtime");
-            lua_pushnumber(state, lua_Number(os::filetime_to_time_t(info.modified)));
-            lua_rawset(state, -3);
+        lua_pushliteral(state, "mtime");
+        lua_pushnumber(state, lua_Number(os::filetime_to_time_t(info.modified)));
+        lua_rawset(state, -3);
 
-            lua_pushliteral(state, "ctime");
-            lua_pushnumber(state, lua_Number(os::filetime_to_time_t(info.created)));
-            lua_rawset(state, -3);
+        lua_pushliteral(state, "ctime");
+        lua_pushnumber(state, lua_Number(os::filetime_to_time_t(info.created)));
+        lua_rawset(state, -3);
 
-            lua_pushliteral(state, "size");
-            lua_pushnumber(state, lua_Number(info.size));
-            lua_rawset(state, -3);
-        }
+        lua_pushliteral(state, "size");
+        lua_pushnumber(state, lua_Number(info.size));
+        lua_rawset(state, -3);
     }
+}
+
+//------------------------------------------------------------------------------
+static bool glob_next(lua_State* state, globber& globber, str_base& parent, int32* index, int32 extrainfo)
+{
+    str<288> file;
+    globber::extrainfo info;
+    globber::extrainfo* info_ptr = extrainfo ? &info : nullptr;
+    if (!globber.next(file, false, info_ptr))
+        return false;
+
+    str<32> type;
+    if (extrainfo)
+        get_glob_type(info, file.c_str(), parent, type);
+    push_glob_result(state, file.c_str(), file.length(), type.c_str(), info, extrainfo);
 
     if (index)
         lua_rawseti(state, -2, (*index)++);
@@ -944,6 +959,286 @@ int32 globber_impl(lua_State* state, bool dirs_only, bool back_compat=false)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+// Used by tests to simulate a slow filesystem; the async globber waits this
+// long before fetching each entry.
+static uint32 s_glob_async_delay = 0;
+void set_glob_async_delay(uint32 ms)
+{
+    s_glob_async_delay = ms;
+}
+
+//------------------------------------------------------------------------------
+struct glob_async_entry
+{
+    str_moveable        name;
+    str_moveable        type;
+    globber::extrainfo  info;
+};
+
+//------------------------------------------------------------------------------
+// Enumerates a directory on a background thread, and publishes the entries in
+// batches so a coroutine can consume them while the enumeration continues.
+class glob_async_lua_task : public async_lua_task
+{
+public:
+    glob_async_lua_task(const char* key, const char* src, async_yield_lua* asyncyield, const char* pattern, int32 extrainfo, const glob_flags& flags, bool dirs_only)
+    : async_lua_task(key, src)
+    , m_pattern(pattern)
+    , m_extrainfo(extrainfo)
+    , m_flags(flags)
+    , m_dirs_only(dirs_only)
+    , m_use_cache(dir_cache::is_enabled())
+    , m_asyncyield(asyncyield)
+    {
+    }
+
+    bool take(std::vector<glob_async_entry>& out);
+    void detach_asyncyield();
+
+protected:
+    void do_work() override;
+
+private:
+    void publish(std::vector<glob_async_entry>& batch, bool done);
+
+    static const uint32 c_batch_size = 250;
+    static const DWORD c_batch_ms = 50;
+
+    const str_moveable m_pattern;
+    const int32 m_extrainfo;
+    const glob_flags m_flags;
+    const bool m_dirs_only;
+    const bool m_use_cache;         // Captured on the main thread.
+    std::mutex m_mutex;
+    async_yield_lua* m_asyncyield;
+    std::vector<glob_async_entry> m_pending;
+    bool m_done = false;
+};
+
+//------------------------------------------------------------------------------
+// Moves the available entries into out.  Returns false once the enumeration
+// is finished and all entries have been taken.  When no entries are available
+// yet, the asyncyield is cleared so the coroutine isn't resumed until the next
+// batch is published.
+bool glob_async_lua_task::take(std::vector<glob_async_entry>& out)
+{
+    out.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    out.swap(m_pending);
+    if (!out.empty())
+        return true;
+    if (m_done || is_canceled())
+        return false;
+    if (m_asyncyield)
+        m_asyncyield->clear_ready();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// The asyncyield is owned by Lua; once it's garbage collected the task must
+// not touch it anymore.
+void glob_async_lua_task::detach_asyncyield()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_asyncyield = nullptr;
+}
+
+//------------------------------------------------------------------------------
+void glob_async_lua_task::publish(std::vector<glob_async_entry>& batch, bool done)
+{
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        {
+            dbg_ignore_scope(snapshot, "async glob");
+            if (m_pending.empty())
+                m_pending.swap(batch);
+            else
+            {
+                for (auto& entry : batch)
+                    m_pending.emplace_back(std::move(entry));
+            }
+        }
+        m_done = done;
+        if (m_asyncyield)
+        {
+            m_asyncyield->set_ready();
+            wake = true;
+        }
+    }
+
+    batch.clear();
+
+    // Signal to run idle.
+    HANDLE h = wake ? lua_input_idle::get_idle_event() : nullptr;
+    if (h)
+        SetEvent(h);
+}
+
+//------------------------------------------------------------------------------
+void glob_async_lua_task::do_work()
+{
+    globber globber(m_pattern.c_str(), m_use_cache);
+    globber.files(!m_dirs_only);
+    globber.hidden(m_flags.hidden);
+    globber.system(m_flags.system);
+
+    str_moveable parent(m_pattern.c_str());
+    path::to_parent(parent, nullptr);
+
+    std::vector<glob_async_entry> batch;
+    DWORD tick = GetTickCount();
+    str<288> file;
+    while (!is_canceled())
+    {
+        if (s_glob_async_delay)
+            Sleep(s_glob_async_delay);
+
+        glob_async_entry entry;
+        if (!globber.next(file, false, m_extrainfo ? &entry.info : nullptr))
+            break;
+
+        dbg_ignore_scope(snapshot, "async glob");
+        entry.name = file.c_str();
+        if (m_extrainfo)
+        {
+            str<32> type;
+            get_glob_type(entry.info, file.c_str(), parent, type);
+            entry.type = type.c_str();
+        }
+        batch.emplace_back(std::move(entry));
+
+        if (batch.size() >= c_batch_size || GetTickCount() - tick >= c_batch_ms)
+        {
+            publish(batch, false);
+            tick = GetTickCount();
+        }
+    }
+
+    publish(batch, true);
+}
+
+//------------------------------------------------------------------------------
+class glob_async_lua
+    : public lua_bindable<glob_async_lua>
+{
+public:
+                        glob_async_lua(const std::shared_ptr<glob_async_lua_task>& task, int32 extrainfo) : m_task(task), m_extrainfo(extrainfo) {}
+                        ~glob_async_lua();
+
+protected:
+    int32               next(lua_State* state);
+    int32               close(lua_State* state);
+
+private:
+    std::shared_ptr<glob_async_lua_task> m_task;
+    const int32         m_extrainfo;
+    int32               m_index = 1;
+
+    friend class lua_bindable<glob_async_lua>;
+    static const char* const c_name;
+    static const method c_methods[];
+};
+
+//------------------------------------------------------------------------------
+const char* const glob_async_lua::c_name = "glob_async_lua";
+const glob_async_lua::method glob_async_lua::c_methods[] = {
+    { "next",                   &next },
+    { "close",                  &close },
+    {}
+};
+
+//------------------------------------------------------------------------------
+glob_async_lua::~glob_async_lua()
+{
+    m_task->cancel();
+    m_task->detach_asyncyield();
+}
+
+//------------------------------------------------------------------------------
+int32 glob_async_lua::next(lua_State* state)
+{
+    // Arg is table into which to glob files/dirs; appends whatever entries
+    // are available so far.  Returns whether there may be more entries, and
+    // whether the caller needs to wait for them.
+
+    std::vector<glob_async_entry> entries;
+    const bool more = m_task->take(entries);
+
+    for (const auto& entry : entries)
+    {
+        push_glob_result(state, entry.name.c_str(), entry.name.length(), entry.type.c_str(), entry.info, m_extrainfo);
+        lua_rawseti(state, -2, m_index++);
+    }
+
+    lua_pushboolean(state, more);
+    lua_pushboolean(state, more && entries.empty());
+    return 2;
+}
+
+//------------------------------------------------------------------------------
+int32 glob_async_lua::close(lua_State* state)
+{
+    m_task->cancel();
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// Returns an async globber and its asyncyield object.  If the task can't be
+// started, this falls back to returning a regular globber.
+int32 async_globber_impl(lua_State* state, bool dirs_only)
+{
+    const char* mask = checkstring(state, 1);
+    if (!mask)
+        return 0;
+
+    int32 extrainfo;
+    if (lua_isboolean(state, 2))
+        extrainfo = lua_toboolean(state, 2);
+    else
+        extrainfo = optinteger(state, 2, 0);
+
+    glob_flags flags;
+    get_glob_flags(state, 3, flags, false);
+
+    static uint32 s_counter = 0;
+    str_moveable key;
+    key.format("globasync||%08x", ++s_counter);
+
+    str<> src;
+    get_lua_srcinfo(state, src);
+
+    dbg_ignore_scope(snapshot, "async glob");
+
+    async_yield_lua* asyncyield = async_yield_lua::make_new(state, dirs_only ? "os.globdirs" : "os.globfiles");
+    if (!asyncyield)
+        return 0;
+
+    auto task = std::make_shared<glob_async_lua_task>(key.c_str(), src.c_str(), asyncyield, mask, extrainfo, flags, dirs_only);
+    if (!task)
+        return 0;
+    {
+        std::shared_ptr<async_lua_task> add(task); // Because MINGW can't handle it inline.
+        if (!add_async_lua_task(add))
+        {
+            lua_pop(state, 1);
+            return globber_impl(state, dirs_only);
+        }
+        asyncyield->set_task(add);
+    }
+
+    if (!glob_async_lua::make_new(state, task, extrainfo))
+    {
+        task->cancel();
+        return 0;
+    }
+
+    lua_insert(state, -2);
+    return 2;
+}
+
 //------------------------------------------------------------------------------
 /// -name:  os.globdirs
 /// -ver:   1.0.0
@@ -1314,6 +1609,7 @@ public:
 
 protected:
     void do_work() override;
+    bool is_blocking() const override { return true; }
 
 private:
     const str_moveable m_server;
@@ -2228,6 +2524,7 @@ int32 set_alias(lua_State* state)
     if (!name || !command)
         return 0;
 
+    alias_snapshot::invalidate();
     lua_pushboolean(state, os::set_alias(name, command));
     return 1;
 }
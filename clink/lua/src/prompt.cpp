@@ -8,6 +8,8 @@
 #include <core/str.h>
 #include <core/str_iter.h>
 #include <core/os.h>
+#include <core/session_stats.h>
+#include <core/trace.h>
 #include <lib/line_buffer.h>
 #include "lua_script_loader.h"
 #include "lua_state.h"
@@ -425,6 +427,9 @@ bool prompt_filter::filter(const char* in, str_base& out)
 //------------------------------------------------------------------------------
 bool prompt_filter::filter(const char* in, const char* rin, str_base& out, str_base& rout, bool transient, bool final)
 {
+    TRACE_SCOPE("prompt_filter");
+    LATENCY_SCOPE(prompt);
+
     lua_State* state = m_lua.get_state();
 
     int32 top = lua_gettop(state);
@@ -22,6 +22,41 @@ void discard_all_session_streams()
     delete streams;
 }
 
+//------------------------------------------------------------------------------
+std::shared_ptr<session_stream> find_session_stream(const char* name, bool create)
+{
+    if (!s_streams)
+        s_streams = new str_unordered_map<std::shared_ptr<session_stream>>;
+
+    auto it = s_streams->find(name);
+    if (it != s_streams->end())
+        return it->second;
+    if (!create)
+        return nullptr;
+
+    auto stream = std::make_shared<session_stream>(name);
+    s_streams->emplace(stream->name(), stream);
+    return stream;
+}
+
+//------------------------------------------------------------------------------
+bool discard_session_stream(const char* name)
+{
+    if (!s_streams)
+        return false;
+
+    auto it = s_streams->find(name);
+    if (it == s_streams->end())
+        return false;
+
+    // Open handles keep their own reference, so the data stays valid until
+    // they're closed.  Release the map's reference after erasing, since
+    // ~session_stream also looks in the map.
+    std::shared_ptr<session_stream> stream = std::move(it->second);
+    s_streams->erase(it);
+    return true;
+}
+
 //------------------------------------------------------------------------------
 session_stream::session_stream(const char* name)
 : m_name(name)
@@ -201,14 +236,8 @@ luaL_SessionStream* tostream(lua_State* state, bool require)
 //------------------------------------------------------------------------------
 luaL_SessionStream* luaL_SessionStream::make_new(lua_State* state, const char* name, OpenFlags flags, bool clear)
 {
-    if (!s_streams)
-        s_streams = new str_unordered_map<std::shared_ptr<session_stream>>;
-
     // Look for an existing named stream.
-    std::shared_ptr<session_stream> stream;
-    auto it = s_streams->find(name);
-    if (it != s_streams->end())
-        stream = it->second;
+    std::shared_ptr<session_stream> stream = find_session_stream(name, false);
 
     if (stream)
     {
@@ -228,9 +257,7 @@ luaL_SessionStream* luaL_SessionStream::make_new(lua_State* state, const char* n
             return nullptr;
         }
 
-        stream = std::make_shared<session_stream>(name);
-        assert(s_streams->find(name) == s_streams->end());
-        s_streams->emplace(stream->name(), stream);
+        stream = find_session_stream(name, true);
     }
 
 #ifdef DEBUG
@@ -37,6 +37,10 @@ private:
     stream_position_t m_capacity = 0;
 };
 
+//------------------------------------------------------------------------------
+std::shared_ptr<session_stream> find_session_stream(const char* name, bool create);
+bool discard_session_stream(const char* name);
+
 //------------------------------------------------------------------------------
 struct luaL_SessionStream
 {
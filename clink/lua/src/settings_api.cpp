@@ -41,6 +41,10 @@ extern setting_bool g_lua_strict;
 /// Color settings normally return the ANSI color code, suitable for use in an
 /// ANSI escape sequence.  If the optional <span class="arg">descriptive</span>
 /// parameter is true then the friendly color name is returned.
+///
+/// Starting in v1.9.33, <span class="arg">name</span> may instead be a handle
+/// returned by <a href="#settings.gethandle">settings.gethandle()</a>, which
+/// is faster.
 /// -show:  print(settings.get("color.doskey"))         -- Can print "1;36"
 /// -show:  print(settings.get("color.doskey", true))   -- Can print "bold cyan"
 static int32 get(lua_State* state)
@@ -49,11 +53,18 @@ static int32 get(lua_State* state)
     // WARNING!     Update the override in config.cpp if you change this!
     // WARNING!
 
-    const char* key = checkstring(state, 1);
-    if (!key)
-        return 0;
-
-    const setting* setting = settings::find(key);
+    const setting* setting;
+    if (lua_type(state, 1) == LUA_TNUMBER)
+    {
+        setting = settings::from_handle(uint32(lua_tointeger(state, 1)));
+    }
+    else
+    {
+        const char* key = checkstring(state, 1);
+        if (!key)
+            return 0;
+        setting = settings::find(key);
+    }
     if (setting == nullptr)
         return 0;
 
@@ -74,6 +85,22 @@ static int32 get(lua_State* state)
         }
         break;
 
+    case setting::type_string:
+        {
+            const char* value = ((const setting_str*)setting)->get();
+            lua_pushstring(state, value);
+        }
+        break;
+
+    case setting::type_color:
+        if (!lua_isboolean(state, 2) || !lua_toboolean(state, 2))
+        {
+            const char* value = ((const setting_color*)setting)->get();
+            lua_pushstring(state, value);
+            break;
+        }
+        // fall through
+
     default:
         {
             str<> value;
@@ -95,6 +122,52 @@ static int32 get(lua_State* state)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+/// -name:  settings.gethandle
+/// -ver:   1.9.33
+/// -arg:   name:string
+/// -ret:   integer
+/// Returns a handle for the <span class="arg">name</span> Clink setting.  The
+/// handle can be passed to <a href="#settings.get">settings.get()</a> in place
+/// of the name, which is faster for scripts that read a setting often, such
+/// as on every keystroke.
+///
+/// The handle stays valid even if the setting doesn't exist yet, or if it is
+/// removed and added again when scripts are reloaded.
+/// -show:  local doskey_color = settings.gethandle("color.doskey")
+/// -show:  print(settings.get(doskey_color))           -- Can print "1;36"
+static int32 get_handle(lua_State* state)
+{
+    const char* key = checkstring(state, 1);
+    if (!key)
+        return 0;
+
+    lua_pushinteger(state, settings::get_handle(key));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  settings.getgeneration
+/// -ver:   1.9.33
+/// -ret:   integer
+/// Returns a number that changes whenever any setting's value changes, or a
+/// setting is added or removed (for example when scripts are reloaded).
+/// Scripts can cache values derived from settings and recompute them only
+/// when this number changes.
+/// -show:  local cached, generation
+/// -show:  local function get_colors()
+/// -show:      if generation ~= settings.getgeneration() then
+/// -show:          generation = settings.getgeneration()
+/// -show:          cached = { settings.get("color.cmd"), settings.get("color.doskey") }
+/// -show:      end
+/// -show:      return cached
+/// -show:  end
+static int32 get_generation(lua_State* state)
+{
+    lua_pushinteger(state, settings::get_generation());
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 /// -name:  settings.set
 /// -ver:   1.0.0
@@ -779,6 +852,8 @@ void settings_lua_initialise(lua_state& lua)
         int32       (*method)(lua_State*);
     } methods[] = {
         { 1, "get",         &get },
+        { 1, "gethandle",   &get_handle },
+        { 1, "getgeneration", &get_generation },
         { 1, "set",         &set },
         { 1, "add",         &add },
         { 1, "clear",       &clear },
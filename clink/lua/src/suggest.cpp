@@ -10,6 +10,8 @@
 #include <core/str_compare.h>
 #include <core/settings.h>
 #include <core/cwd_restorer.h>
+#include <core/session_stats.h>
+#include <core/trace.h>
 #include <lib/line_state.h>
 #include <lib/matches.h>
 #include <lib/suggestions.h>
@@ -50,6 +52,9 @@ suggester::suggester(lua_state& lua)
 //------------------------------------------------------------------------------
 bool suggester::suggest(const line_states& lines, matches* matches, int32 matches_generation_id)
 {
+    TRACE_SCOPE("suggest");
+    LATENCY_SCOPE(suggest);
+
     const line_state& line = lines.back();
 
     if (is_empty_or_spaces(line.get_line()))
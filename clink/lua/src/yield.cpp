@@ -7,8 +7,8 @@
 #include "lua_input_idle.h"
 
 #include <core/os.h>
+#include <core/task_pool.h>
 
-#include <process.h>
 #include <assert.h>
 
 //------------------------------------------------------------------------------
@@ -22,20 +22,18 @@ yield_thread::yield_thread()
 //------------------------------------------------------------------------------
 yield_thread::~yield_thread()
 {
-    if (m_thread_handle)
-    {
-        cancel();
-        CloseHandle(m_thread_handle);
-    }
     if (m_ready_event)
         CloseHandle(m_ready_event);
 }
 
 //------------------------------------------------------------------------------
+// The work runs on the shared task_pool rather than a dedicated thread.  The
+// name is kept because "creating the thread" still means preparing the work
+// and taking a strong ref; go() is what submits it to the pool.  The work
+// waits on a child process, so it's submitted as blocking.
 bool yield_thread::createthread()
 {
     assert(!m_suspended);
-    assert(!m_thread_handle);
     assert(!m_cancelled);
     assert(!m_ready_event);
     os::get_current_dir(m_cwd);
@@ -48,10 +46,7 @@ bool yield_thread::createthread()
     m_ready_event = CreateEvent(nullptr, true, false, nullptr);
     if (!m_ready_event)
         return false;
-    m_thread_handle = reinterpret_cast<HANDLE>(_beginthreadex(nullptr, 0, &threadproc, this, CREATE_SUSPENDED, nullptr));
-    if (!m_thread_handle)
-        return false;
-    m_holder = shared_from_this(); // Now threadproc holds a strong ref.
+    m_holder = shared_from_this(); // Now the pending work holds a strong ref.
     m_suspended = true;
     return true;
 }
@@ -60,11 +55,8 @@ bool yield_thread::createthread()
 void yield_thread::go()
 {
     assert(m_suspended);
-    if (m_thread_handle)
-    {
-        m_suspended = false;
-        ResumeThread(m_thread_handle);
-    }
+    if (m_suspended)
+        submit();
 }
 
 //------------------------------------------------------------------------------
@@ -72,7 +64,18 @@ void yield_thread::cancel()
 {
     m_cancelled = true;
     if (m_suspended) // Can only be true when there's no concurrency.
-        ResumeThread(m_thread_handle);
+        submit();
+}
+
+//------------------------------------------------------------------------------
+void yield_thread::submit()
+{
+    // Hand the strong ref over to the pool.
+    std::shared_ptr<yield_thread> holder;
+    holder.swap(m_holder);
+    m_suspended = false;
+    if (!task_pool::get().submit([holder]() { proc(holder); }, true/*blocking*/))
+        proc(holder);
 }
 
 //------------------------------------------------------------------------------
@@ -118,23 +121,15 @@ const char* yield_thread::get_cwd() const
 }
 
 //------------------------------------------------------------------------------
-unsigned __stdcall yield_thread::threadproc(void *arg)
+void yield_thread::proc(std::shared_ptr<yield_thread> thread)
 {
-    yield_thread *_this = static_cast<yield_thread *>(arg);
-
     // Do the work defined by the subclass.
-    _this->do_work();
+    thread->do_work();
 
     // Signal completion events.
-    SetEvent(_this->m_ready_event);
-    _this->do_completion(); // Give subclass a chance to do completion processing.
+    SetEvent(thread->m_ready_event);
+    thread->do_completion(); // Give subclass a chance to do completion processing.
     SetEvent(s_wake_event);
-
-    // Release threadproc's strong ref.
-    _this->m_holder = nullptr;
-
-    _endthreadex(0);
-    return 0;
 }
 
 
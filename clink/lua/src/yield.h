@@ -36,9 +36,9 @@ private:
     virtual void    do_work() = 0;
     virtual bool    do_completion() { return false; }
 
-    static unsigned __stdcall threadproc(void* arg);
+    static void     proc(std::shared_ptr<yield_thread> thread);
+    void            submit();
 
-    HANDLE m_thread_handle = 0;
     HANDLE m_ready_event = 0;
     str_moveable m_cwd;
     bool m_suspended = false;
@@ -0,0 +1,132 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "fs_fixture.h"
+
+#include <lua/lua_state.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua command cache")
+{
+    static const char* cache_fs[] = {
+        "dep.txt",
+        nullptr,
+    };
+
+    fs_fixture fs(cache_fs);
+    lua_state lua;
+
+    str<> errmsg;
+
+    static const char* setup =
+    "internal = import_internal\n"
+    "internal._cmdcache_clear()\n"
+    "function read_all(f)\n"
+    "    local s = f:read('*a')\n"
+    "    f:close()\n"
+    "    return s\n"
+    "end\n"
+    ;
+
+    REQUIRE(lua.do_string(setup, -1, &errmsg), [&]() {
+        puts(errmsg.c_str());
+    });
+
+    SECTION("Hit")
+    {
+        static const char* script =
+        "if internal._cmdcache_open('key') then error('unexpected hit') end\n"
+        "if not internal._cmdcache_store('key', 'one\\r\\ntwo\\r\\n') then error('not stored') end\n"
+        "local s = read_all(internal._cmdcache_open('key'))\n"
+        "if s ~= 'one\\ntwo\\n' then error('text mode: '..s) end\n"
+        "s = read_all(internal._cmdcache_open('key', true))\n"
+        "if s ~= 'one\\r\\ntwo\\r\\n' then error('binary mode: '..s) end\n"
+        "local stats = internal._cmdcache_stats()\n"
+        "if stats.hits ~= 2 or stats.misses ~= 1 then error('hits '..stats.hits..', misses '..stats.misses) end\n"
+        "if stats.entries ~= 1 or stats.bytes ~= 10 then error('entries '..stats.entries..', bytes '..stats.bytes) end\n"
+        ;
+
+        REQUIRE(lua.do_string(script, -1, &errmsg), [&]() {
+            puts(errmsg.c_str());
+        });
+    }
+
+    SECTION("Expired")
+    {
+        static const char* script =
+        "internal._cmdcache_store('key', 'data', 0.05)\n"
+        "if not internal._cmdcache_open('key') then error('expected hit') end\n"
+        "os.sleep(0.1)\n"
+        "if internal._cmdcache_open('key') then error('expected expiration') end\n"
+        "local stats = internal._cmdcache_stats()\n"
+        "if stats.expired ~= 1 or stats.entries ~= 0 then error('expired '..stats.expired) end\n"
+        ;
+
+        REQUIRE(lua.do_string(script, -1, &errmsg), [&]() {
+            puts(errmsg.c_str());
+        });
+    }
+
+    SECTION("Files")
+    {
+        static const char* script =
+        "internal._cmdcache_store('key', 'data', nil, { 'dep.txt', 'new.txt' })\n"
+        "if not internal._cmdcache_open('key') then error('expected hit') end\n"
+        "local f = io.open('new.txt', 'w')\n"
+        "f:close()\n"
+        "if internal._cmdcache_open('key') then error('expected invalidation by new file') end\n"
+        "\n"
+        "internal._cmdcache_store('key', 'data', nil, { 'dep.txt' })\n"
+        "f = io.open('dep.txt', 'w')\n"
+        "f:write('changed')\n"
+        "f:close()\n"
+        "if internal._cmdcache_open('key') then error('expected invalidation by changed file') end\n"
+        "if internal._cmdcache_stats().invalidated ~= 2 then error('invalidated') end\n"
+        ;
+
+        REQUIRE(lua.do_string(script, -1, &errmsg), [&]() {
+            puts(errmsg.c_str());
+        });
+    }
+
+    SECTION("popencached")
+    {
+        // Output already in the cache is returned without running the
+        // command.  The key includes the cwd and the selected environment.
+        static const char* script =
+        "local cmd = 'clink_test_no_such_command.exe'\n"
+        "os.setenv('CLINK_TEST_CMDCACHE', 'x')\n"
+        "internal._cmdcache_store(cmd..'\\n'..os.getcwd(), 'plain')\n"
+        "internal._cmdcache_store(cmd..'\\n'..os.getcwd()..'\\nCLINK_TEST_CMDCACHE=x', 'with env')\n"
+        "local s = read_all(io.popencached(cmd))\n"
+        "if s ~= 'plain' then error('got '..tostring(s)) end\n"
+        "s = read_all(io.popencached(cmd, { env={'CLINK_TEST_CMDCACHE'} }))\n"
+        "if s ~= 'with env' then error('got '..tostring(s)) end\n"
+        "os.setenv('CLINK_TEST_CMDCACHE', nil)\n"
+        ;
+
+        REQUIRE(lua.do_string(script, -1, &errmsg), [&]() {
+            puts(errmsg.c_str());
+        });
+    }
+
+    SECTION("popencached failure")
+    {
+        // Output from a command that fails is returned but not cached.
+        static const char* script =
+        "local cmd = 'echo failed& exit 1'\n"
+        "local s = read_all(io.popencached(cmd))\n"
+        "if not s:find('failed') then error('got '..tostring(s)) end\n"
+        "if internal._cmdcache_open(cmd..'\\n'..os.getcwd(), false) then error('failed command was cached') end\n"
+        ;
+
+        REQUIRE(lua.do_string(script, -1, &errmsg), [&]() {
+            puts(errmsg.c_str());
+        });
+    }
+
+    REQUIRE(lua.do_string("import_internal._cmdcache_clear()", -1, &errmsg));
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "fs_fixture.h"
+
+#include <lua/lua_state.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua completion index")
+{
+    static const char* index_fs[] = {
+        "completions/tool.lua",
+        nullptr,
+    };
+
+    fs_fixture fs(index_fs);
+
+    lua_state lua;
+
+    str<> errmsg;
+
+    static const char* setup =
+    "tool_loads = 0\n"
+    "local f = io.open('completions\\\\tool.lua', 'w')\n"
+    "f:write('tool_loads = tool_loads + 1\\n')\n"
+    "f:close()\n"
+    "clink._internal._set_completion_dirs(os.getcwd())\n"
+    "function begin_edit()\n"
+    "    clink._internal._send_event('onbeginedit')\n"
+    "end\n"
+    "function run_coroutine(func, ...)\n"
+    "    local c = coroutine.create(func)\n"
+    "    local ok, ret = coroutine.resume(c, ...)\n"
+    "    while ok and coroutine.status(c) ~= 'dead' do\n"
+    "        ok, ret = coroutine.resume(c)\n"
+    "    end\n"
+    "    if not ok then error(ret) end\n"
+    "    return ret\n"
+    "end\n"
+    ;
+
+    REQUIRE(lua.do_string(setup, -1, &errmsg), [&]() {
+        puts(errmsg.c_str());
+    });
+
+    SECTION("Current")
+    {
+        static const char* script =
+        "begin_edit()\n"
+        "local current, builds = clink._internal._get_completion_index_state()\n"
+        "if not current then error('expected current after build') end\n"
+        "if not clink._internal._get_completion_index()['tool.lua'] then error('tool.lua not indexed') end\n"
+        // Adding a file changes the directory's write time (after a pause so
+        // the clock has ticked), but the directory is only checked once per
+        // input line.
+        "os.sleep(0.05)\n"
+        "io.open('completions\\\\other.lua', 'w'):close()\n"
+        "current = clink._internal._get_completion_index_state()\n"
+        "if not current then error('expected current until the next input line') end\n"
+        "begin_edit()\n"
+        "current = clink._internal._get_completion_index_state()\n"
+        "if current then error('expected stale after adding a file') end\n"
+        "clink._internal._get_completion_index()\n"
+        "local _, rebuilt = clink._internal._get_completion_index_state()\n"
+        "if rebuilt ~= builds + 1 then error('builds '..builds..' -> '..rebuilt) end\n"
+        "if not clink._internal._get_completion_index()['other.lua'] then error('other.lua not indexed') end\n"
+        ;
+
+        REQUIRE(lua.do_string(script, -1, &errmsg), [&]() {
+            puts(errmsg.c_str());
+        });
+    }
+
+    SECTION("No-op when current")
+    {
+        static const char* script =
+        "begin_edit()\n"
+        "local _, builds = clink._internal._get_completion_index_state()\n"
+        "for _ = 1, 3 do\n"
+        "    begin_edit()\n"
+        "    clink._internal._get_completion_index()\n"
+        "end\n"
+        "local current, after = clink._internal._get_completion_index_state()\n"
+        "if not current then error('expected current') end\n"
+        "if after ~= builds then error('rebuilt '..(after - builds)..' times') end\n"
+        ;
+
+        REQUIRE(lua.do_string(script, -1, &errmsg), [&]() {
+            puts(errmsg.c_str());
+        });
+    }
+
+    SECTION("Preload resolves the command word")
+    {
+        static const char* script =
+        // Stand in for the recognizer and history, so the test doesn't depend
+        // on what's installed; the first lookup is still pending.
+        "local pending = true\n"
+        "clink.recognizecommand = function(word)\n"
+        "    if pending then\n"
+        "        pending = false\n"
+        "        return 'x', false\n"
+        "    end\n"
+        "    return 'x', true, 'C:\\\\Bin\\\\Tool.EXE'\n"
+        "end\n"
+        "rl.gethistorycount = function() return 2 end\n"
+        "rl.gethistoryitems = function() return { { line='tool one' }, { line='Tool two' } } end\n"
+        "begin_edit()\n"
+        "local file = run_coroutine(clink._internal._resolve_preload_command_word, 'tool')\n"
+        "if file ~= 'c:\\\\bin\\\\tool.exe' then error('resolved to '..tostring(file)) end\n"
+        // The script is loaded once, keyed by the recognized file, and not
+        // again by a later preload.
+        "run_coroutine(clink._internal._preload_argmatchers)\n"
+        "if tool_loads ~= 1 then error('loaded '..tool_loads..' times') end\n"
+        "run_coroutine(clink._internal._preload_argmatchers)\n"
+        "if tool_loads ~= 1 then error('loaded again: '..tool_loads) end\n"
+        ;
+
+        REQUIRE(lua.do_string(script, -1, &errmsg), [&]() {
+            puts(errmsg.c_str());
+        });
+    }
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "fs_fixture.h"
+
+#include <lua/lua_state.h>
+
+extern void set_glob_async_delay(uint32 ms);
+
+//------------------------------------------------------------------------------
+// Stand-in for a slow filesystem:  each directory entry takes a while to
+// arrive.
+struct slow_fs_scope
+{
+    slow_fs_scope(uint32 ms)    { set_glob_async_delay(ms); }
+    ~slow_fs_scope()            { set_glob_async_delay(0); }
+};
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua async glob")
+{
+    static const char* slow_fs[] = {
+        "one", "two", "three", "four", "five",
+        "six", "seven", "eight", "nine", "ten",
+        nullptr,
+    };
+
+    fs_fixture fs(slow_fs);
+    lua_state lua;
+    slow_fs_scope slow(50);
+
+    str<> errmsg;
+
+    SECTION("Responsive")
+    {
+        // Each resume of the coroutine is like one pass of the input loop; it
+        // must return quickly even though the enumeration is slow.
+        static const char* script =
+        "local batches = 0\n"
+        "local c = coroutine.create(function()\n"
+        "    return import_internal._globstreaming(false, '*', nil, nil, function(t)\n"
+        "        batches = batches + 1\n"
+        "    end)\n"
+        "end)\n"
+        "\n"
+        "local maxslice = 0\n"
+        "local resumes = 0\n"
+        "local result\n"
+        "while coroutine.status(c) ~= 'dead' do\n"
+        "    local clock = os.clock()\n"
+        "    local ok, ret = coroutine.resume(c)\n"
+        "    if not ok then error(ret) end\n"
+        "    maxslice = math.max(maxslice, os.clock() - clock)\n"
+        "    resumes = resumes + 1\n"
+        "    result = ret\n"
+        "    os.sleep(0.01)\n"
+        "end\n"
+        "\n"
+        "if #result ~= 10 then error('expected 10 files, got '..#result) end\n"
+        "if maxslice > 0.1 then error('resume blocked for '..maxslice..' seconds') end\n"
+        "if resumes < 3 then error('expected several resumes, got '..resumes) end\n"
+        "if batches < 2 then error('expected several batches, got '..batches) end\n"
+        ;
+
+        REQUIRE(lua.do_string(script, -1, &errmsg), [&]() {
+            puts(errmsg.c_str());
+        });
+    }
+
+    SECTION("Canceled")
+    {
+        // Canceling a coroutine cancels the task its asyncyield waits on,
+        // which stops the enumeration early.
+        static const char* script =
+        "local clock = os.clock()\n"
+        "local t = {}\n"
+        "local g, asyncyield = import_internal._makeasyncfileglobber('*')\n"
+        "os.sleep(0.12)\n"
+        "asyncyield:cancel()\n"
+        "while true do\n"
+        "    local more, wait = g:next(t)\n"
+        "    if not more then break end\n"
+        "    if wait then os.sleep(0.01) end\n"
+        "    if os.clock() - clock > 5 then error('enumeration did not stop') end\n"
+        "end\n"
+        "g:close()\n"
+        "\n"
+        "if #t >= 10 then error('expected enumeration to stop early') end\n"
+        ;
+
+        REQUIRE(lua.do_string(script, -1, &errmsg), [&]() {
+            puts(errmsg.c_str());
+        });
+    }
+}
@@ -121,4 +121,72 @@ TEST_CASE("Lua io")
             REQUIRE(verify_ret_true(lua, "truncate_file"));
         }
     }
+
+    SECTION("Line reader")
+    {
+        const char* script = "\
+            local name = 'lua_io_linereader.txt' \
+            local expected = {} \
+            \
+            local f = io.open(name, 'wb') \
+            for i = 1, 200 do \
+                local line = string.rep(string.char(65 + i % 26), i * 3) \
+                table.insert(expected, line) \
+                f:write(line, '\\n') \
+            end \
+            table.insert(expected, '') \
+            f:write('\\n') \
+            table.insert(expected, 'last line without newline') \
+            f:write('last line without newline') \
+            f:close() \
+            \
+            function read_lines() \
+                local f = io.open(name, 'rb') \
+                local i = 0 \
+                for line in io.linereader(f, 256):lines() do \
+                    i = i + 1 \
+                    if line ~= expected[i] then \
+                        f:close() \
+                        return false \
+                    end \
+                end \
+                f:close() \
+                return i == #expected \
+            end \
+            \
+            function read_chunks() \
+                local f = io.open(name, 'rb') \
+                local all = f:read('*a') \
+                f:seek('set', 0) \
+                local reader = io.linereader(f, 300) \
+                local chunks = {} \
+                while true do \
+                    local s = reader:read(97) \
+                    if not s then break end \
+                    if #s > 97 then return false end \
+                    table.insert(chunks, s) \
+                end \
+                f:close() \
+                return table.concat(chunks) == all \
+            end \
+            \
+            function read_closed() \
+                local f = io.open(name, 'rb') \
+                local iter = io.linereader(f, 256):lines() \
+                local first = iter() \
+                f:close() \
+                local n = 1 \
+                for _ in iter do n = n + 1 end \
+                return first == expected[1] and n < #expected \
+            end \
+        ";
+
+        REQUIRE_LUA_DO_STRING(lua, script);
+
+        // Lines longer than the buffer make it grow, and shorter lines make
+        // it compact.
+        REQUIRE(verify_ret_true(lua, "read_lines"));
+        REQUIRE(verify_ret_true(lua, "read_chunks"));
+        REQUIRE(verify_ret_true(lua, "read_closed"));
+    }
 }
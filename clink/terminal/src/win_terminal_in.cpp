@@ -19,6 +19,7 @@
 #include <core/settings.h>
 #include <core/debugheap.h>
 #include <core/log.h>
+#include <core/session_stats.h>
 
 #include <assert.h>
 #include <unordered_map>
@@ -1299,7 +1300,10 @@ void win_terminal_in::read_console(input_idle* callback, DWORD _timeout, bool pe
         else
         {
             if (process_record(record))
+            {
+                latency_key_received();
                 return;
+            }
         }
     }
 }
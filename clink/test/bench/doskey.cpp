@@ -0,0 +1,74 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch_bench.h"
+
+#include <core/settings.h>
+#include <core/str.h>
+#include <lib/doskey.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+BENCHMARK_CASE("doskey::resolve")
+{
+    // A realistic number of macros, some using $1-$9, $*, and $T.
+    clatch::bench::rng rng;
+    doskey doskey("clink_bench");
+    std::vector<str_moveable> names;
+    for (uint32 i = 0; i < 100; ++i)
+    {
+        str_moveable name;
+        rng.word(name, 2, 6);
+        name.format_append("%u", i);
+        str<> text;
+        rng.word(text, 2, 10);
+        switch (i % 4)
+        {
+        case 0:     text.concat(" $*"); break;
+        case 1:     text.concat(" $1 --x=$2 $3"); break;
+        case 2:     text.concat(" $* $T echo done"); break;
+        default:    break;
+        }
+        doskey.add_alias(name.c_str(), text.c_str());
+        names.emplace_back(std::move(name));
+    }
+
+    str<> hit;
+    hit << names[41] << " alpha beta \"gamma delta\"";
+    str<> multi;
+    multi << names[42] << " one two";
+    str<> miss("notanalias arg1 arg2");
+
+    auto measure_all = [&]() {
+        MEASURE("hit", [&]() {
+            doskey_alias alias;
+            doskey.resolve(hit.c_str(), alias);
+        });
+        MEASURE("hit, $T", [&]() {
+            doskey_alias alias;
+            doskey.resolve(multi.c_str(), alias);
+        });
+        MEASURE("miss", [&]() {
+            doskey_alias alias;
+            doskey.resolve(miss.c_str(), alias);
+        });
+    };
+
+    SECTION("plain")
+    {
+        settings::find("doskey.enhanced")->set("false");
+        measure_all();
+    }
+
+    SECTION("enhanced")
+    {
+        settings::find("doskey.enhanced")->set("true");
+        measure_all();
+    }
+
+    for (const auto& name : names)
+        doskey.remove_alias(name.c_str());
+    settings::find("doskey.enhanced")->set();
+}
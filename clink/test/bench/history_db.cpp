@@ -0,0 +1,94 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch_bench.h"
+
+#include "fs_fixture.h"
+
+#include <core/os.h>
+#include <core/path.h>
+#include <core/settings.h>
+#include <core/str.h>
+#include <lib/history_db.h>
+
+extern "C" {
+#include <readline/history.h>
+};
+
+#include <memory>
+
+//------------------------------------------------------------------------------
+static void make_line(clatch::bench::rng& rng, uint32 i, str_base& out)
+{
+    static const char* const c_commands[] = { "git", "dir", "cd", "npm", "cl.exe", "findstr" };
+    out.clear();
+    out.concat(c_commands[rng.range(0, sizeof_array(c_commands) - 1)]);
+    const uint32 args = rng.range(0, 6);
+    for (uint32 a = 0; a < args; ++a)
+    {
+        out.concat(" ");
+        if (rng.chance(30))
+            out.concat("--");
+        rng.word(out, 1, 16);
+    }
+    out.format_append(" %u", i);
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK_CASE("history_db")
+{
+    fs_fixture fs;
+
+    settings::find("history.shared")->set("false");
+    settings::find("history.dupe_mode")->set("add");
+
+    str<> path;
+    os::get_current_dir(path);
+    path::append(path, "clink_history");
+
+    clatch::bench::rng rng;
+    str<> line;
+
+    // Create a master history file.
+    {
+        history_db db(path.c_str(), 1, true/*use_master_bank*/);
+        db.initialise();
+        for (uint32 i = 0; i < 10000; ++i)
+        {
+            make_line(rng, i, line);
+            db.add(line.c_str());
+        }
+        db.compact(true/*force*/);
+    }
+
+    SECTION("load")
+    {
+        MEASURE("10000 lines", [&]() {
+            history_db db(path.c_str(), 2, true/*use_master_bank*/);
+            db.initialise();
+            db.load_rl_history(false/*can_clean*/);
+            clear_history();
+        });
+    }
+
+    SECTION("add")
+    {
+        std::unique_ptr<history_db> db;
+        uint32 i = 0;
+        MEASURE("line", [&]() {
+            make_line(rng, i++, line);
+            db->add(line.c_str());
+        }, [&]() {
+            if (!db)
+            {
+                db = std::make_unique<history_db>(path.c_str(), 3, true/*use_master_bank*/);
+                db->initialise();
+            }
+        });
+        db.reset();
+    }
+
+    settings::find("history.dupe_mode")->set();
+    settings::find("history.shared")->set();
+}
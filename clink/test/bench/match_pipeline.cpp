@@ -0,0 +1,55 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch_bench.h"
+
+#include <core/str.h>
+#include <lib/matches.h>
+#include <match_pipeline.h>
+#include <matches_impl.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+BENCHMARK_CASE("match_pipeline")
+{
+    // File-like matches with a few common prefixes, like a large directory.
+    clatch::bench::rng rng;
+    static const char* const c_prefixes[] = { "", "src", "test", "build_", "README" };
+    std::vector<str_moveable> names;
+    for (uint32 i = 0; i < 5000; ++i)
+    {
+        str_moveable name;
+        name.concat(c_prefixes[rng.range(0, sizeof_array(c_prefixes) - 1)]);
+        rng.word(name, 3, 20);
+        if (rng.chance(70))
+            name.concat(".cpp");
+        names.emplace_back(std::move(name));
+    }
+
+    matches_impl matches;
+    match_pipeline pipeline(matches);
+
+    auto fill = [&]() {
+        pipeline.reset();
+        match_builder builder(matches);
+        for (const auto& name : names)
+            builder.add_match(name.c_str(), match_type::file);
+    };
+
+    SECTION("select")
+    {
+        MEASURE("5000 matches, needle 'src'", [&]() { pipeline.select("src"); }, fill);
+        MEASURE("5000 matches, no needle", [&]() { pipeline.select(""); }, fill);
+    }
+
+    SECTION("sort")
+    {
+        auto fill_select = [&]() {
+            fill();
+            pipeline.select("");
+        };
+        MEASURE("5000 matches", [&]() { pipeline.sort(); }, fill_select);
+    }
+}
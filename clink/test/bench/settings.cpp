@@ -0,0 +1,94 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch_bench.h"
+
+#include "fs_fixture.h"
+
+#include <core/os.h>
+#include <core/path.h>
+#include <core/settings.h>
+#include <core/str.h>
+
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+BENCHMARK_CASE("settings::load")
+{
+    fs_fixture fs;
+
+    // 300 settings of mixed types, all set in the settings file, written in
+    // the same format as settings::save().
+    static const char* const c_colors[] = { "bold red", "bright yellow on blue", "underline cyan", "#ff8000", "sgr 38;5;200" };
+    clatch::bench::rng rng;
+    std::vector<std::unique_ptr<setting>> registered;
+    str_moveable content;
+    for (uint32 i = 0; i < 300; ++i)
+    {
+        str<> name;
+        str<> value;
+        name.format("bench.setting_%03u", i);
+        switch (i % 5)
+        {
+        case 0:
+        case 1:
+            registered.emplace_back(new setting_bool(name.c_str(), "Bench bool", false));
+            content.format_append("# name: Bench bool\n# type: boolean\n");
+            value = rng.chance(50) ? "True" : "False";
+            break;
+        case 2:
+            registered.emplace_back(new setting_int(name.c_str(), "Bench int", 0));
+            content.format_append("# name: Bench int\n# type: integer\n");
+            value.format("%u", rng.range(1, 10000));
+            break;
+        case 3:
+            registered.emplace_back(new setting_str(name.c_str(), "Bench string", ""));
+            content.format_append("# name: Bench string\n# type: string\n");
+            rng.word(value, 4, 40);
+            break;
+        default:
+            registered.emplace_back(new setting_color(name.c_str(), "Bench color", ""));
+            content.format_append("# name: Bench color\n# type: color\n");
+            value = c_colors[rng.range(0, sizeof_array(c_colors) - 1)];
+            break;
+        }
+        content.format_append("%s = %s\n\n", name.c_str(), value.c_str());
+    }
+
+    str<280> file;
+    str<280> snapshot;
+    os::get_current_dir(file);
+    path::append(file, "clink_settings");
+    snapshot = file.c_str();
+    snapshot.concat(".snapshot");
+
+    FILE* f = fopen(file.c_str(), "wb");
+    fputs(content.c_str(), f);
+    fclose(f);
+
+    SECTION("text")
+    {
+        // Disable the snapshot, so every load parses the text file.
+        os::unlink(snapshot.c_str());
+        os::set_env("CLINK_NO_SETTINGS_SNAPSHOT", "1");
+        MEASURE("300 settings", [&]() {
+            settings::load(file.c_str());
+        });
+        os::set_env("CLINK_NO_SETTINGS_SNAPSHOT", nullptr);
+    }
+
+    SECTION("snapshot")
+    {
+        // Snapshots are only written for files that weren't written very
+        // recently.
+        backdate_file(file.c_str(), 3600);
+        settings::load(file.c_str());
+        MEASURE("300 settings", [&]() {
+            settings::load(file.c_str());
+        });
+    }
+
+    settings::load(nullptr);
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch_bench.h"
+
+#include <core/str.h>
+#include <core/str_compare.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+BENCHMARK_CASE("str_compare")
+{
+    // Pairs of file-like names that share a prefix, some differing only by
+    // case or by '-' versus '_'.
+    clatch::bench::rng rng;
+    std::vector<str_moveable> lhs;
+    std::vector<str_moveable> rhs;
+    for (uint32 i = 0; i < 1000; ++i)
+    {
+        str_moveable a;
+        rng.word(a, 8, 40);
+        str_moveable b;
+        b.concat(a.c_str(), rng.range(0, a.length()));
+        for (char* p = b.data(); *p; ++p)
+        {
+            if (rng.chance(10))
+                *p = (*p == '-') ? '_' : char(toupper(uint8(*p)));
+        }
+        rng.word(b, 0, 8);
+        lhs.emplace_back(std::move(a));
+        rhs.emplace_back(std::move(b));
+    }
+
+    auto compare_all = [&]() {
+        int32 total = 0;
+        for (size_t i = 0; i < lhs.size(); ++i)
+            total += str_compare(lhs[i], rhs[i]);
+        return total;
+    };
+
+    SECTION("exact")
+    {
+        str_compare_scope _(str_compare_scope::exact, false);
+        MEASURE("1000 pairs", [&]() { compare_all(); });
+    }
+
+    SECTION("caseless")
+    {
+        str_compare_scope _(str_compare_scope::caseless, false);
+        MEASURE("1000 pairs", [&]() { compare_all(); });
+    }
+
+    SECTION("relaxed")
+    {
+        str_compare_scope _(str_compare_scope::relaxed, false);
+        MEASURE("1000 pairs", [&]() { compare_all(); });
+    }
+
+    SECTION("fuzzy accents")
+    {
+        str_compare_scope _(str_compare_scope::caseless, true);
+        MEASURE("1000 pairs", [&]() { compare_all(); });
+    }
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch_bench.h"
+
+#include <core/str.h>
+#include <terminal/ecma48_iter.h>
+#include <terminal/wcwidth.h>
+
+//------------------------------------------------------------------------------
+// Prompt-like text:  words with SGR color codes, an OSC title sequence, and
+// some non-ASCII and wide characters.
+static void make_text(str_base& out, bool with_codes)
+{
+    static const char* const c_extras[] = { "→", "λ", "日本語", "✔", "ÀΘЙ" };
+    clatch::bench::rng rng;
+    out.clear();
+    if (with_codes)
+        out.concat("\x1b]0;title\a");
+    for (uint32 i = 0; i < 400; ++i)
+    {
+        if (with_codes && rng.chance(30))
+            out.format_append("\x1b[%u;%um", rng.range(0, 1), rng.range(30, 37));
+        if (rng.chance(15))
+            out.concat(c_extras[rng.range(0, sizeof_array(c_extras) - 1)]);
+        else
+            rng.word(out, 1, 10);
+        out.concat(" ");
+    }
+    if (with_codes)
+        out.concat("\x1b[m");
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK_CASE("ecma48_iter")
+{
+    str<> text;
+    make_text(text, true);
+
+    MEASURE("prompt text", [&]() {
+        ecma48_state state;
+        ecma48_iter iter(text.c_str(), state, text.length());
+        uint32 n = 0;
+        while (const ecma48_code& code = iter.next())
+            n += code.get_length();
+    });
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK_CASE("wcwidth_iter")
+{
+    str<> text;
+    make_text(text, false);
+
+    MEASURE("prompt text", [&]() {
+        wcwidth_iter iter(text);
+        uint32 cols = 0;
+        while (iter.next())
+            cols += iter.character_wcwidth_onectrl();
+    });
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch_bench.h"
+
+#include <core/str.h>
+#include <lib/cmd_tokenisers.h>
+#include <lib/word_collector.h>
+
+//------------------------------------------------------------------------------
+// Command lines with quotes, carets, redirections, and multiple commands.
+static void make_line(clatch::bench::rng& rng, uint32 num_commands, str_base& out)
+{
+    static const char* const c_separators[] = { " & ", " && ", " | ", " || " };
+    out.clear();
+    for (uint32 c = 0; c < num_commands; ++c)
+    {
+        if (c)
+            out.concat(c_separators[rng.range(0, sizeof_array(c_separators) - 1)]);
+        rng.word(out, 2, 8);
+        const uint32 args = rng.range(1, 8);
+        for (uint32 a = 0; a < args; ++a)
+        {
+            out.concat(" ");
+            switch (rng.range(0, 5))
+            {
+            case 0:     out.concat("\""); rng.word(out, 1, 12); out.concat(" "); rng.word(out, 1, 12); out.concat("\""); break;
+            case 1:     out.concat("--"); rng.word(out, 2, 10); out.concat("="); rng.word(out, 1, 6); break;
+            case 2:     out.concat(">"); rng.word(out, 3, 10); break;
+            case 3:     rng.word(out, 1, 6); out.concat("^&"); rng.word(out, 1, 6); break;
+            default:    rng.word(out, 1, 16); break;
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK_CASE("word_collector::collect_words")
+{
+    cmd_command_tokeniser command_tokeniser;
+    cmd_word_tokeniser word_tokeniser;
+    word_collector collector(&command_tokeniser, &word_tokeniser, "\"");
+
+    clatch::bench::rng rng;
+    str<> short_line;
+    str<> long_line;
+    make_line(rng, 1, short_line);
+    make_line(rng, 12, long_line);
+
+    words words;
+    commands commands;
+
+    // Clear the cache so each sample measures tokenising the line.
+    SECTION("short")
+    {
+        MEASURE("whole_command", [&]() {
+            collector.clear_cache();
+            collector.collect_words(short_line.c_str(), short_line.length(), short_line.length(), words, collect_words_mode::whole_command, &commands);
+        });
+        MEASURE("stop_at_cursor", [&]() {
+            collector.clear_cache();
+            collector.collect_words(short_line.c_str(), short_line.length(), short_line.length(), words, collect_words_mode::stop_at_cursor, &commands);
+        });
+    }
+
+    SECTION("long")
+    {
+        MEASURE("whole_command", [&]() {
+            collector.clear_cache();
+            collector.collect_words(long_line.c_str(), long_line.length(), long_line.length(), words, collect_words_mode::whole_command, &commands);
+        });
+        MEASURE("stop_at_cursor", [&]() {
+            collector.clear_cache();
+            collector.collect_words(long_line.c_str(), long_line.length(), long_line.length(), words, collect_words_mode::stop_at_cursor, &commands);
+        });
+    }
+
+    // Repeated calls for the same line reuse the cached words.
+    SECTION("cached")
+    {
+        collector.collect_words(long_line.c_str(), long_line.length(), long_line.length(), words, collect_words_mode::whole_command, &commands);
+        MEASURE("whole_command", [&]() {
+            collector.collect_words(long_line.c_str(), long_line.length(), long_line.length(), words, collect_words_mode::whole_command, &commands);
+        });
+    }
+}
@@ -0,0 +1,73 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch_bench.h"
+
+#include <core/debugheap.h>
+
+#include <new>
+
+//------------------------------------------------------------------------------
+// Memory tracking builds already replace operator new, so use the tracked
+// allocation number there (which counts allocations on all threads, and not
+// bytes).  Otherwise count operator new on the current thread, but only while
+// benchmarks run; tests get a plain malloc/free.  Direct malloc calls aren't
+// counted either way.
+#ifdef USE_MEMORY_TRACKING
+
+namespace clatch {
+namespace bench {
+alloc_counts get_alloc_counts()
+{
+    return { uint64(dbggetallocnumber()), 0 };
+}
+void set_alloc_counting(bool enable)
+{
+}
+} // namespace bench
+} // namespace clatch
+
+#else // !USE_MEMORY_TRACKING
+
+static volatile bool s_alloc_counting = false;
+static thread_local clatch::bench::alloc_counts t_alloc_counts = {};
+
+//------------------------------------------------------------------------------
+// Replacing operator new means honoring its contract, so this throws on
+// failure instead of returning nullptr.  The nothrow forms call through to
+// this and catch the exception.
+static void* counted_alloc(size_t size)
+{
+    if (s_alloc_counting)
+    {
+        ++t_alloc_counts.count;
+        t_alloc_counts.bytes += size;
+    }
+    void* p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* __cdecl operator new(size_t size) { return counted_alloc(size); }
+void* __cdecl operator new[](size_t size) { return counted_alloc(size); }
+void __cdecl operator delete(void* p) noexcept { free(p); }
+void __cdecl operator delete[](void* p) noexcept { free(p); }
+void __cdecl operator delete(void* p, size_t) noexcept { free(p); }
+void __cdecl operator delete[](void* p, size_t) noexcept { free(p); }
+
+namespace clatch {
+namespace bench {
+alloc_counts get_alloc_counts()
+{
+    return t_alloc_counts;
+}
+void set_alloc_counting(bool enable)
+{
+    s_alloc_counting = enable;
+}
+} // namespace bench
+} // namespace clatch
+
+#endif // !USE_MEMORY_TRACKING
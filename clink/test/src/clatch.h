@@ -111,6 +111,27 @@ inline void list()
         puts(test->m_name);
 }
 
+//------------------------------------------------------------------------------
+// Runs func once for each leaf section, so every section gets visited.
+inline void run_sections(test::test_func* func, section& root, const char* name)
+{
+    section* tree_iter = &root;
+    do
+    {
+        section::scope x = section::scope(tree_iter, root, name);
+
+        (func)(tree_iter);
+
+        for (section* parent; parent = tree_iter->m_parent; tree_iter = parent)
+        {
+            tree_iter->m_active = false;
+            if (tree_iter = tree_iter->m_sibling)
+                break;
+        }
+    }
+    while (tree_iter != &root);
+}
+
 //------------------------------------------------------------------------------
 inline bool run(const char* prefix="", bool times=false)
 {
@@ -134,21 +155,7 @@ inline bool run(const char* prefix="", bool times=false)
 
         try
         {
-            section* tree_iter = &root;
-            do
-            {
-                section::scope x = section::scope(tree_iter, root, test->m_name);
-
-                (test->m_func)(tree_iter);
-
-                for (section* parent; parent = tree_iter->m_parent; tree_iter = parent)
-                {
-                    tree_iter->m_active = false;
-                    if (tree_iter = tree_iter->m_sibling)
-                        break;
-                }
-            }
-            while (tree_iter != &root);
+            run_sections(test->m_func, root, test->m_name);
         }
         catch (...)
         {
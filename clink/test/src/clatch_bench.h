@@ -0,0 +1,320 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "clatch.h"
+
+#include <core/str.h>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Benchmarks are registered with BENCHMARK_CASE() and can use SECTION() just
+// like tests.  They don't run with the tests; run them with `clink_test
+// --bench [prefix]`.  Each MEASURE() inside a benchmark is timed separately:
+//
+//      BENCHMARK_CASE("thing")
+//      {
+//          auto data = make_data();
+//          SECTION("small")
+//          {
+//              MEASURE("lookup", [&]() { lookup(data); });
+//          }
+//      }
+//
+// Each measurement runs warm-up passes, then takes a number of samples.  Fast
+// operations are batched so each sample is long enough to time accurately.
+// Results report the per-operation time percentiles and the allocations per
+// operation on the measuring thread.
+
+namespace clatch {
+namespace bench {
+
+//------------------------------------------------------------------------------
+struct options
+{
+    uint32          warmup = 3;
+    uint32          samples = 30;
+    double          min_sample_time = 0.002;    // Seconds.
+    const char*     json = nullptr;             // File to write results to.
+};
+
+//------------------------------------------------------------------------------
+struct result
+{
+    str_moveable    name;
+    uint32          samples = 0;
+    uint32          batch = 0;
+    double          min = 0;                    // Seconds per operation...
+    double          p50 = 0;
+    double          p90 = 0;
+    double          p99 = 0;
+    double          max = 0;
+    double          mean = 0;
+    double          allocs = 0;                 // Allocations per operation.
+    double          alloc_bytes = 0;            // Bytes allocated per operation.
+};
+
+//------------------------------------------------------------------------------
+// Counts allocations made by the current thread while counting is enabled,
+// which is only while benchmarks run.  See bench_alloc.cpp.
+struct alloc_counts
+{
+    uint64          count;
+    uint64          bytes;
+};
+alloc_counts get_alloc_counts();
+void set_alloc_counting(bool enable);
+
+//------------------------------------------------------------------------------
+struct bench_case
+{
+    static bench_case*& get_head() { static bench_case* head; return head; }
+    static bench_case*& get_tail() { static bench_case* tail; return tail; }
+    bench_case*         m_next = nullptr;
+    test::test_func*    m_func;
+    const char*         m_name;
+
+    bench_case(const char* name, test::test_func* func)
+    : m_func(func)
+    , m_name(name)
+    {
+        if (get_head() == nullptr)
+            get_head() = this;
+
+        if (bench_case* tail = get_tail())
+            tail->m_next = this;
+        get_tail() = this;
+    }
+};
+
+//------------------------------------------------------------------------------
+inline options& get_options() { static options s_options; return s_options; }
+inline std::vector<result>& get_results() { static std::vector<result> s_results; return s_results; }
+
+//------------------------------------------------------------------------------
+// Deterministic pseudo-random numbers (splitmix64), so synthetic data is the
+// same every run.
+class rng
+{
+public:
+                    rng(uint64 seed=0x2545f4914f6cdd1d) : m_state(seed) {}
+    uint64          next()
+                    {
+                        uint64 z = (m_state += 0x9e3779b97f4a7c15);
+                        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+                        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+                        return z ^ (z >> 31);
+                    }
+    uint32          range(uint32 lo, uint32 hi) { return lo + uint32(next() % (hi - lo + 1)); }
+    bool            chance(uint32 percent) { return range(0, 99) < percent; }
+
+    // Appends a word of lowercase letters, digits, and the occasional '-',
+    // '_', or '.'.
+    void            word(str_base& out, uint32 min_len, uint32 max_len)
+                    {
+                        static const char c_chars[] = "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz0123456789-_.";
+                        const uint32 len = range(min_len, max_len);
+                        for (uint32 i = 0; i < len; ++i)
+                        {
+                            const char c = c_chars[range(0, sizeof(c_chars) - 2)];
+                            out.concat(&c, 1);
+                        }
+                    }
+
+private:
+    uint64          m_state;
+};
+
+//------------------------------------------------------------------------------
+inline void get_section_path(str_base& out)
+{
+    std::vector<const char*> names;
+    for (section* s = section::get_outer_store(); s; s = s->m_parent)
+        names.push_back(s->m_name);
+
+    out.clear();
+    for (auto it = names.rbegin(); it != names.rend(); ++it)
+    {
+        if (!**it)
+            continue;
+        if (out.length())
+            out.concat("/");
+        out.concat(*it);
+    }
+}
+
+//------------------------------------------------------------------------------
+inline double percentile(const std::vector<double>& sorted, uint32 pct)
+{
+    const size_t index = (sorted.size() - 1) * pct / 100;
+    return sorted[index];
+}
+
+//------------------------------------------------------------------------------
+// Times func, batching calls when each call is too quick to time on its own.
+// If setup is provided, it runs before every call (outside the timing), and
+// calls are never batched.  With no warm-up passes, calls aren't batched
+// either, since there's no timing to size a batch from.
+inline void measure(const char* name, const std::function<void()>& func, const std::function<void()>& setup=nullptr)
+{
+    const options& opts = get_options();
+
+    // Warm up, and find how many calls make a sample long enough to time.
+    uint32 batch = 1;
+    double elapsed = 0;
+    for (uint32 i = 0; i < opts.warmup; ++i)
+    {
+        if (setup)
+            setup();
+        const double start = os::clock();
+        func();
+        elapsed = os::clock() - start;
+    }
+    if (!setup && opts.warmup && elapsed < opts.min_sample_time)
+        batch = uint32(min<double>(opts.min_sample_time / max<double>(elapsed, 1e-9), 1000000));
+
+    std::vector<double> times;
+    times.reserve(opts.samples);
+
+    alloc_counts allocs = {};
+    for (uint32 i = 0; i < opts.samples; ++i)
+    {
+        if (setup)
+            setup();
+
+        const alloc_counts before = get_alloc_counts();
+        const double start = os::clock();
+        for (uint32 j = 0; j < batch; ++j)
+            func();
+        const double end = os::clock();
+        const alloc_counts after = get_alloc_counts();
+
+        times.push_back((end - start) / batch);
+        allocs.count += after.count - before.count;
+        allocs.bytes += after.bytes - before.bytes;
+    }
+
+    std::sort(times.begin(), times.end());
+
+    result r;
+    get_section_path(r.name);
+    r.name.concat("/");
+    r.name.concat(name);
+    r.samples = opts.samples;
+    r.batch = batch;
+    r.min = times.front();
+    r.p50 = percentile(times, 50);
+    r.p90 = percentile(times, 90);
+    r.p99 = percentile(times, 99);
+    r.max = times.back();
+    for (double t : times)
+        r.mean += t;
+    r.mean /= times.size();
+    const double ops = double(opts.samples) * batch;
+    r.allocs = double(allocs.count) / ops;
+    r.alloc_bytes = double(allocs.bytes) / ops;
+
+    printf("  %-52s %10.3f us p50 %10.3f us p99 %8.1f allocs\n",
+           r.name.c_str(), r.p50 * 1e6, r.p99 * 1e6, r.allocs);
+
+    get_results().emplace_back(std::move(r));
+}
+
+//------------------------------------------------------------------------------
+inline void write_json_string(FILE* f, const char* s)
+{
+    fputc('"', f);
+    for (; *s; ++s)
+    {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', f);
+        if (uint8(*s) < 0x20)
+            fprintf(f, "\\u%04x", uint8(*s));
+        else
+            fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+//------------------------------------------------------------------------------
+inline bool write_json(const char* file)
+{
+    FILE* f = fopen(file, "w");
+    if (!f)
+        return false;
+
+    fprintf(f, "{\n  \"warmup\": %u,\n  \"samples\": %u,\n  \"results\": [", get_options().warmup, get_options().samples);
+
+    bool first = true;
+    for (const auto& r : get_results())
+    {
+        fprintf(f, "%s\n    {\n      \"name\": ", first ? "" : ",");
+        write_json_string(f, r.name.c_str());
+        fprintf(f, ",\n      \"samples\": %u,\n      \"batch\": %u,\n", r.samples, r.batch);
+        fprintf(f, "      \"ns\": { \"min\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f, \"mean\": %.1f },\n",
+                r.min * 1e9, r.p50 * 1e9, r.p90 * 1e9, r.p99 * 1e9, r.max * 1e9, r.mean * 1e9);
+        fprintf(f, "      \"allocs\": %.2f,\n      \"alloc_bytes\": %.1f\n    }", r.allocs, r.alloc_bytes);
+        first = false;
+    }
+
+    fprintf(f, "\n  ]\n}\n");
+    fclose(f);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+inline bool run(const char* prefix="")
+{
+    get_results().clear();
+    set_alloc_counting(true);
+
+    int32 fail_count = 0;
+    for (bench_case* bench = bench_case::get_head(); bench != nullptr; bench = bench->m_next)
+    {
+        // Cheap lower-case prefix test.
+        const char* a = prefix, *b = bench->m_name;
+        for (; *a && (*a & ~0x20) == (*b & ~0x20); ++a, ++b);
+        if (*a)
+            continue;
+
+        printf("%s\n", bench->m_name);
+
+        section root;
+        try
+        {
+            run_sections(bench->m_func, root, bench->m_name);
+        }
+        catch (...)
+        {
+            ++fail_count;
+        }
+    }
+
+    set_alloc_counting(false);
+
+    const char* json = get_options().json;
+    if (json && !write_json(json))
+    {
+        printf("%sunable to write '%s'%s\n", colors::get_error(), json, colors::get_normal());
+        ++fail_count;
+    }
+
+    printf("\n benchmarks:%u  failed:%d\n", uint32(get_results().size()), fail_count);
+    return (fail_count == 0);
+}
+
+} // namespace bench
+} // namespace clatch
+
+//------------------------------------------------------------------------------
+#define BENCHMARK_CASE(name)\
+    static void CLATCH_IDENT(bench_func)(clatch::section*&);\
+    static clatch::bench::bench_case CLATCH_IDENT(bench)(name, CLATCH_IDENT(bench_func));\
+    static void CLATCH_IDENT(bench_func)(clatch::section*& _clatch_tree_iter)
+
+#define MEASURE(name, ...)\
+    clatch::bench::measure(name, ##__VA_ARGS__)
@@ -110,3 +110,22 @@ const char* fs_fixture::get_root() const
 {
     return m_root.c_str();
 }
+
+//------------------------------------------------------------------------------
+bool backdate_file(const char* file, uint32 seconds)
+{
+    wstr<280> wfile(file);
+    HANDLE h = CreateFileW(wfile.c_str(), FILE_WRITE_ATTRIBUTES, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    ULARGE_INTEGER time = { ft.dwLowDateTime, ft.dwHighDateTime };
+    time.QuadPart -= uint64(seconds) * 10000000;
+    ft.dwLowDateTime = time.LowPart;
+    ft.dwHighDateTime = time.HighPart;
+    const bool ok = !!SetFileTime(h, nullptr, nullptr, &ft);
+    CloseHandle(h);
+    return ok;
+}
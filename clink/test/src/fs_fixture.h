@@ -18,3 +18,7 @@ private:
     str<>           m_root;
     const char**    m_fs;
 };
+
+//------------------------------------------------------------------------------
+// Sets a file's last write time to the given number of seconds ago.
+bool backdate_file(const char* file, uint32 seconds);
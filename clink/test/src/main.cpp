@@ -2,6 +2,7 @@
 // License: http://opensource.org/licenses/MIT
 
 #include "pch.h"
+#include "clatch_bench.h"
 
 #include <core/str.h>
 #include <core/settings.h>
@@ -82,6 +83,7 @@ int32 main(int32 argc, char** argv)
 
     bool list = false;
     bool times = false;
+    bool bench = false;
     int32 d_flag = 0;
 
     while (argc > 0)
@@ -92,7 +94,13 @@ int32 main(int32 argc, char** argv)
                  "  -?        Show this help.\n"
                  "  -d        Load Lua debugger.\n"
                  "  -dd       Force break on Lua errors.\n"
-                 "  -t        Show individual test times.");
+                 "  -t        Show individual test times.\n"
+                 "\n"
+                 "  --bench         Run benchmarks instead of tests.\n"
+                 "  --json file     Write benchmark results to file as JSON.\n"
+                 "  --samples n     Samples per benchmark measurement (default 30).\n"
+                 "  --warmup n      Warm-up passes per benchmark measurement (default 3).\n"
+                 "                  0 skips warm-up and times each call separately.");
             return 1;
         }
         else if (!strcmp(argv[0], "-d"))
@@ -114,6 +122,25 @@ int32 main(int32 argc, char** argv)
         {
             list = true;
         }
+        else if (!strcmp(argv[0], "--bench"))
+        {
+            bench = true;
+        }
+        else if (argc > 1 && !strcmp(argv[0], "--json"))
+        {
+            clatch::bench::get_options().json = argv[1];
+            argc--, argv++;
+        }
+        else if (argc > 1 && !strcmp(argv[0], "--samples"))
+        {
+            clatch::bench::get_options().samples = max<uint32>(atoi(argv[1]), 1);
+            argc--, argv++;
+        }
+        else if (argc > 1 && !strcmp(argv[0], "--warmup"))
+        {
+            clatch::bench::get_options().warmup = max<int32>(atoi(argv[1]), 0);
+            argc--, argv++;
+        }
         else if (!strcmp(argv[0], "--"))
         {
         }
@@ -142,7 +169,11 @@ int32 main(int32 argc, char** argv)
     clatch::colors::initialize();
 
     const char* prefix = (argc > 0) ? argv[0] : "";
-    int32 result = (clatch::run(prefix, times) != true);
+    int32 result;
+    if (bench)
+        result = (clatch::bench::run(prefix) != true);
+    else
+        result = (clatch::run(prefix, times) != true);
 
     shutdown_recognizer();
     shutdown_task_manager(true/*final*/);
@@ -3,6 +3,9 @@
 
 #include "pch.h"
 #include "test_terminals.h"
+
+#include <core/session_stats.h>
+
 #include <assert.h>
 
 class input_idle;
@@ -42,6 +45,7 @@ int32 test_terminal_in::read()
     if (m_head >= m_queue.size())
         return terminal_in::input_none;
     const int32 c = m_queue[m_head++];
+    latency_key_received();
     return c;
 }
 